@@ -0,0 +1,405 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL2_BENCHMARKS_BENCH_HPP
+#define SOL2_BENCHMARKS_BENCH_HPP
+
+#include <sol/sol.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/perf_event.h>)
+#define SOL2_BENCHMARKS_PERF_EVENTS 1
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+namespace bench {
+
+	using clock = std::chrono::steady_clock;
+
+	inline double microseconds_since(clock::time_point start) {
+		return std::chrono::duration<double, std::micro>(clock::now() - start).count();
+	}
+
+	inline double seconds_since(clock::time_point start) {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	// --name=value and --flag arguments; anything else is ignored
+	class options {
+	private:
+		std::unordered_map<std::string, std::string> m_values;
+
+	public:
+		options(int argc, char* argv[]) {
+			for (int i = 1; i < argc; ++i) {
+				const char* arg = argv[i];
+				if (std::strncmp(arg, "--", 2) != 0) {
+					continue;
+				}
+				arg += 2;
+				const char* equals = std::strchr(arg, '=');
+				if (equals == nullptr) {
+					m_values[arg] = "1";
+				}
+				else {
+					m_values[std::string(arg, equals)] = std::string(equals + 1);
+				}
+			}
+		}
+
+		double number(const std::string& name, double default_value) const {
+			auto it = m_values.find(name);
+			return it == m_values.cend() ? default_value : std::strtod(it->second.c_str(), nullptr);
+		}
+
+		std::string text(const std::string& name, const std::string& default_value) const {
+			auto it = m_values.find(name);
+			return it == m_values.cend() ? default_value : it->second;
+		}
+
+		bool flag(const std::string& name) const {
+			auto it = m_values.find(name);
+			return it != m_values.cend() && it->second != "0";
+		}
+	};
+
+	class samples {
+	private:
+		std::vector<double> m_values;
+
+	public:
+		void add(double value) {
+			m_values.push_back(value);
+		}
+
+		void append(const samples& other) {
+			m_values.insert(m_values.end(), other.m_values.cbegin(), other.m_values.cend());
+		}
+
+		void clear() {
+			m_values.clear();
+		}
+
+		std::size_t size() const {
+			return m_values.size();
+		}
+
+		// nearest-rank percentile, p in [0, 100]
+		double percentile(double p) const {
+			if (m_values.empty()) {
+				return 0.0;
+			}
+			std::vector<double> sorted = m_values;
+			std::size_t rank = static_cast<std::size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+			std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(rank), sorted.end());
+			return sorted[rank];
+		}
+
+		double max() const {
+			return m_values.empty() ? 0.0 : *std::max_element(m_values.cbegin(), m_values.cend());
+		}
+
+		double mean() const {
+			if (m_values.empty()) {
+				return 0.0;
+			}
+			double total = 0.0;
+			for (double value : m_values) {
+				total += value;
+			}
+			return total / static_cast<double>(m_values.size());
+		}
+	};
+
+	inline void print_percentiles(std::ostream& out, const std::string& name, const samples& values, const char* unit) {
+		out << std::fixed << std::setprecision(2) << name << " (" << unit << ", " << values.size() << " samples): mean " << values.mean()
+		    << "  p50 " << values.percentile(50) << "  p90 " << values.percentile(90) << "  p99 " << values.percentile(99) << "  p99.9 "
+		    << values.percentile(99.9) << "  max " << values.max() << '\n';
+	}
+
+	// a lua_Alloc that counts what the state asks for
+	struct counting_allocator {
+		std::size_t allocations = 0;
+		std::size_t reallocations = 0;
+		std::size_t frees = 0;
+		std::size_t allocated_bytes = 0;
+
+		static void* allocate(void* user_data, void* ptr, std::size_t old_size, std::size_t new_size) {
+			counting_allocator& self = *static_cast<counting_allocator*>(user_data);
+			if (new_size == 0) {
+				if (ptr != nullptr) {
+					++self.frees;
+				}
+				std::free(ptr);
+				return nullptr;
+			}
+			if (ptr == nullptr) {
+				++self.allocations;
+				self.allocated_bytes += new_size;
+			}
+			else {
+				++self.reallocations;
+				if (new_size > old_size) {
+					self.allocated_bytes += new_size - old_size;
+				}
+			}
+			return std::realloc(ptr, new_size);
+		}
+	};
+
+	// references held in the registry: slots luaL_unref released (and the ones Lua reserves)
+	// stay in the table, so counting its entries would only ever show the high-water mark
+	inline std::size_t registry_size(lua_State* L) {
+		return sol::detail::registry_references(L);
+	}
+
+	// hardware counters for the calling thread, through perf_event_open on Linux;
+	// each counter is opened on its own, so one the machine lacks (or a VM or container hides)
+	// reads as unavailable without taking the others down with it
+	class counters {
+	public:
+		enum event : std::size_t { instructions, cycles, branch_misses, l1d_misses, llc_misses, event_count };
+
+		struct values {
+			double counts[event_count] = {};
+			bool available[event_count] = {};
+		};
+
+		static const char* name(std::size_t which) {
+			static const char* const names[event_count] = { "insns", "cycles", "br-miss", "L1d-miss", "LLC-miss" };
+			return names[which];
+		}
+
+	private:
+		int m_fds[event_count];
+
+#if defined(SOL2_BENCHMARKS_PERF_EVENTS)
+		static int open_event(std::uint32_t type, std::uint64_t config) {
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = type;
+			attr.config = config;
+			attr.disabled = 1;
+			// user space only: that is what the bindings cost, and it works at perf_event_paranoid=2
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			long fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+			return static_cast<int>(fd);
+		}
+
+		static std::uint64_t cache_event(std::uint64_t cache) {
+			return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		}
+#endif
+
+	public:
+		explicit counters(bool enabled = true) {
+			for (int& fd : m_fds) {
+				fd = -1;
+			}
+#if defined(SOL2_BENCHMARKS_PERF_EVENTS)
+			if (!enabled) {
+				return;
+			}
+			m_fds[instructions] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+			m_fds[cycles] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+			m_fds[branch_misses] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+			m_fds[l1d_misses] = open_event(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D));
+			m_fds[llc_misses] = open_event(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL));
+#else
+			(void)enabled;
+#endif
+		}
+
+		counters(const counters&) = delete;
+		counters& operator=(const counters&) = delete;
+
+		~counters() {
+#if defined(SOL2_BENCHMARKS_PERF_EVENTS)
+			for (int fd : m_fds) {
+				if (fd >= 0) {
+					close(fd);
+				}
+			}
+#endif
+		}
+
+		bool available(std::size_t which) const {
+			return m_fds[which] >= 0;
+		}
+
+		bool any_available() const {
+			for (std::size_t i = 0; i < event_count; ++i) {
+				if (available(i)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void start() {
+#if defined(SOL2_BENCHMARKS_PERF_EVENTS)
+			for (int fd : m_fds) {
+				if (fd >= 0) {
+					ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+					ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+				}
+			}
+#endif
+		}
+
+		// counts since start(), scaled up when the kernel had to multiplex a counter
+		values stop() {
+			values result;
+#if defined(SOL2_BENCHMARKS_PERF_EVENTS)
+			for (std::size_t i = 0; i < event_count; ++i) {
+				int fd = m_fds[i];
+				if (fd < 0) {
+					continue;
+				}
+				ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+				std::uint64_t data[3] = {};
+				if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+					continue;
+				}
+				result.counts[i] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+				result.available[i] = true;
+			}
+#endif
+			return result;
+		}
+	};
+
+	// runs named benchmarks a fixed number of operations at a time and reports
+	// nanoseconds and hardware counters per operation, one line per benchmark
+	//   --repetitions=<n>   timed runs per benchmark; the median is reported (default 5)
+	//   --scale=<x>         multiplies every benchmark's operation count (default 1)
+	//   --filter=<text>     only run benchmarks whose name contains text
+	//   --no-counters       time only, even where counters are available
+	class runner {
+	private:
+		std::ostream& m_out;
+		std::size_t m_repetitions;
+		double m_scale;
+		std::string m_filter;
+		counters m_counters;
+		bool m_header_printed;
+
+		void print_header() {
+			m_out << std::left << std::setw(36) << "benchmark" << std::right << std::setw(12) << "ns/op";
+			for (std::size_t i = 0; i < counters::event_count; ++i) {
+				m_out << std::setw(13) << (std::string(counters::name(i)) + "/op");
+			}
+			m_out << std::setw(8) << "IPC" << '\n';
+			m_header_printed = true;
+		}
+
+	public:
+		runner(std::ostream& out, const options& opts)
+		: m_out(out)
+		, m_repetitions(static_cast<std::size_t>((std::max)(1.0, opts.number("repetitions", 5))))
+		, m_scale(opts.number("scale", 1.0))
+		, m_filter(opts.text("filter", ""))
+		, m_counters(!opts.flag("no-counters"))
+		, m_header_printed(false) {
+		}
+
+		const counters& hardware() const {
+			return m_counters;
+		}
+
+		// fn is called calls times and performs ops_per_call operations each time;
+		// the per-operation figures come from the median repetition by time, counters included
+		template <typename Fn>
+		void run(const std::string& name, std::size_t calls, Fn&& fn, std::size_t ops_per_call = 1) {
+			if (!m_filter.empty() && name.find(m_filter) == std::string::npos) {
+				return;
+			}
+			const std::size_t ops = (std::max)(std::size_t(1), static_cast<std::size_t>(static_cast<double>(calls) * m_scale));
+			for (std::size_t i = 0; i < ops / 10 + 1; ++i) {
+				fn();
+			}
+			std::vector<std::pair<double, counters::values>> runs;
+			runs.reserve(m_repetitions);
+			for (std::size_t repetition = 0; repetition < m_repetitions; ++repetition) {
+				m_counters.start();
+				clock::time_point start = clock::now();
+				for (std::size_t i = 0; i < ops; ++i) {
+					fn();
+				}
+				double nanoseconds = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+				runs.emplace_back(nanoseconds, m_counters.stop());
+			}
+			std::nth_element(runs.begin(), runs.begin() + static_cast<std::ptrdiff_t>(runs.size() / 2), runs.end(),
+			     [](const auto& left, const auto& right) { return left.first < right.first; });
+			const std::pair<double, counters::values>& median = runs[runs.size() / 2];
+			const double per_op = 1.0 / static_cast<double>(ops * ops_per_call);
+
+			if (!m_header_printed) {
+				print_header();
+			}
+			m_out << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2) << std::setw(12)
+			      << median.first * per_op;
+			for (std::size_t i = 0; i < counters::event_count; ++i) {
+				m_out << std::setw(13);
+				if (median.second.available[i]) {
+					m_out << median.second.counts[i] * per_op;
+				}
+				else {
+					m_out << "-";
+				}
+			}
+			m_out << std::setw(8);
+			if (median.second.available[counters::instructions] && median.second.available[counters::cycles]
+			     && median.second.counts[counters::cycles] > 0) {
+				m_out << median.second.counts[counters::instructions] / median.second.counts[counters::cycles];
+			}
+			else {
+				m_out << "-";
+			}
+			m_out << '\n';
+		}
+	};
+
+} // namespace bench
+
+#endif // SOL2_BENCHMARKS_BENCH_HPP
@@ -0,0 +1,239 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Binding microbenchmarks: the hot paths between Lua and C++, each reported
+// as nanoseconds and hardware counters per operation (see bench::runner).
+// Lua-side benchmarks run their operation in a loop inside one chunk call,
+// so the figures are for the binding and not for entering Lua.
+//
+//   --repetitions=<n>  --scale=<x>  --filter=<text>  --no-counters
+
+#include "bench.hpp"
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace {
+	struct vec {
+		double x = 0.0;
+		double y = 0.0;
+
+		double length_squared() const {
+			return x * x + y * y;
+		}
+
+		void add(double value) {
+			x += value;
+		}
+	};
+
+	struct alignas(64) particle {
+		float position[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		float velocity[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+	};
+
+	// one of many distinct bound types, for the cost of bringing up a state
+	template <std::size_t N>
+	struct bound {
+		double x = 0.0;
+		double y = 0.0;
+
+		double sum() const {
+			return x + y;
+		}
+	};
+
+	template <std::size_t N>
+	void bind(sol::usertype<bound<N>>& ut) {
+		ut["x"] = &bound<N>::x;
+		ut["y"] = &bound<N>::y;
+		ut["sum"] = &bound<N>::sum;
+	}
+
+	template <std::size_t N>
+	void register_one(sol::state& lua) {
+		sol::usertype<bound<N>> ut = lua.new_usertype<bound<N>>("bound" + std::to_string(N));
+		bind<N>(ut);
+	}
+
+	template <std::size_t... N>
+	void register_all(sol::state& lua, std::index_sequence<N...>) {
+		(register_one<N>(lua), ...);
+	}
+
+	template <std::size_t... N>
+	void declare_all(sol::state& lua, std::index_sequence<N...>) {
+		(lua.declare_usertype<bound<N>>("bound" + std::to_string(N), &bind<N>), ...);
+	}
+
+	template <std::size_t... N>
+	void register_all_static(sol::state& lua, std::index_sequence<N...>) {
+		(lua.new_static_usertype<bound<N>>("bound" + std::to_string(N)), ...);
+	}
+
+	constexpr std::size_t bound_types = 64;
+
+	// vec again, with its members in a compile-time table
+	struct static_vec {
+		double x = 0.0;
+		double y = 0.0;
+
+		double length_squared() const {
+			return x * x + y * y;
+		}
+	};
+
+	double add_one(double value) {
+		return value + 1.0;
+	}
+
+	const char* const kind_names[] = { "player", "monster", "projectile", "pickup" };
+	const std::string long_status = "status: waiting for the server to acknowledge the pending transaction";
+
+	constexpr std::size_t lua_batch = 1000;
+} // namespace
+
+template <>
+struct sol::static_usertype<static_vec> {
+	static constexpr auto members = sol::static_members(sol::static_member { "x", &static_vec::x },
+	     sol::static_member { "y", &static_vec::y },
+	     sol::static_member { "length_squared", &static_vec::length_squared });
+};
+
+template <std::size_t N>
+struct sol::static_usertype<bound<N>> {
+	static constexpr auto members = sol::static_members(
+	     sol::static_member { "x", &bound<N>::x }, sol::static_member { "y", &bound<N>::y }, sol::static_member { "sum", &bound<N>::sum });
+};
+
+int main(int argc, char* argv[]) {
+	bench::options opts(argc, argv);
+	bench::runner runner(std::cout, opts);
+	if (!opts.flag("no-counters") && !runner.hardware().any_available()) {
+		std::cerr << "hardware counters unavailable (perf_event_open denied or unsupported): reporting time only\n";
+	}
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<vec>("vec", "x", &vec::x, "y", &vec::y, "length_squared", &vec::length_squared, "add", &vec::add);
+	lua.set_function("add_one", &add_one);
+	lua.set_function("kind_name", [](int i) { return kind_names[i & 3]; });
+	lua.set_function("kind_name_interned", [](int i) { return sol::interned(kind_names[i & 3]); });
+	lua.set_function("status", []() -> const std::string& { return long_status; });
+	lua.set_function("status_interned", []() { return sol::interned(sol::string_view(long_status)); });
+	lua.new_static_usertype<static_vec>("static_vec");
+	vec v;
+	static_vec sv;
+	lua["v"] = &v;
+	lua["sv"] = &sv;
+	lua["t"] = lua.create_table_with("x", 1.0);
+
+	auto lua_loop = [&lua](const std::string& body) {
+		return lua.load("local n = ... local r = 0 for i = 1, n do " + body + " end return r").get<sol::protected_function>();
+	};
+	sol::protected_function free_call = lua_loop("r = add_one(i)");
+	sol::protected_function member_get = lua_loop("r = v.x");
+	sol::protected_function member_set = lua_loop("v.x = i");
+	sol::protected_function method_call = lua_loop("r = v:length_squared()");
+	sol::protected_function method_void = lua_loop("v:add(1)");
+	sol::protected_function static_get = lua_loop("r = sv.x");
+	sol::protected_function static_method = lua_loop("r = sv:length_squared()");
+	sol::protected_function table_get = lua_loop("r = t.x");
+	sol::protected_function short_string = lua_loop("r = #kind_name(i)");
+	sol::protected_function short_interned = lua_loop("r = #kind_name_interned(i)");
+	sol::protected_function long_string = lua_loop("r = #status()");
+	sol::protected_function long_interned = lua_loop("r = #status_interned()");
+
+	double sink = 0.0;
+	runner.run("lua: free function call", 200, [&]() { sink += free_call(lua_batch).get<double>(); }, lua_batch);
+	runner.run("lua: usertype member get", 200, [&]() { sink += member_get(lua_batch).get<double>(); }, lua_batch);
+	runner.run("lua: usertype member set", 200, [&]() { member_set(lua_batch); }, lua_batch);
+	runner.run("lua: usertype method call", 200, [&]() { sink += method_call(lua_batch).get<double>(); }, lua_batch);
+	runner.run("lua: usertype void method call", 200, [&]() { method_void(lua_batch); }, lua_batch);
+	runner.run("lua: static usertype member get", 200, [&]() { sink += static_get(lua_batch).get<double>(); }, lua_batch);
+	runner.run("lua: static usertype method call", 200, [&]() { sink += static_method(lua_batch).get<double>(); }, lua_batch);
+	runner.run("lua: plain table get (baseline)", 200, [&]() { sink += table_get(lua_batch).get<double>(); }, lua_batch);
+	runner.run("lua: return short string", 200, [&]() { sink += short_string(lua_batch).get<double>(); }, lua_batch);
+	runner.run("lua: return short string, interned", 200, [&]() { sink += short_interned(lua_batch).get<double>(); }, lua_batch);
+	runner.run("lua: return long string", 200, [&]() { sink += long_string(lua_batch).get<double>(); }, lua_batch);
+	runner.run("lua: return long string, interned", 200, [&]() { sink += long_interned(lua_batch).get<double>(); }, lua_batch);
+
+	sol::function lua_add = lua.load("return function (x) return x + 1 end").get<sol::function>()();
+	sol::protected_function lua_add_protected = lua_add;
+	sol::table t = lua["t"];
+	runner.run("c++: lua function call", 200000, [&]() { sink += lua_add.call<double>(1.0); });
+	runner.run("c++: lua protected function call", 200000, [&]() { sink += lua_add_protected(1.0).get<double>(); });
+	runner.run("c++: table get", 200000, [&]() { sink += t.get<double>("x"); });
+	runner.run("c++: table set", 200000, [&]() { t.set("x", 2.0); });
+	runner.run("c++: global usertype get", 200000, [&]() { sink += lua.get<vec&>("v").x; });
+	runner.run("c++: push and check usertype", 200000, [&]() {
+		lua_State* L = lua.lua_state();
+		sol::stack::push(L, &v);
+		sink += sol::stack::check<vec>(L, -1, &sol::no_panic) ? 1.0 : 0.0;
+		lua_pop(L, 1);
+	});
+	const std::string member_names[] = { "x", "y", "length_squared", "missing" };
+	std::size_t member_name = 0;
+	runner.run("c++: static member lookup by name", 200000, [&]() {
+		sink += static_cast<double>(sol::static_member_table<static_vec>::find(member_names[member_name++ & 3]));
+	});
+
+	// over-aligned values: worst-case padding and fix-up on a plain state, exact layout on an aligned one
+	sol::aligned_allocator allocator(64);
+	sol::state aligned_lua(sol::default_at_panic, &sol::aligned_allocator::allocate, &allocator);
+	lua.new_usertype<particle>("particle");
+	aligned_lua.new_usertype<particle>("particle");
+	auto push_particles = [&sink](lua_State* L) {
+		for (std::size_t i = 0; i < lua_batch; ++i) {
+			sol::stack::push(L, particle());
+			lua_pop(L, 1);
+		}
+		sink += 1.0;
+	};
+	runner.run("c++: push over-aligned usertype", 200, [&]() { push_particles(lua.lua_state()); }, lua_batch);
+	runner.run("c++: push over-aligned usertype, aligned allocator", 200, [&]() { push_particles(aligned_lua.lua_state()); }, lua_batch);
+
+	// a new state that binds many types, with one script that uses two of them
+	enum class binding { registered, declared, static_members };
+	auto start_state = [&sink](binding how) {
+		sol::state state;
+		switch (how) {
+		case binding::registered:
+			register_all(state, std::make_index_sequence<bound_types>());
+			break;
+		case binding::declared:
+			declare_all(state, std::make_index_sequence<bound_types>());
+			break;
+		case binding::static_members:
+			register_all_static(state, std::make_index_sequence<bound_types>());
+			break;
+		}
+		sink += state.script("return bound3.new():sum() + bound40.new():sum() + 1").get<double>();
+	};
+	runner.run("state: start, 64 types registered", 20, [&]() { start_state(binding::registered); });
+	runner.run("state: start, 64 types declared", 20, [&]() { start_state(binding::declared); });
+	runner.run("state: start, 64 types static", 20, [&]() { start_state(binding::static_members); });
+
+	return sink == 0.0 ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Compatibility-layer microbenchmarks: the 5.3-style calls sol2 makes on every
+// Lua, which Lua 5.1 and LuaJIT only get through the compat shims, plus the
+// sol2 paths built on top of them (integer keys, number checks, as_table).
+// Build against LuaJIT (SOL2_LUA_VERSION=LuaJIT) and against a 5.3/5.4 to
+// see what the shims cost next to the native calls.
+//
+//   --repetitions=<n>  --scale=<x>  --filter=<text>  --no-counters
+
+#include "bench.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+	constexpr std::size_t lua_batch = 1000;
+	constexpr std::size_t sequence_size = 64;
+
+	int takes_int(int value) {
+		return value + 1;
+	}
+
+	int takes_optional(sol::optional<int> value) {
+		return value ? *value : 0;
+	}
+} // namespace
+
+int main(int argc, char* argv[]) {
+	bench::options opts(argc, argv);
+	bench::runner runner(std::cout, opts);
+	if (!opts.flag("no-counters") && !runner.hardware().any_available()) {
+		std::cerr << "hardware counters unavailable (perf_event_open denied or unsupported): reporting time only\n";
+	}
+	std::cout << LUA_RELEASE
+#if SOL_IS_ON(SOL_USE_LUAJIT)
+	          << " (" << LUAJIT_VERSION << ")"
+#endif
+	          << "\n";
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua_State* L = lua.lua_state();
+	double sink = 0.0;
+
+	// the shims themselves
+	lua_pushinteger(L, 1);
+	lua_pushinteger(L, 2);
+	lua_pushinteger(L, 3);
+	runner.run("shim: lua_rotate by one", 200000, [&]() { lua_rotate(L, -3, 1); });
+	runner.run("shim: lua_rotate back by one", 200000, [&]() { lua_rotate(L, -3, -1); });
+	runner.run("shim: lua_copy", 200000, [&]() { lua_copy(L, -1, -3); });
+	runner.run("shim: lua_isinteger", 200000, [&]() { sink += lua_isinteger(L, -2); });
+	runner.run("shim: lua_tonumberx", 200000, [&]() {
+		int isnum = 0;
+		sink += lua_tonumberx(L, -2, &isnum) + isnum;
+	});
+	runner.run("shim: lua_tointegerx", 200000, [&]() {
+		int isnum = 0;
+		sink += static_cast<double>(lua_tointegerx(L, -2, &isnum) + isnum);
+	});
+	lua_pop(L, 3);
+	lua_createtable(L, static_cast<int>(sequence_size), 0);
+	for (std::size_t i = 1; i <= sequence_size; ++i) {
+		lua_pushinteger(L, static_cast<lua_Integer>(i));
+		lua_rawseti(L, -2, static_cast<int>(i));
+	}
+	runner.run("shim: lua_geti", 200000, [&]() {
+		sink += lua_geti(L, -1, 7);
+		lua_pop(L, 1);
+	});
+	runner.run("shim: lua_seti", 200000, [&]() {
+		lua_pushinteger(L, 7);
+		lua_seti(L, -2, 7);
+	});
+	runner.run("shim: luaL_len", 200000, [&]() { sink += static_cast<double>(luaL_len(L, -1)); });
+	static const char registry_key = 0;
+	lua_pushboolean(L, 1);
+	lua_rawsetp(L, LUA_REGISTRYINDEX, &registry_key);
+	runner.run("shim: lua_rawgetp", 200000, [&]() {
+		sink += lua_rawgetp(L, LUA_REGISTRYINDEX, &registry_key);
+		lua_pop(L, 1);
+	});
+	lua_pop(L, 1);
+
+	// what sol2 builds on them
+	lua.set_function("takes_int", &takes_int);
+	lua.set_function("takes_optional", &takes_optional);
+	auto lua_loop = [&lua](const std::string& body) {
+		return lua.load("local n = ... local r = 0 for i = 1, n do " + body + " end return r").get<sol::protected_function>();
+	};
+	sol::protected_function int_argument = lua_loop("r = takes_int(i)");
+	sol::protected_function optional_argument = lua_loop("r = takes_optional(i)");
+	runner.run("lua: integer argument", 200, [&]() { sink += int_argument(lua_batch).get<double>(); }, lua_batch);
+	runner.run("lua: optional integer argument", 200, [&]() { sink += optional_argument(lua_batch).get<double>(); }, lua_batch);
+
+	std::vector<int> numbers(sequence_size);
+	for (std::size_t i = 0; i < sequence_size; ++i) {
+		numbers[i] = static_cast<int>(i);
+	}
+	sol::table sequence = lua.create_table();
+	for (std::size_t i = 0; i < sequence_size; ++i) {
+		sequence[i + 1] = numbers[i];
+	}
+	runner.run("c++: table integer key get", 200000, [&]() { sink += sequence.get<int>(7); });
+	runner.run("c++: table integer key set", 200000, [&]() { sequence.set(7, 6); });
+	runner.run(
+	     "c++: as_table get (per element)",
+	     5000,
+	     [&]() {
+		     sequence.push();
+		     sink += static_cast<double>(sol::stack::get<sol::as_table_t<std::vector<int>>>(L, -1).size());
+		     lua_pop(L, 1);
+	     },
+	     sequence_size);
+	runner.run(
+	     "c++: as_table push (per element)",
+	     5000,
+	     [&]() {
+		     sol::stack::push(L, sol::as_table(numbers));
+		     lua_pop(L, 1);
+	     },
+	     sequence_size);
+
+	return sink == 0.0 ? 1 : 0;
+}
@@ -0,0 +1,323 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Game-loop macrobenchmark: a frame loop assembled from the patterns in
+// examples/source (the player usertype of usertype_advanced.cpp and
+// player_script.lua, the bound containers of containers.cpp, the task
+// coroutines of coroutine.cpp and the settings reads of config.cpp).
+// Every frame runs, in order:
+//
+//   config    settings read from a Lua table, as an engine polls tunables
+//   update    one Lua callback per entity, chosen by the entity's kind
+//   events    C++-raised events dispatched to Lua listeners
+//   ai        one coroutine per AI entity, resumed once per frame
+//   systems   a Lua pass over the bound entity container
+//
+// and the benchmark reports frames per second and the cost of each phase.
+//
+//   --entities=<n>     entities in the world (default 2000)
+//   --frames=<n>       frames to run (default 600)
+//   --ai=<percent>     share of entities driven by a coroutine (default 10)
+//   --events=<n>       events raised per frame (default 200)
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+	// the player of usertype_advanced.cpp, plus a transform to move around
+	struct player {
+	public:
+		int bullets;
+		int speed;
+
+		player() : player(3, 100) {
+		}
+
+		player(int ammo) : player(ammo, 100) {
+		}
+
+		player(int ammo, int hitpoints) : bullets(ammo), speed(0), hp(hitpoints) {
+		}
+
+		void boost() {
+			speed += 10;
+		}
+
+		bool shoot() {
+			if (bullets < 1)
+				return false;
+			--bullets;
+			return true;
+		}
+
+		void set_hp(int value) {
+			hp = value;
+		}
+
+		int get_hp() const {
+			return hp;
+		}
+
+	private:
+		int hp;
+	};
+
+	struct transform {
+		double x = 0.0;
+		double y = 0.0;
+		double vx = 0.0;
+		double vy = 0.0;
+	};
+
+	struct entity {
+		int id;
+		int kind;
+		bool alive;
+		transform position;
+		player stats;
+
+		entity(int id_, int kind_) : id(id_), kind(kind_), alive(true), position(), stats(10, 100) {
+		}
+	};
+
+	enum phase : std::size_t { phase_config, phase_update, phase_events, phase_ai, phase_systems, phase_count };
+
+	const char* const phase_names[phase_count] = { "config", "update", "events", "ai", "systems" };
+
+	const char game_script[] = R"(
+		config = {
+			physics = { gravity = -9.8, drag = 0.01 },
+			gameplay = { boost_every = 120, regen = 1 },
+		}
+
+		function player:brake()
+			self.speed = 0
+		end
+
+		local function walker(e, dt)
+			local t = e.position
+			t.x = t.x + t.vx * dt
+			t.y = t.y + t.vy * dt
+		end
+
+		local function shooter(e, dt)
+			walker(e, dt)
+			local p = e.stats
+			if not p:shoot() then
+				p.bullets = 10
+			end
+		end
+
+		local function tank(e, dt)
+			local p = e.stats
+			p.hp = p.hp + config.gameplay.regen
+			if p.hp > 200 then
+				p.hp = 200
+				p:brake()
+			end
+		end
+
+		updaters = { walker, shooter, tank }
+
+		listeners = { hit = {}, pickup = {} }
+		function listen(name, fx)
+			local list = listeners[name]
+			list[#list + 1] = fx
+		end
+		function dispatch(name, e, amount)
+			local list = listeners[name]
+			for i = 1, #list do
+				list[i](e, amount)
+			end
+		end
+		listen("hit", function(e, amount) local p = e.stats p.hp = p.hp - amount end)
+		listen("hit", function(e, amount) if e.stats.hp <= 0 then e.alive = false end end)
+		listen("pickup", function(e, amount) e.stats:boost() end)
+
+		-- yields how many steps it has taken, so the host can tell that every brain runs
+		function ai_brain(e)
+			local steps = 0
+			while true do
+				-- patrol for a while...
+				for _ = 1, 30 do
+					e.position.vx = 1
+					steps = steps + 1
+					coroutine.yield(steps)
+				end
+				-- ...then turn around and wait
+				e.position.vx = -1
+				for _ = 1, 10 do
+					steps = steps + 1
+					coroutine.yield(steps)
+				end
+			end
+		end
+
+		function count_alive(entities)
+			local alive = 0
+			for _, e in pairs(entities) do
+				if e.alive then
+					alive = alive + 1
+				end
+			end
+			return alive
+		end
+	)";
+} // namespace
+
+int main(int argc, char* argv[]) {
+	bench::options opts(argc, argv);
+	const int entity_count = static_cast<int>(opts.number("entities", 2000));
+	const int frames = static_cast<int>(opts.number("frames", 600));
+	const double ai_share = opts.number("ai", 10) / 100.0;
+	const int events_per_frame = static_cast<int>(opts.number("events", 200));
+	const double dt = 1.0 / 60.0;
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::coroutine, sol::lib::math, sol::lib::table);
+
+	lua.new_usertype<player>("player", sol::constructors<player(), player(int), player(int, int)>(), "shoot", &player::shoot, "boost",
+	     &player::boost, "hp", sol::property(&player::get_hp, &player::set_hp), "speed", &player::speed, "bullets", &player::bullets);
+	lua.new_usertype<transform>("transform", "x", &transform::x, "y", &transform::y, "vx", &transform::vx, "vy", &transform::vy);
+	lua.new_usertype<entity>("entity", sol::no_constructor, "id", sol::readonly(&entity::id), "kind", sol::readonly(&entity::kind), "alive",
+	     &entity::alive, "position", &entity::position, "stats", &entity::stats);
+	lua.script(game_script);
+
+	std::vector<std::unique_ptr<entity>> storage;
+	std::vector<entity*> entities;
+	storage.reserve(static_cast<std::size_t>(entity_count));
+	entities.reserve(static_cast<std::size_t>(entity_count));
+	for (int i = 0; i < entity_count; ++i) {
+		storage.push_back(std::make_unique<entity>(i, i % 3));
+		storage.back()->position.vx = 1.0 + (i % 7);
+		storage.back()->position.vy = 0.5 * (i % 5);
+		entities.push_back(storage.back().get());
+	}
+	lua["entities"] = &entities;
+
+	sol::table config = lua["config"];
+	sol::table updaters = lua["updaters"];
+	std::array<sol::protected_function, 3> update_by_kind
+	     = { updaters.get<sol::protected_function>(1), updaters.get<sol::protected_function>(2), updaters.get<sol::protected_function>(3) };
+	sol::protected_function dispatch = lua["dispatch"];
+	sol::protected_function count_alive = lua["count_alive"];
+
+	// one coroutine per AI entity, each on its own thread: a suspended coroutine owns its thread's
+	// stack, so brains sharing one thread would all resume the first brain's frame
+	std::vector<sol::thread> brain_threads;
+	std::vector<sol::coroutine> brains;
+	std::vector<entity*> brain_targets;
+	std::vector<int> brain_steps;
+	const int ai_stride = ai_share > 0.0 ? (std::max)(1, static_cast<int>(1.0 / ai_share)) : entity_count + 1;
+	for (int i = 0; i < entity_count; i += ai_stride) {
+		brain_threads.push_back(sol::thread::create(lua));
+		sol::state_view brain_state = brain_threads.back().state();
+		sol::function brain = brain_state["ai_brain"];
+		brains.emplace_back(brain_state, brain);
+		brain_targets.push_back(entities[static_cast<std::size_t>(i)]);
+	}
+	brain_steps.resize(brains.size(), 0);
+
+	std::array<bench::samples, phase_count> phase_us;
+	bench::samples frame_us;
+	std::size_t errors = 0;
+	std::uint32_t event_seed = 12345;
+	double sink = 0.0;
+
+	const bench::clock::time_point start = bench::clock::now();
+	for (int frame = 0; frame < frames; ++frame) {
+		const bench::clock::time_point frame_start = bench::clock::now();
+		bench::clock::time_point phase_start = frame_start;
+
+		double gravity = config["physics"]["gravity"];
+		double drag = config["physics"]["drag"];
+		int boost_every = config["gameplay"]["boost_every"];
+		sink += gravity + drag + boost_every;
+		phase_us[phase_config].add(bench::microseconds_since(phase_start));
+
+		phase_start = bench::clock::now();
+		for (entity* e : entities) {
+			sol::protected_function_result result = update_by_kind[static_cast<std::size_t>(e->kind)](e, dt);
+			if (!result.valid()) {
+				++errors;
+			}
+		}
+		phase_us[phase_update].add(bench::microseconds_since(phase_start));
+
+		phase_start = bench::clock::now();
+		for (int i = 0; i < events_per_frame; ++i) {
+			event_seed = event_seed * 1664525u + 1013904223u;
+			entity* target = entities[event_seed % entities.size()];
+			const bool hit = (event_seed >> 16) % 4 != 0;
+			sol::protected_function_result result = hit ? dispatch("hit", target, 1) : dispatch("pickup", target, 0);
+			if (!result.valid()) {
+				++errors;
+			}
+		}
+		phase_us[phase_events].add(bench::microseconds_since(phase_start));
+
+		phase_start = bench::clock::now();
+		for (std::size_t i = 0; i < brains.size(); ++i) {
+			sol::protected_function_result result = brains[i](brain_targets[i]);
+			if (!result.valid()) {
+				++errors;
+				continue;
+			}
+			brain_steps[i] = result;
+		}
+		phase_us[phase_ai].add(bench::microseconds_since(phase_start));
+
+		phase_start = bench::clock::now();
+		int alive = count_alive(&entities);
+		sink += alive;
+		phase_us[phase_systems].add(bench::microseconds_since(phase_start));
+
+		frame_us.add(bench::microseconds_since(frame_start));
+	}
+	const double elapsed = bench::seconds_since(start);
+
+	std::cout << "sol2 game loop: " << entity_count << " entities, " << brains.size() << " coroutine AIs, " << events_per_frame
+	          << " events/frame\n";
+	std::cout << frames << " frames in " << elapsed << " s: " << static_cast<double>(frames) / elapsed << " frames per second\n";
+	bench::print_percentiles(std::cout, "frame", frame_us, "us");
+	for (std::size_t i = 0; i < phase_count; ++i) {
+		bench::print_percentiles(std::cout, std::string("  ") + phase_names[i], phase_us[i], "us");
+	}
+	if (errors != 0) {
+		std::cerr << errors << " script errors\n";
+		return 1;
+	}
+	const std::size_t stalled = static_cast<std::size_t>(std::count_if(brain_steps.begin(), brain_steps.end(), [frames](int steps) { return steps != frames; }));
+	if (stalled != 0) {
+		std::cerr << stalled << " of " << brains.size() << " AI coroutines did not advance once per frame\n";
+		return 1;
+	}
+	return sink == 0.0 ? 1 : 0;
+}
@@ -0,0 +1,242 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Soak benchmark: runs a mix of everyday sol2 patterns for a fixed wall-clock
+// duration and reports, per interval, how the heap, the registry and the
+// allocator behave, along with the latency distribution of each tick and of
+// explicit GC steps. Meant to catch slow leaks and tail-latency regressions
+// that short microbenchmarks never run long enough to see.
+//
+//   --duration=<seconds>    total run time (default 10)
+//   --interval=<seconds>    length of one CSV row (default 1)
+//   --csv=<path>            write the time series there instead of stdout
+//   --gc=generational       switch to generational GC (Lua 5.4 only)
+//   --batch=<n>             objects created per pattern per tick (default 64)
+//
+// The CSV goes to stdout (or --csv), the percentile summary to stderr.
+
+#include "bench.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+	struct soak_entity {
+		double x = 0.0;
+		double y = 0.0;
+		int id = 0;
+
+		soak_entity(int id_) : id(id_) {
+		}
+
+		void move(double dx, double dy) {
+			x += dx;
+			y += dy;
+		}
+	};
+
+	struct interval_row {
+		std::size_t ticks = 0;
+		std::size_t errors = 0;
+		bench::samples tick_us;
+		bench::samples gc_step_us;
+	};
+
+	const char soak_script[] = R"(
+		function churn(n)
+			local sum = 0
+			for i = 1, n do
+				local e = entity.new(i)
+				e:move(1.5, -0.5)
+				sum = sum + e.x
+			end
+			return sum
+		end
+
+		function call_callbacks(n)
+			local sum = 0
+			for i = 1, n do
+				sum = sum + callbacks[i](i)
+			end
+			return sum
+		end
+
+		function iterate()
+			local sum = 0
+			for _, v in pairs(numbers) do
+				sum = sum + v
+			end
+			for _, v in pairs(lookup) do
+				sum = sum + v
+			end
+			return sum
+		end
+
+		function maybe_fail(i)
+			if i % 2 == 0 then
+				error("soak failure " .. i)
+			end
+			return i
+		end
+
+		function spawn(n)
+			local sum = 0
+			for i = 1, n do
+				local co = coroutine.create(function(a)
+					local b = coroutine.yield(a + 1)
+					return b * 2
+				end)
+				local _, first = coroutine.resume(co, i)
+				local _, second = coroutine.resume(co, first)
+				sum = sum + second
+			end
+			return sum
+		end
+	)";
+} // namespace
+
+int main(int argc, char* argv[]) {
+	bench::options opts(argc, argv);
+	const double duration = opts.number("duration", 10.0);
+	const double interval = opts.number("interval", 1.0);
+	const int batch = static_cast<int>(opts.number("batch", 64));
+	const std::string csv_path = opts.text("csv", "");
+	const std::string gc = opts.text("gc", "incremental");
+
+	bench::counting_allocator allocator;
+	sol::state lua(sol::default_at_panic, &bench::counting_allocator::allocate, &allocator);
+	lua.open_libraries(sol::lib::base, sol::lib::coroutine, sol::lib::string, sol::lib::math, sol::lib::table);
+	if (gc == "generational") {
+#if SOL_LUA_VERSION_I_ >= 504
+		lua.change_gc_mode_generational(0, 0);
+#else
+		std::cerr << "generational GC needs Lua 5.4; staying incremental\n";
+#endif
+	}
+
+	lua.new_usertype<soak_entity>("entity", sol::constructors<soak_entity(int)>(), "x", &soak_entity::x, "y", &soak_entity::y, "id",
+	     &soak_entity::id, "move", &soak_entity::move);
+	std::vector<int> numbers(256);
+	for (std::size_t i = 0; i < numbers.size(); ++i) {
+		numbers[i] = static_cast<int>(i);
+	}
+	std::map<std::string, int> lookup;
+	for (int i = 0; i < 64; ++i) {
+		lookup["key" + std::to_string(i)] = i;
+	}
+	lua["numbers"] = &numbers;
+	lua["lookup"] = &lookup;
+	sol::table callbacks = lua.create_named_table("callbacks");
+	lua.script(soak_script);
+
+	sol::protected_function churn = lua["churn"];
+	sol::protected_function call_callbacks = lua["call_callbacks"];
+	sol::protected_function iterate = lua["iterate"];
+	sol::protected_function maybe_fail = lua["maybe_fail"];
+	sol::protected_function spawn = lua["spawn"];
+
+	std::ofstream csv_file;
+	if (!csv_path.empty()) {
+		csv_file.open(csv_path);
+	}
+	std::ostream& csv = csv_path.empty() ? std::cout : csv_file;
+	csv << "interval,elapsed_s,ticks,memory_used,registry_size,allocations,reallocations,frees,allocated_bytes,errors,"
+	       "tick_p50_us,tick_p99_us,tick_max_us,gc_step_p50_us,gc_step_p99_us,gc_step_max_us\n";
+
+	const std::size_t start_memory = lua.memory_used();
+	const std::size_t start_registry = bench::registry_size(lua);
+	std::size_t peak_memory = start_memory;
+	std::size_t last_memory = start_memory;
+	std::size_t last_registry = start_registry;
+	bench::samples all_ticks;
+	bench::samples all_gc_steps;
+	std::size_t total_errors = 0;
+	std::size_t tick = 0;
+
+	const bench::clock::time_point start = bench::clock::now();
+	for (std::size_t interval_index = 0; bench::seconds_since(start) < duration; ++interval_index) {
+		interval_row row;
+		const bench::counting_allocator before = allocator;
+		const bench::clock::time_point interval_start = bench::clock::now();
+		while (bench::seconds_since(interval_start) < interval && bench::seconds_since(start) < duration) {
+			const bench::clock::time_point tick_start = bench::clock::now();
+
+			// usertype churn: short-lived entities, constructed and dropped from Lua
+			churn(batch);
+
+			// closures: fresh capturing lambdas replace the previous ones every tick
+			for (int i = 1; i <= 8; ++i) {
+				const std::size_t captured = tick + static_cast<std::size_t>(i);
+				callbacks.set_function(i, [captured](int value) { return static_cast<double>(value + captured); });
+			}
+			call_callbacks(8);
+
+			// containers iterated with pairs
+			iterate();
+
+			// protected calls, half of which raise
+			for (int i = 0; i < 16; ++i) {
+				sol::protected_function_result result = maybe_fail(i);
+				if (!result.valid()) {
+					++row.errors;
+				}
+			}
+
+			// coroutines created, resumed to completion and dropped
+			spawn(batch / 4);
+
+			row.tick_us.add(bench::microseconds_since(tick_start));
+			const bench::clock::time_point gc_start = bench::clock::now();
+			lua.step_gc(0);
+			row.gc_step_us.add(bench::microseconds_since(gc_start));
+			++row.ticks;
+			++tick;
+		}
+
+		last_memory = lua.memory_used();
+		last_registry = bench::registry_size(lua);
+		peak_memory = (std::max)(peak_memory, last_memory);
+		total_errors += row.errors;
+		csv << interval_index << ',' << bench::seconds_since(start) << ',' << row.ticks << ',' << last_memory << ',' << last_registry << ','
+		    << allocator.allocations - before.allocations << ',' << allocator.reallocations - before.reallocations << ','
+		    << allocator.frees - before.frees << ',' << allocator.allocated_bytes - before.allocated_bytes << ',' << row.errors << ','
+		    << row.tick_us.percentile(50) << ',' << row.tick_us.percentile(99) << ',' << row.tick_us.max() << ',' << row.gc_step_us.percentile(50)
+		    << ',' << row.gc_step_us.percentile(99) << ',' << row.gc_step_us.max() << '\n';
+		csv.flush();
+		all_ticks.append(row.tick_us);
+		all_gc_steps.append(row.gc_step_us);
+	}
+
+	std::cerr << "sol2 soak: " << tick << " ticks in " << bench::seconds_since(start) << " s, gc " << gc << ", " << total_errors
+	          << " expected errors\n";
+	bench::print_percentiles(std::cerr, "tick", all_ticks, "us");
+	bench::print_percentiles(std::cerr, "gc step", all_gc_steps, "us");
+	std::cerr << "heap: start " << start_memory << " B, end " << last_memory << " B, peak " << peak_memory << " B\n";
+	std::cerr << "registry: start " << start_registry << ", end " << last_registry << " references\n";
+	std::cerr << "allocator: " << allocator.allocations << " allocations, " << allocator.reallocations << " reallocations, " << allocator.frees
+	          << " frees\n";
+	return 0;
+}
@@ -0,0 +1,45 @@
+#define SOL_ALL_SAFETIES_ON 1
+#include <sol/sol.hpp>
+
+#include <chrono>
+#include <iostream>
+
+int main(int, char*[]) {
+	std::cout << "=== sandbox ===" << std::endl;
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::string, sol::lib::math, sol::lib::os, sol::lib::io);
+
+	sol::sandbox_limits limits;
+	// the heap may grow by at most 1 MB per run
+	limits.memory = 1024 * 1024;
+	// and a run may take at most 50 ms
+	limits.time = std::chrono::milliseconds(50);
+	sol::sandbox box(lua, limits);
+
+	// untrusted scripts only see the safe subset of the globals
+	sol::protected_function_result well_behaved
+	     = box.safe_script("return type(os), type(io), string.upper('ok')", sol::script_pass_on_error);
+	sol_c_assert(well_behaved.valid());
+	std::string os_type = well_behaved[0];
+	std::string ok = well_behaved[2];
+	sol_c_assert(os_type == "nil");
+	sol_c_assert(ok == "OK");
+
+	sol::protected_function_result spinning = box.safe_script("while true do end", sol::script_pass_on_error);
+	sol_c_assert(!spinning.valid());
+	sol_c_assert(box.violation() == sol::sandbox_violation::time);
+	std::cout << "spinning script stopped: " << sol::to_string(box.violation()) << std::endl;
+
+	sol::protected_function_result hungry
+	     = box.safe_script("local t = {} for i = 1, 1e8 do t[i] = i end", sol::script_pass_on_error);
+	sol_c_assert(!hungry.valid());
+	sol_c_assert(box.violation() == sol::sandbox_violation::memory);
+	std::cout << "hungry script stopped: " << sol::to_string(box.violation()) << ", peak was "
+	          << box.peak_memory_used() << " bytes" << std::endl;
+
+	// throw away anything the scripts left behind before the next request
+	box.reset();
+
+	return 0;
+}
@@ -0,0 +1,306 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_ALIGNED_ALLOCATOR_HPP
+#define SOL_ALIGNED_ALLOCATOR_HPP
+
+#include <sol/compatibility.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace sol {
+
+	namespace detail {
+		// alignment promised for an allocator (function and userdata pair) by set_userdata_alignment;
+		// entries are only ever appended, and allocf/ud are written before `count` publishes them
+		struct userdata_alignment_promise {
+			lua_Alloc allocf = nullptr;
+			void* ud = nullptr;
+			std::atomic<std::size_t> alignment { 0 };
+		};
+
+		struct userdata_alignment_promises {
+			static constexpr std::size_t capacity = 16;
+
+			std::atomic_flag writing = ATOMIC_FLAG_INIT;
+			std::atomic<std::size_t> count { 0 };
+			userdata_alignment_promise entries[capacity];
+		};
+
+		inline userdata_alignment_promises& alignment_promises() noexcept {
+			static userdata_alignment_promises promises;
+			return promises;
+		}
+
+		constexpr std::size_t lowest_power_of_two(std::size_t value) noexcept {
+			return value & (~value + 1);
+		}
+
+		struct userdata_block_probe {
+			void* block;
+		};
+
+		inline void* probe_userdata_block(void* ud, void* ptr, std::size_t osize, std::size_t nsize) {
+			if (nsize == 0) {
+				std::free(ptr);
+				return nullptr;
+			}
+			void* block = std::realloc(ptr, nsize);
+#if SOL_LUA_VERSION_I_ >= 502
+			if (ptr == nullptr && osize == LUA_TUSERDATA) {
+				static_cast<userdata_block_probe*>(ud)->block = block;
+			}
+#else
+			(void)ud;
+			(void)osize;
+#endif
+			return block;
+		}
+
+		// Lua keeps a header in front of every userdata: this is how many bytes lie between the block
+		// the allocator hands out and what lua_touserdata returns, for userdata shaped like sol2's own
+		// (one user value). Measured once with a throwaway state; npos when it cannot be known, which
+		// is the case before 5.2, where the allocator is not told what a new block is for
+		inline std::size_t userdata_payload_offset() {
+			static const std::size_t offset = []() -> std::size_t {
+				userdata_block_probe probe { nullptr };
+				lua_State* L = lua_newstate(&probe_userdata_block, &probe);
+				if (L == nullptr) {
+					return static_cast<std::size_t>(-1);
+				}
+#if SOL_LUA_VERSION_I_ >= 504
+				void* payload = lua_newuserdatauv(L, 1, 1);
+#else
+				void* payload = lua_newuserdata(L, 1);
+#endif
+				std::size_t result = probe.block == nullptr
+				     ? static_cast<std::size_t>(-1)
+				     : static_cast<std::size_t>(static_cast<char*>(payload) - static_cast<char*>(probe.block));
+				lua_close(L);
+				return result;
+			}();
+			return offset;
+		}
+	} // namespace detail
+
+	// A lua_Alloc that places userdata so the memory lua_touserdata returns (and sol2 lays
+	// usertypes out in) starts on an `alignment` boundary; every other block comes from plain realloc.
+	// Pass `&aligned_allocator::allocate` and the allocator's address to the state,
+	// and keep the allocator alive for as long as the state.
+	class aligned_allocator {
+	private:
+		// the boundary plain allocations are guaranteed to start on
+		static constexpr std::size_t plain_alignment = alignof(std::max_align_t);
+		// the distance back to the start of a shifted block is kept in the byte before it
+		static constexpr std::size_t max_alignment = 256;
+
+		enum class placement { plain, shifted, aligned };
+
+		std::size_t m_alignment;
+		std::size_t m_userdata_alignment;
+		placement m_placement;
+		// where, modulo the alignment, a userdata block must start so its payload lands on the boundary
+		std::size_t m_residue;
+
+		// a shifted block never starts where a plain one can, which is how it is recognized when freed
+		static bool is_shifted(void* ptr) noexcept {
+			return reinterpret_cast<std::uintptr_t>(ptr) % plain_alignment != 0;
+		}
+
+		static void* unshift(void* ptr) noexcept {
+			unsigned char* block = static_cast<unsigned char*>(ptr);
+			return static_cast<void*>(block - 1 - block[-1]);
+		}
+
+		void* allocate_shifted(std::size_t nsize) const noexcept {
+			unsigned char* raw = static_cast<unsigned char*>(std::malloc(nsize + m_alignment));
+			if (raw == nullptr) {
+				return nullptr;
+			}
+			std::uintptr_t first = reinterpret_cast<std::uintptr_t>(raw) + 1;
+			std::size_t distance = 1 + (m_residue + m_alignment - static_cast<std::size_t>(first % m_alignment)) % m_alignment;
+			unsigned char* block = raw + distance;
+			block[-1] = static_cast<unsigned char>(distance - 1);
+			return block;
+		}
+
+		void* allocate_aligned(std::size_t nsize) const noexcept {
+#if defined(_WIN32)
+			(void)nsize;
+			return nullptr;
+#else
+			void* block = nullptr;
+			if (::posix_memalign(&block, m_alignment, nsize) != 0) {
+				return nullptr;
+			}
+			return block;
+#endif
+		}
+
+	public:
+		explicit aligned_allocator(std::size_t alignment = 64)
+		: m_alignment(plain_alignment), m_userdata_alignment(0), m_placement(placement::plain), m_residue(0) {
+			if (alignment > m_alignment && alignment <= max_alignment && detail::lowest_power_of_two(alignment) == alignment) {
+				m_alignment = alignment;
+			}
+			std::size_t offset = detail::userdata_payload_offset();
+			if (offset == static_cast<std::size_t>(-1)) {
+				// nothing can be promised without knowing where the payload sits
+				m_alignment = plain_alignment;
+				return;
+			}
+			if (m_alignment > plain_alignment && offset % plain_alignment != 0) {
+				m_placement = placement::shifted;
+				m_residue = (m_alignment - offset % m_alignment) % m_alignment;
+				m_userdata_alignment = m_alignment;
+				return;
+			}
+			// a block shifted by a multiple of the plain alignment could not be told apart from a plain one,
+			// so the block itself is aligned: that only aligns the payload to as much of it as the header keeps
+			std::size_t header_alignment = offset == 0 ? m_alignment : detail::lowest_power_of_two(offset);
+#if defined(_WIN32)
+			// blocks from _aligned_malloc cannot be handed to free
+			header_alignment = header_alignment < plain_alignment ? header_alignment : plain_alignment;
+#endif
+			m_userdata_alignment = header_alignment < m_alignment ? header_alignment : m_alignment;
+			if (m_userdata_alignment > plain_alignment) {
+				m_placement = placement::aligned;
+			}
+			else {
+				// plain allocations already give this much: no reason to pay for aligned ones
+				m_alignment = plain_alignment;
+			}
+		}
+
+		// the boundary userdata blocks are placed relative to
+		std::size_t alignment() const noexcept {
+			return m_alignment;
+		}
+
+		// the boundary the memory returned by lua_touserdata is guaranteed to start on for userdata
+		// with one user value (all of sol2's), or 0 when this Lua does not say which allocations are userdata
+		std::size_t userdata_alignment() const noexcept {
+			return m_userdata_alignment;
+		}
+
+		static void* allocate(void* ud, void* ptr, std::size_t osize, std::size_t nsize) noexcept {
+			const aligned_allocator& self = *static_cast<const aligned_allocator*>(ud);
+			if (ptr != nullptr && self.m_placement == placement::shifted && is_shifted(ptr)) {
+				// Lua never resizes userdata, but a moved block must not keep the shift
+				void* moved = nsize == 0 ? nullptr : std::malloc(nsize);
+				if (moved == nullptr && nsize != 0) {
+					return nullptr;
+				}
+				if (moved != nullptr) {
+					std::memcpy(moved, ptr, osize < nsize ? osize : nsize);
+				}
+				std::free(unshift(ptr));
+				return moved;
+			}
+			if (nsize == 0) {
+				std::free(ptr);
+				return nullptr;
+			}
+#if SOL_LUA_VERSION_I_ >= 502
+			// for fresh blocks Lua passes the kind of object in osize
+			if (ptr == nullptr && osize == LUA_TUSERDATA) {
+				switch (self.m_placement) {
+				case placement::shifted:
+					return self.allocate_shifted(nsize);
+				case placement::aligned:
+					return self.allocate_aligned(nsize);
+				case placement::plain:
+					break;
+				}
+			}
+#else
+			(void)osize;
+#endif
+			return std::realloc(ptr, nsize);
+		}
+	};
+
+	// Promises sol2 that every userdata allocated by the allocator this state runs on starts on an
+	// `alignment` boundary, for allocators that guarantee it; the promise covers every state on the same
+	// allocator function and userdata. States running on `aligned_allocator` need not call this.
+	// Over-aligned usertypes then get exactly the space they need instead of room for the worst placement.
+	// Passing 0 withdraws the promise. Returns false when too many allocators hold a promise already.
+	inline bool set_userdata_alignment(lua_State* L, std::size_t alignment) {
+		void* ud = nullptr;
+		lua_Alloc allocf = lua_getallocf(L, &ud);
+		detail::userdata_alignment_promises& promises = detail::alignment_promises();
+		while (promises.writing.test_and_set(std::memory_order_acquire)) {
+		}
+		bool recorded = true;
+		std::size_t count = promises.count.load(std::memory_order_relaxed);
+		std::size_t i = 0;
+		for (; i < count; ++i) {
+			detail::userdata_alignment_promise& promise = promises.entries[i];
+			if (promise.allocf == allocf && promise.ud == ud) {
+				promise.alignment.store(alignment, std::memory_order_relaxed);
+				break;
+			}
+		}
+		if (i == count && alignment != 0) {
+			if (count < detail::userdata_alignment_promises::capacity) {
+				detail::userdata_alignment_promise& promise = promises.entries[count];
+				promise.allocf = allocf;
+				promise.ud = ud;
+				promise.alignment.store(alignment, std::memory_order_relaxed);
+				promises.count.store(count + 1, std::memory_order_release);
+			}
+			else {
+				recorded = false;
+			}
+		}
+		promises.writing.clear(std::memory_order_release);
+		return recorded;
+	}
+
+	// The alignment every userdata of this state is known to start on; 0 when nothing is known.
+	// Runs on every over-aligned allocation, so it only compares allocators: no stack, no registry
+	inline std::size_t userdata_alignment(lua_State* L) {
+		void* ud = nullptr;
+		lua_Alloc allocf = lua_getallocf(L, &ud);
+		if (allocf == &aligned_allocator::allocate) {
+			return static_cast<const aligned_allocator*>(ud)->userdata_alignment();
+		}
+		const detail::userdata_alignment_promises& promises = detail::alignment_promises();
+		const std::size_t count = promises.count.load(std::memory_order_acquire);
+		for (std::size_t i = 0; i < count; ++i) {
+			const detail::userdata_alignment_promise& promise = promises.entries[i];
+			if (promise.allocf == allocf && promise.ud == ud) {
+				return promise.alignment.load(std::memory_order_relaxed);
+			}
+		}
+		return 0;
+	}
+
+} // namespace sol
+
+#endif // SOL_ALIGNED_ALLOCATOR_HPP
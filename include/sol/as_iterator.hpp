@@ -0,0 +1,178 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this Spermission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_AS_ITERATOR_HPP
+#define SOL_AS_ITERATOR_HPP
+
+#include <sol/stack.hpp>
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace sol {
+
+	template <typename T>
+	struct as_iterator_t {
+		T src;
+	};
+
+	namespace detail {
+		template <typename It, typename Sentinel>
+		struct iterator_pair {
+			It first;
+			Sentinel last;
+
+			It begin() const {
+				return first;
+			}
+
+			Sentinel end() const {
+				return last;
+			}
+		};
+
+		template <typename R>
+		decltype(auto) adl_begin(R& r) {
+			using std::begin;
+			return begin(r);
+		}
+
+		template <typename R>
+		decltype(auto) adl_end(R& r) {
+			using std::end;
+			return end(r);
+		}
+
+		template <typename It>
+		using iterator_category_test_t = typename std::iterator_traits<It>::iterator_category;
+
+		template <typename It, typename = void>
+		struct is_multipass_iterator : std::false_type { };
+
+		template <typename It>
+		struct is_multipass_iterator<It, std::enable_if_t<meta::is_detected_v<iterator_category_test_t, It>>>
+		: std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category> { };
+
+		// Lives in the userdata that is the generic-for state: it owns the range
+		// (or points at it, when it was given by reference) and walks it one step per call.
+		template <typename R>
+		struct as_iterator_cursor {
+			using range_type = std::remove_reference_t<R>;
+			static constexpr bool borrowed = std::is_lvalue_reference_v<R>;
+			using storage_type = std::conditional_t<borrowed, range_type*, range_type>;
+			using iterator = decltype(adl_begin(std::declval<range_type&>()));
+			using sentinel = decltype(adl_end(std::declval<range_type&>()));
+			// elements that outlive the step that produced them can be handed out by reference;
+			// everything else (generated values, single-pass streams, owned ranges) is copied into Lua
+			static constexpr bool push_by_reference = borrowed && is_multipass_iterator<iterator>::value;
+
+			storage_type source;
+			iterator it;
+			sentinel last;
+			lua_Integer index;
+
+			template <typename Source>
+			as_iterator_cursor(Source&& source_)
+			: source(store(std::forward<Source>(source_))), it(adl_begin(range())), last(adl_end(range())), index(0) {
+			}
+
+			range_type& range() {
+				if constexpr (borrowed) {
+					return *source;
+				}
+				else {
+					return source;
+				}
+			}
+
+			template <typename Source>
+			static storage_type store(Source&& source_) {
+				if constexpr (borrowed) {
+					return std::addressof(source_);
+				}
+				else {
+					return storage_type(std::forward<Source>(source_));
+				}
+			}
+
+			static int next(lua_State* L) {
+				as_iterator_cursor& self = *static_cast<as_iterator_cursor*>(align_user<as_iterator_cursor>(lua_touserdata(L, 1)));
+				if (self.it == self.last) {
+					lua_pushnil(L);
+					return 1;
+				}
+				int pushed = stack::push(L, ++self.index);
+				if constexpr (push_by_reference) {
+					pushed += stack::push_reference(L, *self.it);
+				}
+				else {
+					pushed += stack::push(L, *self.it);
+				}
+				++self.it;
+				return pushed;
+			}
+		};
+	} // namespace detail
+
+	template <typename Range>
+	auto as_iterator(Range&& range) {
+		return as_iterator_t<Range> { std::forward<Range>(range) };
+	}
+
+	template <typename It, typename Sentinel>
+	auto as_iterator(It first, Sentinel last) {
+		return as_iterator_t<detail::iterator_pair<It, Sentinel>> { detail::iterator_pair<It, Sentinel> { std::move(first), std::move(last) } };
+	}
+
+	namespace stack {
+		template <typename T>
+		struct unqualified_pusher<as_iterator_t<T>> {
+			using cursor = detail::as_iterator_cursor<T>;
+
+			static int push(lua_State* L, as_iterator_t<T>&& e) {
+				return push_source(L, std::forward<T>(e.src));
+			}
+
+			static int push(lua_State* L, const as_iterator_t<T>& e) {
+				// borrowed ranges stay borrowed, owned ones are copied
+				return push_source(L, e.src);
+			}
+
+		private:
+			template <typename Source>
+			static int push_source(lua_State* L, Source&& source) {
+#if SOL_IS_ON(SOL_SAFE_STACK_CHECK)
+				luaL_checkstack(L, 3, detail::not_enough_stack_space_generic);
+#endif // make sure stack doesn't overflow
+				lua_pushcclosure(L, &cursor::next, 0);
+				stack::push<user<cursor>>(L, std::forward<Source>(source));
+				lua_pushnil(L);
+				return 3;
+			}
+		};
+	} // namespace stack
+
+} // namespace sol
+
+#endif // SOL_AS_ITERATOR_HPP
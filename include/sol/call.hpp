@@ -336,6 +336,7 @@ namespace sol {
 			// put userdata at the first index
 			lua_insert(L, 1);
 			construct_match<T, TypeLists...>(constructor_match<T, checked, clean_stack>(obj, userdataref, umf), L, argcount, 1 + static_cast<int>(syntax));
+			detail::charge_external_memory(L, *obj);
 
 			userdataref.push();
 			return 1;
@@ -485,6 +486,11 @@ namespace sol {
 #if SOL_IS_ON(SOL_SAFE_USERTYPE)
 						auto maybeo = stack::check_get<Ta*>(L, 1);
 						if (!maybeo || maybeo.value() == nullptr) {
+							if constexpr (is_disposable_v<Ta>) {
+								if (maybeo && type_of(L, 1) == type::userdata) {
+									return detail::disposed_error<Ta>(L);
+								}
+							}
 							return luaL_error(L,
 							     "sol: received nil for 'self' argument (use ':' for accessing member functions, make sure member variables are "
 							     "preceeded by the "
@@ -518,6 +524,11 @@ namespace sol {
 #if SOL_IS_ON(SOL_SAFE_USERTYPE)
 							auto maybeo = stack::check_get<Ta*>(L, 1);
 							if (!maybeo || maybeo.value() == nullptr) {
+								if constexpr (is_disposable_v<Ta>) {
+									if (maybeo && type_of(L, 1) == type::userdata) {
+										return detail::disposed_error<Ta>(L);
+									}
+								}
 								if (is_variable) {
 									return luaL_error(L, "sol: 'self' argument is lua_nil (bad '.' access?)");
 								}
@@ -576,6 +587,11 @@ namespace sol {
 #if SOL_IS_ON(SOL_SAFE_USERTYPE)
 									auto maybeo = stack::check_get<Ta*>(L, 1);
 									if (!maybeo || maybeo.value() == nullptr) {
+										if constexpr (is_disposable_v<Ta>) {
+											if (maybeo && type_of(L, 1) == type::userdata) {
+												return detail::disposed_error<Ta>(L);
+											}
+										}
 										if (is_variable) {
 											return luaL_error(L, "sol: received nil for 'self' argument (bad '.' access?)");
 										}
@@ -674,6 +690,7 @@ namespace sol {
 				// we cannot actually deallcoate/delete the data.
 				construct_match<T, Args...>(
 				     constructor_match<T, checked, clean_stack>(obj, userdataref, umf), L, argcount, boost + 1 + 1 + static_cast<int>(syntax));
+				detail::charge_external_memory(L, *obj);
 
 				userdataref.push();
 				return 1;
@@ -697,6 +714,7 @@ namespace sol {
 					// put userdata at the first index
 					lua_insert(L, 1);
 					stack::call_into_lua<checked, clean_stack>(r, a, L, boost + 1 + start, func, detail::implicit_wrapper<T>(obj));
+					detail::charge_external_memory(L, *obj);
 
 					userdataref.push();
 					return 1;
@@ -722,7 +740,9 @@ namespace sol {
 				else {
 					using uFx = meta::unqualified_t<Fx>;
 					lua_call_wrapper<T, uFx, is_index, is_variable, checked, boost, clean_stack> lcw {};
-					return lcw.call(L, std::forward<F>(f).fx);
+					int results = lcw.call(L, std::forward<F>(f).fx);
+					detail::count_usertype_destroyed<T>();
+					return results;
 				}
 			}
 		};
@@ -156,12 +156,14 @@ COMPAT53_API int lua_compare(lua_State* L, int idx1, int idx2, int op) {
 }
 
 
+#if !COMPAT53_LUAJIT_52_API
 COMPAT53_API void lua_copy(lua_State* L, int from, int to) {
 	int abs_to = lua_absindex(L, to);
 	luaL_checkstack(L, 1, "not enough stack slots");
 	lua_pushvalue(L, from);
 	lua_replace(L, abs_to);
 }
+#endif
 
 
 COMPAT53_API void lua_len(lua_State* L, int i) {
@@ -186,8 +188,8 @@ COMPAT53_API void lua_len(lua_State* L, int i) {
 COMPAT53_API int lua_rawgetp(lua_State* L, int i, const void* p) {
 	int abs_i = lua_absindex(L, i);
 	lua_pushlightuserdata(L, (void*)p);
-	lua_rawget(L, abs_i);
-	return lua_type(L, -1);
+	/* lua_rawget already hands back the type of what it pushed */
+	return lua_rawget(L, abs_i);
 }
 
 COMPAT53_API void lua_rawsetp(lua_State* L, int i, const void* p) {
@@ -199,6 +201,7 @@ COMPAT53_API void lua_rawsetp(lua_State* L, int i, const void* p) {
 }
 
 
+#if !COMPAT53_LUAJIT_52_API
 COMPAT53_API lua_Number lua_tonumberx(lua_State* L, int i, int* isnum) {
 	lua_Number n = lua_tonumber(L, i);
 	if (isnum != NULL) {
@@ -206,6 +209,7 @@ COMPAT53_API lua_Number lua_tonumberx(lua_State* L, int i, int* isnum) {
 	}
 	return n;
 }
+#endif
 
 
 COMPAT53_API void luaL_checkversion(lua_State* L) {
@@ -244,6 +248,18 @@ COMPAT53_API int luaL_getsubtable(lua_State* L, int i, const char* name) {
 COMPAT53_API lua_Integer luaL_len(lua_State* L, int i) {
 	lua_Integer res = 0;
 	int isnum = 0;
+	/* strings, and tables with no metatable to hold a __len, know their own length */
+	switch (lua_type(L, i)) {
+	case LUA_TSTRING:
+		return (lua_Integer)lua_objlen(L, i);
+	case LUA_TTABLE:
+		if (!lua_getmetatable(L, i))
+			return (lua_Integer)lua_objlen(L, i);
+		lua_pop(L, 1);
+		break;
+	default:
+		break;
+	}
 	luaL_checkstack(L, 1, "not enough stack slots");
 	lua_len(L, i);
 	res = lua_tointegerx(L, -1, &isnum);
@@ -725,8 +741,24 @@ void luaL_pushresult(luaL_Buffer_53* B) {
 #if defined(LUA_VERSION_NUM) && LUA_VERSION_NUM <= 502
 
 
+/* a table without a metatable has no __index or __newindex to reach,
+* so a raw access does the same as a regular one without the key conversion
+*/
+static int compat53_is_plain_table(lua_State* L, int index, lua_Integer i) {
+	if (i < INT_MIN || i > INT_MAX || lua_type(L, index) != LUA_TTABLE)
+		return 0;
+	if (lua_getmetatable(L, index)) {
+		lua_pop(L, 1);
+		return 0;
+	}
+	return 1;
+}
+
+
 COMPAT53_API int lua_geti(lua_State* L, int index, lua_Integer i) {
 	index = lua_absindex(L, index);
+	if (compat53_is_plain_table(L, index, i))
+		return lua_rawgeti(L, index, (int)i);
 	lua_pushinteger(L, i);
 	lua_gettable(L, index);
 	return lua_type(L, -1);
@@ -736,8 +768,7 @@ COMPAT53_API int lua_geti(lua_State* L, int index, lua_Integer i) {
 COMPAT53_API int lua_isinteger(lua_State* L, int index) {
 	if (lua_type(L, index) == LUA_TNUMBER) {
 		lua_Number n = lua_tonumber(L, index);
-		lua_Integer i = lua_tointeger(L, index);
-		if (i == n)
+		if ((lua_Number)(lua_Integer)n == n)
 			return 1;
 	}
 	return 0;
@@ -776,7 +807,17 @@ COMPAT53_API void lua_rotate(lua_State* L, int idx, int n) {
 	n_elems = lua_gettop(L) - idx + 1;
 	if (n < 0)
 		n += n_elems;
-	if (n > 0 && n < n_elems) {
+	if (n == 1 && n_elems > 1) {
+		/* the top element moves down to idx */
+		lua_insert(L, idx);
+	}
+	else if (n == n_elems - 1 && n > 0) {
+		/* the element at idx moves up to the top */
+		luaL_checkstack(L, 1, "not enough stack slots available");
+		lua_pushvalue(L, idx);
+		lua_remove(L, idx);
+	}
+	else if (n > 0 && n < n_elems) {
 		luaL_checkstack(L, 2, "not enough stack slots available");
 		n = n_elems - n;
 		compat53_reverse(L, idx, idx + n - 1);
@@ -789,6 +830,10 @@ COMPAT53_API void lua_rotate(lua_State* L, int idx, int n) {
 COMPAT53_API void lua_seti(lua_State* L, int index, lua_Integer i) {
 	luaL_checkstack(L, 1, "not enough stack slots available");
 	index = lua_absindex(L, index);
+	if (compat53_is_plain_table(L, index, i)) {
+		lua_rawseti(L, index, (int)i);
+		return;
+	}
 	lua_pushinteger(L, i);
 	lua_insert(L, -2);
 	lua_settable(L, index);
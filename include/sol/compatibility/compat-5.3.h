@@ -39,6 +39,17 @@ extern "C" {
 #define COMPAT53_CONCAT_HELPER(a, b) a##b
 #define COMPAT53_CONCAT(a, b) COMPAT53_CONCAT_HELPER(a, b)
 
+/* LuaJIT 2.1 already carries part of the 5.2 API (lua_copy, lua_tonumberx, ...):
+* those calls go straight to LuaJIT instead of through an emulation
+*/
+#ifndef COMPAT53_LUAJIT_52_API
+#  if defined(LUAJIT_VERSION_NUM) && LUAJIT_VERSION_NUM >= 20100
+#    define COMPAT53_LUAJIT_52_API 1
+#  else
+#    define COMPAT53_LUAJIT_52_API 0
+#  endif
+#endif /* LuaJIT 2.1 5.2 extensions */
+
 
 
 /* declarations for Lua 5.1 */
@@ -129,8 +140,10 @@ COMPAT53_API void lua_arith(lua_State *L, int op);
 #define lua_compare COMPAT53_CONCAT(COMPAT53_PREFIX, _compare)
 COMPAT53_API int lua_compare(lua_State *L, int idx1, int idx2, int op);
 
+#if !COMPAT53_LUAJIT_52_API
 #define lua_copy COMPAT53_CONCAT(COMPAT53_PREFIX, _copy)
 COMPAT53_API void lua_copy(lua_State *L, int from, int to);
+#endif
 
 #define lua_getuservalue(L, i) \
   (lua_getfenv((L), (i)), lua_type((L), -1))
@@ -169,8 +182,10 @@ COMPAT53_API void lua_rawsetp(lua_State *L, int i, const void *p);
 
 #define lua_tointeger(L, i) lua_tointegerx((L), (i), NULL)
 
+#if !COMPAT53_LUAJIT_52_API
 #define lua_tonumberx COMPAT53_CONCAT(COMPAT53_PREFIX, _tonumberx)
 COMPAT53_API lua_Number lua_tonumberx(lua_State *L, int i, int *isnum);
+#endif
 
 #define luaL_checkversion COMPAT53_CONCAT(COMPAT53_PREFIX, L_checkversion)
 COMPAT53_API void luaL_checkversion(lua_State *L);
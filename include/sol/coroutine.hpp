@@ -48,6 +48,7 @@ namespace sol {
 #else
 			stats = static_cast<call_status>(lua_resume(lua_state(), nullptr, static_cast<int>(argcount)));
 #endif
+			detail::count_coroutine_resume(static_cast<int>(stats));
 		}
 
 		template <std::size_t... I, typename... Ret>
@@ -0,0 +1,272 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_DEFERRED_DESTRUCTION_HPP
+#define SOL_DEFERRED_DESTRUCTION_HPP
+
+#include <sol/stack_core.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace sol {
+
+	struct deferred_destruction_metrics {
+		// objects handed over by finalizers, ever
+		std::size_t queued = 0;
+		// objects whose destructor has run, ever
+		std::size_t destroyed = 0;
+		// objects waiting right now, and the most that ever waited at once
+		std::size_t depth = 0;
+		std::size_t peak_depth = 0;
+		// time between the finalizer and the start of the destructor
+		std::chrono::nanoseconds total_latency {};
+		std::chrono::nanoseconds max_latency {};
+		// time spent inside the destructors themselves
+		std::chrono::nanoseconds total_destruction_time {};
+	};
+
+	namespace detail {
+		struct deferred_destruction_node {
+			deferred_destruction_node* next = nullptr;
+			void (*destroy)(deferred_destruction_node*) noexcept = nullptr;
+			std::chrono::steady_clock::time_point queued_at {};
+		};
+
+		template <typename T>
+		struct deferred_destruction_box : deferred_destruction_node {
+			T value;
+
+			deferred_destruction_box(T&& value_) : value(std::move(value_)) {
+				this->destroy = &destroy_box;
+			}
+
+			static void destroy_box(deferred_destruction_node* node_) noexcept {
+				delete static_cast<deferred_destruction_box*>(node_);
+			}
+		};
+	} // namespace detail
+
+	class deferred_destruction_queue {
+	private:
+		using node = detail::deferred_destruction_node;
+
+		// producers (finalizers, from any thread) only ever touch these atomics
+		std::atomic<node*> m_incoming;
+		std::atomic<std::size_t> m_queued;
+		std::atomic<std::size_t> m_destroyed;
+		std::atomic<std::size_t> m_peak_depth;
+		// the consumer side is serialized: whoever drains owns the pending list
+		mutable std::mutex m_drain_mutex;
+		node* m_pending_first;
+		node* m_pending_last;
+		std::chrono::nanoseconds m_total_latency;
+		std::chrono::nanoseconds m_max_latency;
+		std::chrono::nanoseconds m_total_destruction_time;
+
+		void take_incoming() noexcept {
+			node* list = m_incoming.exchange(nullptr, std::memory_order_acquire);
+			if (list == nullptr) {
+				return;
+			}
+			// the incoming stack is newest-first; destroy in the order objects were collected
+			node* last = list;
+			node* reversed = nullptr;
+			while (list != nullptr) {
+				node* next = list->next;
+				list->next = reversed;
+				reversed = list;
+				list = next;
+			}
+			if (m_pending_last == nullptr) {
+				m_pending_first = reversed;
+			}
+			else {
+				m_pending_last->next = reversed;
+			}
+			m_pending_last = last;
+		}
+
+	public:
+		deferred_destruction_queue() noexcept
+		: m_incoming(nullptr)
+		, m_queued(0)
+		, m_destroyed(0)
+		, m_peak_depth(0)
+		, m_drain_mutex()
+		, m_pending_first(nullptr)
+		, m_pending_last(nullptr)
+		, m_total_latency(0)
+		, m_max_latency(0)
+		, m_total_destruction_time(0) {
+		}
+		deferred_destruction_queue(const deferred_destruction_queue&) = delete;
+		deferred_destruction_queue& operator=(const deferred_destruction_queue&) = delete;
+
+		~deferred_destruction_queue() {
+			drain();
+		}
+
+		void push(detail::deferred_destruction_node* node_) noexcept {
+			node_->queued_at = std::chrono::steady_clock::now();
+			// count first, so a concurrent drain can never see more destroyed than queued
+			std::size_t depth = m_queued.fetch_add(1, std::memory_order_relaxed) + 1 - m_destroyed.load(std::memory_order_relaxed);
+			std::size_t peak = m_peak_depth.load(std::memory_order_relaxed);
+			while (depth > peak && !m_peak_depth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {
+			}
+			node* head = m_incoming.load(std::memory_order_relaxed);
+			do {
+				node_->next = head;
+			} while (!m_incoming.compare_exchange_weak(head, node_, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		template <typename T>
+		bool push_value(T& value) noexcept {
+			using box = detail::deferred_destruction_box<T>;
+			box* b = new (std::nothrow) box(std::move(value));
+			if (b == nullptr) {
+				return false;
+			}
+			push(b);
+			return true;
+		}
+
+		std::size_t drain(std::size_t max_count = (std::numeric_limits<std::size_t>::max)()) {
+			std::lock_guard<std::mutex> lock(m_drain_mutex);
+			take_incoming();
+			std::size_t count = 0;
+			for (; m_pending_first != nullptr && count < max_count; ++count) {
+				node* n = m_pending_first;
+				m_pending_first = n->next;
+				if (m_pending_first == nullptr) {
+					m_pending_last = nullptr;
+				}
+				auto start = std::chrono::steady_clock::now();
+				std::chrono::nanoseconds latency = std::chrono::duration_cast<std::chrono::nanoseconds>(start - n->queued_at);
+				m_total_latency += latency;
+				if (latency > m_max_latency) {
+					m_max_latency = latency;
+				}
+				n->destroy(n);
+				m_total_destruction_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+				m_destroyed.fetch_add(1, std::memory_order_relaxed);
+			}
+			return count;
+		}
+
+		std::size_t size() const noexcept {
+			return m_queued.load(std::memory_order_relaxed) - m_destroyed.load(std::memory_order_relaxed);
+		}
+
+		bool empty() const noexcept {
+			return size() == 0;
+		}
+
+		deferred_destruction_metrics metrics() const {
+			std::lock_guard<std::mutex> lock(m_drain_mutex);
+			deferred_destruction_metrics m;
+			m.destroyed = m_destroyed.load(std::memory_order_relaxed);
+			m.queued = m_queued.load(std::memory_order_relaxed);
+			m.depth = m.queued - m.destroyed;
+			m.peak_depth = m_peak_depth.load(std::memory_order_relaxed);
+			m.total_latency = m_total_latency;
+			m.max_latency = m_max_latency;
+			m.total_destruction_time = m_total_destruction_time;
+			return m;
+		}
+	};
+
+	inline deferred_destruction_queue& default_deferred_destruction_queue() {
+		static deferred_destruction_queue queue;
+		return queue;
+	}
+
+	class deferred_destruction_worker {
+	private:
+		deferred_destruction_queue* m_queue;
+		std::chrono::steady_clock::duration m_interval;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		bool m_stop;
+		std::thread m_thread;
+
+		void run() {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (!m_stop) {
+				lock.unlock();
+				m_queue->drain();
+				lock.lock();
+				m_wake.wait_for(lock, m_interval, [this]() { return m_stop; });
+			}
+		}
+
+	public:
+		explicit deferred_destruction_worker(
+		     deferred_destruction_queue& queue_ = default_deferred_destruction_queue(), std::chrono::steady_clock::duration interval_ = std::chrono::milliseconds(1))
+		: m_queue(&queue_), m_interval(interval_), m_mutex(), m_wake(), m_stop(false), m_thread([this]() { run(); }) {
+		}
+		deferred_destruction_worker(const deferred_destruction_worker&) = delete;
+		deferred_destruction_worker& operator=(const deferred_destruction_worker&) = delete;
+
+		~deferred_destruction_worker() {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+			m_wake.notify_one();
+			m_thread.join();
+			m_queue->drain();
+		}
+
+		void wake() {
+			m_wake.notify_one();
+		}
+
+		deferred_destruction_queue& queue() const noexcept {
+			return *m_queue;
+		}
+	};
+
+	namespace detail {
+		// moves the object out of the userdata being collected: the caller still destroys
+		// the moved-from husk (or, if the queue could not allocate, the object itself)
+		template <typename T>
+		void defer_destruction(T& value) noexcept {
+			static_assert(std::is_move_constructible_v<T>,
+			     "sol: a type marked with sol::is_deferred_destruction must be move constructible, so it can be moved out of the userdata being collected");
+			(void)default_deferred_destruction_queue().push_value(value);
+		}
+	} // namespace detail
+
+} // namespace sol
+
+#endif // SOL_DEFERRED_DESTRUCTION_HPP
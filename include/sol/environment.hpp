@@ -119,7 +119,7 @@ namespace sol {
 			int target_index = pp.index_of(target);
 #if SOL_LUA_VERSION_I_ < 502
 			// Use lua_setfenv
-			this->push();
+			this->push(L);
 			int success_result = lua_setfenv(L, target_index);
 			return success_result != 0;
 #else
@@ -132,7 +132,7 @@ namespace sol {
 				}
 				string_view upvalue_name(maybe_upvalue_name);
 				if (upvalue_name == "") {
-					this->push();
+					this->push(L);
 					const char* success = lua_setupvalue(L, target_index, 1);
 					if (success == nullptr) {
 						// left things alone on the stack, pop them off
@@ -155,7 +155,7 @@ namespace sol {
 					string_view upvalue_name(maybe_upvalue_name);
 					if (upvalue_name == "_ENV") {
 						lua_pop(L, 1);
-						this->push();
+						this->push(L);
 						const char* success = lua_setupvalue(L, target_index, upvalue_index);
 						if (success == nullptr) {
 							// left things alone on the stack, pop them off
@@ -0,0 +1,216 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_EXTERNAL_MEMORY_HPP
+#define SOL_EXTERNAL_MEMORY_HPP
+
+#include <sol/compatibility.hpp>
+#include <sol/traits.hpp>
+
+#include <climits>
+#include <cstddef>
+#include <new>
+#include <unordered_map>
+#include <utility>
+
+namespace sol {
+
+	namespace meta { namespace meta_detail {
+		template <typename T>
+		using adl_sol_lua_external_size_test_t = decltype(sol_lua_external_size(std::declval<const T&>()));
+	}} // namespace meta::meta_detail
+
+	// true when an ADL-visible `sol_lua_external_size(const T&)` reports
+	// how many bytes an object of T holds outside of its userdata
+	template <typename T>
+	struct has_external_size : meta::is_detected<meta::meta_detail::adl_sol_lua_external_size_test_t, T> { };
+
+	template <typename T>
+	inline constexpr bool has_external_size_v = has_external_size<T>::value;
+
+	namespace detail {
+		// what one object owned by Lua was charged: refunds hand back exactly this,
+		// whatever sol_lua_external_size says by the time the object is collected
+		struct external_memory_charge {
+			// bytes charged for each owning userdata
+			std::size_t bytes;
+			// userdata that own the object (more than one for a shared holder pushed twice)
+			std::size_t owners;
+		};
+
+		using external_memory_charges = std::unordered_map<const void*, external_memory_charge>;
+
+		struct external_memory_ledger {
+			// bytes currently reported as held outside of the Lua heap
+			std::size_t used;
+			// reported bytes not yet handed to the collector (less than a kilobyte)
+			std::size_t pending;
+			// null until the first charge, and again once the ledger is collected: objects
+			// finalized after it while the state closes find nothing left to refund
+			external_memory_charges* charges;
+		};
+
+		inline const void* external_memory_registry_key() noexcept {
+			static const char key = 0;
+			return static_cast<const void*>(&key);
+		}
+
+		inline int destroy_external_memory_ledger(lua_State* L) noexcept {
+			external_memory_ledger* ledger = static_cast<external_memory_ledger*>(lua_touserdata(L, 1));
+			delete ledger->charges;
+			ledger->charges = nullptr;
+			return 0;
+		}
+
+		inline external_memory_ledger* find_external_memory_ledger(lua_State* L, bool create) {
+			lua_rawgetp(L, LUA_REGISTRYINDEX, external_memory_registry_key());
+			void* memory = lua_touserdata(L, -1);
+			lua_pop(L, 1);
+			if (memory == nullptr && create) {
+				memory = lua_newuserdata(L, sizeof(external_memory_ledger));
+				new (memory) external_memory_ledger { 0, 0, nullptr };
+				lua_createtable(L, 0, 1);
+				lua_pushcfunction(L, &destroy_external_memory_ledger);
+				lua_setfield(L, -2, "__gc");
+				lua_setmetatable(L, -2);
+				lua_rawsetp(L, LUA_REGISTRYINDEX, external_memory_registry_key());
+			}
+			return static_cast<external_memory_ledger*>(memory);
+		}
+	} // namespace detail
+
+	inline std::size_t external_memory_used(lua_State* L) {
+		detail::external_memory_ledger* ledger = detail::find_external_memory_ledger(L, false);
+		return ledger == nullptr ? 0 : ledger->used;
+	}
+
+	// Growth is turned into collector debt a kilobyte at a time, so the
+	// incremental collector works harder in proportion to memory it cannot see.
+	// Shrinking only lowers the running total: the collector has no notion of credit.
+	inline void adjust_external_memory(lua_State* L, std::ptrdiff_t delta_bytes) {
+		if (delta_bytes == 0) {
+			return;
+		}
+		detail::external_memory_ledger* ledger = detail::find_external_memory_ledger(L, delta_bytes > 0);
+		if (ledger == nullptr) {
+			return;
+		}
+		if (delta_bytes < 0) {
+			std::size_t released = static_cast<std::size_t>(-(delta_bytes + 1)) + 1;
+			ledger->used = released > ledger->used ? 0 : ledger->used - released;
+			ledger->pending = released > ledger->pending ? 0 : ledger->pending - released;
+			return;
+		}
+		std::size_t grown = static_cast<std::size_t>(delta_bytes);
+		ledger->used += grown;
+		ledger->pending += grown;
+		if (ledger->pending < 1024) {
+			return;
+		}
+		std::size_t kilobytes = ledger->pending / 1024;
+		ledger->pending %= 1024;
+#if SOL_LUA_VERSION_I_ >= 502
+		if (lua_gc(L, LUA_GCISRUNNING, 0) == 0) {
+			// a stopped collector is not owed anything when it restarts
+			return;
+		}
+#endif
+		lua_gc(L, LUA_GCSTEP, kilobytes > static_cast<std::size_t>(INT_MAX) ? INT_MAX : static_cast<int>(kilobytes));
+	}
+
+	namespace detail {
+		template <typename T>
+		std::ptrdiff_t external_size_of(const T& obj) {
+			return static_cast<std::ptrdiff_t>(sol_lua_external_size(obj));
+		}
+
+		inline external_memory_charge* find_external_memory_charge(lua_State* L, const void* obj) {
+			external_memory_ledger* ledger = find_external_memory_ledger(L, false);
+			if (ledger == nullptr || ledger->charges == nullptr) {
+				return nullptr;
+			}
+			auto it = ledger->charges->find(obj);
+			return it == ledger->charges->end() ? nullptr : &it->second;
+		}
+
+		template <typename T>
+		void charge_external_memory(lua_State* L, const T& obj) {
+			if constexpr (has_external_size_v<T>) {
+				std::ptrdiff_t size = external_size_of(obj);
+				external_memory_ledger* ledger = find_external_memory_ledger(L, true);
+				if (ledger->charges == nullptr) {
+					ledger->charges = new external_memory_charges();
+				}
+				external_memory_charge& charge = (*ledger->charges)[static_cast<const void*>(&obj)];
+				// another owner of an object that is already charged: bring the existing
+				// owners up to date first, so that every owner carries the same amount
+				adjust_external_memory(L, (size - static_cast<std::ptrdiff_t>(charge.bytes)) * static_cast<std::ptrdiff_t>(charge.owners));
+				charge.bytes = static_cast<std::size_t>(size);
+				charge.owners += 1;
+				adjust_external_memory(L, size);
+			}
+			else {
+				(void)L;
+				(void)obj;
+			}
+		}
+
+		template <typename T>
+		void refund_external_memory(lua_State* L, const T& obj) noexcept {
+			if constexpr (has_external_size_v<T>) {
+				external_memory_charge* charge = find_external_memory_charge(L, static_cast<const void*>(&obj));
+				if (charge == nullptr) {
+					return;
+				}
+				std::ptrdiff_t bytes = static_cast<std::ptrdiff_t>(charge->bytes);
+				if (--charge->owners == 0) {
+					find_external_memory_ledger(L, false)->charges->erase(static_cast<const void*>(&obj));
+				}
+				adjust_external_memory(L, -bytes);
+			}
+			else {
+				(void)L;
+				(void)obj;
+			}
+		}
+	} // namespace detail
+
+	// Measures obj again with sol_lua_external_size and charges (or refunds) the
+	// difference from what it was charged so far. Call it after an object owned by
+	// Lua grows or shrinks; objects Lua does not own are left alone.
+	template <typename T>
+	void update_external_memory(lua_State* L, const T& obj) {
+		static_assert(has_external_size_v<T>, "sol::update_external_memory needs an ADL-visible sol_lua_external_size for T");
+		detail::external_memory_charge* charge = detail::find_external_memory_charge(L, static_cast<const void*>(&obj));
+		if (charge == nullptr) {
+			return;
+		}
+		std::ptrdiff_t size = detail::external_size_of(obj);
+		std::ptrdiff_t delta = (size - static_cast<std::ptrdiff_t>(charge->bytes)) * static_cast<std::ptrdiff_t>(charge->owners);
+		charge->bytes = static_cast<std::size_t>(size);
+		adjust_external_memory(L, delta);
+	}
+
+} // namespace sol
+
+#endif // SOL_EXTERNAL_MEMORY_HPP
@@ -153,6 +153,18 @@ namespace sol {
 	class basic_packaged_coroutine;
 	template <typename base_t>
 	class basic_thread;
+	template <typename T>
+	class generator;
+	template <typename T>
+	class sequence_view;
+	class isolated_thread;
+	class package_index;
+	class thread_pool;
+	class parallel_kernels;
+	class record_schema;
+	class record_type;
+	template <typename T>
+	class record_view;
 
 	using object = basic_object<reference>;
 	using userdata = basic_userdata<reference>;
@@ -181,6 +193,7 @@ namespace sol {
 
 	class state_view;
 	class state;
+	class sandbox;
 
 	template <typename T>
 	struct as_table_t;
@@ -195,6 +208,10 @@ namespace sol {
 	template <typename T>
 	struct as_args_t;
 	template <typename T>
+	struct as_iterator_t;
+	template <typename T>
+	struct interned_t;
+	template <typename T>
 	struct protect_t;
 	template <typename F, typename... Policies>
 	struct policy_wrapper;
@@ -0,0 +1,210 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_GENERATOR_HPP
+#define SOL_GENERATOR_HPP
+
+#include <sol/reference.hpp>
+#include <sol/stack.hpp>
+#include <sol/coroutine.hpp>
+#include <sol/error.hpp>
+#include <sol/demangle.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <utility>
+
+namespace sol {
+
+	struct generator_sentinel { };
+
+	template <typename T>
+	class generator {
+	private:
+		lua_State* m_L;
+		reference m_function;
+		optional<T> m_value;
+		std::string m_error;
+		call_status m_status;
+		bool m_started;
+
+		void m_fail(call_status status, std::string message) {
+			m_value.reset();
+			m_status = status;
+			m_error = std::move(message);
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+			throw sol::error(detail::direct_error, m_error);
+#endif
+		}
+
+		void m_resume() {
+			m_value.reset();
+			if (m_status != call_status::yielded || m_L == nullptr) {
+				return;
+			}
+			int base = lua_gettop(m_L);
+			int argcount = 0;
+			bool fresh = !m_started && lua_status(m_L) != LUA_YIELD;
+			m_started = true;
+			if (fresh) {
+				// a coroutine that was already running is picked up where it is
+				m_function.push(m_L);
+			}
+#if SOL_LUA_VERSION_I_ >= 504
+			int nresults = 0;
+			call_status status = static_cast<call_status>(lua_resume(m_L, nullptr, argcount, &nresults));
+			base = lua_gettop(m_L) - nresults;
+#else
+			call_status status = static_cast<call_status>(lua_resume(m_L, nullptr, argcount));
+			if (status == call_status::yielded || !fresh) {
+				// once a thread has yielded, its frame only holds what was passed out
+				base = 0;
+			}
+#endif
+			detail::count_coroutine_resume(static_cast<int>(status));
+			if (status != call_status::ok && status != call_status::yielded) {
+				const char* message = lua_tostring(m_L, -1);
+				std::string reason = message != nullptr ? std::string(message) : std::string("the coroutine raised a non-string error object");
+				lua_pop(m_L, 1);
+				m_fail(status, std::move(reason));
+				return;
+			}
+			m_status = status;
+			if (status == call_status::ok) {
+				// a return ends the sequence: whatever was returned is not part of it
+				lua_settop(m_L, base);
+				return;
+			}
+			int first = base + 1;
+			if (lua_gettop(m_L) < first || !stack::check<T>(m_L, first, &no_panic)) {
+				lua_settop(m_L, base);
+				m_fail(call_status::runtime,
+				     std::string("sol: the coroutine yielded a value that is not a ").append(detail::demangle<meta::unqualified_t<T>>()));
+				return;
+			}
+			m_value.emplace(stack::get<T>(m_L, first));
+			lua_settop(m_L, base);
+		}
+
+	public:
+		class iterator {
+		private:
+			generator* m_source;
+
+			bool m_at_end() const noexcept {
+				return m_source == nullptr || !m_source->m_value.has_value();
+			}
+
+		public:
+			using value_type = T;
+			using reference = T&;
+			using pointer = T*;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::input_iterator_tag;
+
+			iterator() noexcept : m_source(nullptr) {
+			}
+			iterator(generator& source) noexcept : m_source(&source) {
+			}
+
+			reference operator*() const noexcept {
+				return *m_source->m_value;
+			}
+
+			pointer operator->() const noexcept {
+				return std::addressof(*m_source->m_value);
+			}
+
+			iterator& operator++() {
+				m_source->m_resume();
+				return *this;
+			}
+
+			void operator++(int) {
+				++*this;
+			}
+
+			call_status status() const noexcept {
+				return m_source->status();
+			}
+
+			friend bool operator==(const iterator& left, const generator_sentinel&) noexcept {
+				return left.m_at_end();
+			}
+
+			friend bool operator!=(const iterator& left, const generator_sentinel& right) noexcept {
+				return !(left == right);
+			}
+
+			friend bool operator==(const generator_sentinel& left, const iterator& right) noexcept {
+				return right == left;
+			}
+
+			friend bool operator!=(const generator_sentinel& left, const iterator& right) noexcept {
+				return !(right == left);
+			}
+		};
+
+		using value_type = T;
+		using sentinel = generator_sentinel;
+
+		template <typename Reference>
+		generator(const basic_coroutine<Reference>& co)
+		: m_L(co.lua_state()), m_function(co.lua_state(), co), m_value(), m_error(), m_status(call_status::yielded), m_started(false) {
+		}
+
+		generator(const generator&) = delete;
+		generator& operator=(const generator&) = delete;
+		generator(generator&&) = default;
+		generator& operator=(generator&&) = default;
+
+		// the first call runs the coroutine up to its first yield;
+		// the sequence is single-pass, so later calls pick up where it is
+		iterator begin() {
+			if (!m_started) {
+				m_resume();
+			}
+			return iterator(*this);
+		}
+
+		generator_sentinel end() const noexcept {
+			return {};
+		}
+
+		call_status status() const noexcept {
+			return m_status;
+		}
+
+		bool error() const noexcept {
+			return m_status != call_status::ok && m_status != call_status::yielded;
+		}
+
+		const std::string& error_message() const noexcept {
+			return m_error;
+		}
+	};
+
+} // namespace sol
+
+#endif // SOL_GENERATOR_HPP
@@ -0,0 +1,343 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_INTERNED_HPP
+#define SOL_INTERNED_HPP
+
+#include <sol/stack.hpp>
+#include <sol/ebco.hpp>
+#include <sol/string_view.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sol {
+	template <typename T>
+	struct interned_t : private detail::ebco<T> {
+	private:
+		using base_t = detail::ebco<T>;
+
+	public:
+		using base_t::base_t;
+		using base_t::value;
+	};
+
+	// pushes a string through the state's cache of pinned strings: a C string
+	// is looked up by its address (so it must never change), anything else by contents
+	template <typename Source>
+	auto interned(Source&& source) {
+		return interned_t<std::decay_t<Source>> { std::forward<Source>(source) };
+	}
+
+	struct interned_string_stats {
+		std::size_t entries;
+		std::size_t bytes;
+		std::size_t hits;
+		std::size_t misses;
+		std::size_t rejected;
+		std::size_t max_entries;
+		std::size_t max_bytes;
+	};
+
+	namespace detail {
+		struct interned_slot {
+			std::size_t hash;
+			const char* data;
+			std::size_t size;
+			int ref;
+		};
+
+		// open addressing with linear probing over a power-of-two table, kept at most half full:
+		// a hit is a hash, a mask and (nearly always) one comparison
+		class interned_table {
+		private:
+			std::vector<interned_slot> m_slots;
+			std::size_t m_count;
+
+			void grow() {
+				std::vector<interned_slot> old = std::move(m_slots);
+				m_slots.assign(old.empty() ? 16 : old.size() * 2, interned_slot { 0, nullptr, 0, LUA_NOREF });
+				for (const interned_slot& slot : old) {
+					if (slot.ref != LUA_NOREF) {
+						place(slot);
+					}
+				}
+			}
+
+			void place(const interned_slot& slot) {
+				std::size_t mask = m_slots.size() - 1;
+				std::size_t index = slot.hash & mask;
+				while (m_slots[index].ref != LUA_NOREF) {
+					index = (index + 1) & mask;
+				}
+				m_slots[index] = slot;
+			}
+
+		public:
+			interned_table() noexcept : m_slots(), m_count(0) {
+			}
+
+			template <typename Equal>
+			int find(std::size_t hash, Equal&& equal) const {
+				if (m_slots.empty()) {
+					return LUA_NOREF;
+				}
+				std::size_t mask = m_slots.size() - 1;
+				for (std::size_t index = hash & mask;; index = (index + 1) & mask) {
+					const interned_slot& slot = m_slots[index];
+					if (slot.ref == LUA_NOREF) {
+						return LUA_NOREF;
+					}
+					if (slot.hash == hash && equal(slot)) {
+						return slot.ref;
+					}
+				}
+			}
+
+			void insert(const interned_slot& slot) {
+				if ((m_count + 1) * 2 > m_slots.size()) {
+					grow();
+				}
+				place(slot);
+				++m_count;
+			}
+
+			std::size_t size() const noexcept {
+				return m_count;
+			}
+
+			template <typename Fx>
+			void clear(Fx&& on_each) {
+				for (const interned_slot& slot : m_slots) {
+					if (slot.ref != LUA_NOREF) {
+						on_each(slot);
+					}
+				}
+				m_slots.clear();
+				m_count = 0;
+			}
+		};
+
+		inline std::size_t interned_address_hash(const void* address) noexcept {
+			std::size_t bits = reinterpret_cast<std::size_t>(address);
+			bits ^= bits >> 17;
+			bits *= static_cast<std::size_t>(0x9E3779B97F4A7C15ull);
+			return bits ^ (bits >> 29);
+		}
+
+		// every entry owns a registry reference to its string, which keeps it alive
+		// (and the bytes a contents key points at in place); full means new strings
+		// are pushed as usual and counted as rejected, nothing already pinned is evicted
+		class interned_string_cache {
+		private:
+			interned_table m_by_address;
+			interned_table m_by_contents;
+			std::size_t m_bytes;
+			std::size_t m_hits;
+			std::size_t m_misses;
+			std::size_t m_rejected;
+			std::size_t m_max_entries;
+			std::size_t m_max_bytes;
+
+			bool has_room(std::size_t size) const noexcept {
+				return m_by_address.size() + m_by_contents.size() < m_max_entries && size <= m_max_bytes - (std::min)(m_bytes, m_max_bytes);
+			}
+
+			// pins the string on top of the stack, leaving it there
+			int pin(lua_State* L, std::size_t size) {
+				lua_pushvalue(L, -1);
+				int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+				m_bytes += size;
+				return ref;
+			}
+
+		public:
+			interned_string_cache() noexcept
+			: m_by_address(), m_by_contents(), m_bytes(0), m_hits(0), m_misses(0), m_rejected(0), m_max_entries(4096), m_max_bytes(1024 * 1024) {
+			}
+
+			void push(lua_State* L, const char* address) {
+				std::size_t hash = interned_address_hash(address);
+				int ref = m_by_address.find(hash, [address](const interned_slot& slot) { return slot.data == address; });
+				if (ref != LUA_NOREF) {
+					++m_hits;
+					lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+					return;
+				}
+				++m_misses;
+				std::size_t size = std::char_traits<char>::length(address);
+				lua_pushlstring(L, address, size);
+				if (!has_room(size)) {
+					++m_rejected;
+					return;
+				}
+				m_by_address.insert(interned_slot { hash, address, size, pin(L, size) });
+			}
+
+			void push(lua_State* L, string_view contents) {
+				std::size_t hash = std::hash<string_view>()(contents);
+				int ref = m_by_contents.find(hash, [contents](const interned_slot& slot) {
+					return slot.size == contents.size() && std::char_traits<char>::compare(slot.data, contents.data(), slot.size) == 0;
+				});
+				if (ref != LUA_NOREF) {
+					++m_hits;
+					lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+					return;
+				}
+				++m_misses;
+				lua_pushlstring(L, contents.data(), contents.size());
+				if (!has_room(contents.size())) {
+					++m_rejected;
+					return;
+				}
+				std::size_t size = 0;
+				const char* pinned = lua_tolstring(L, -1, &size);
+				m_by_contents.insert(interned_slot { hash, pinned, size, pin(L, size) });
+			}
+
+			void clear(lua_State* L) {
+				auto unpin = [L](const interned_slot& slot) { luaL_unref(L, LUA_REGISTRYINDEX, slot.ref); };
+				m_by_address.clear(unpin);
+				m_by_contents.clear(unpin);
+				m_bytes = 0;
+			}
+
+			void set_limits(std::size_t max_entries, std::size_t max_bytes) noexcept {
+				m_max_entries = max_entries;
+				m_max_bytes = max_bytes;
+			}
+
+			interned_string_stats stats() const noexcept {
+				return interned_string_stats {
+					m_by_address.size() + m_by_contents.size(), m_bytes, m_hits, m_misses, m_rejected, m_max_entries, m_max_bytes
+				};
+			}
+		};
+
+		inline const void* interned_strings_registry_key() noexcept {
+			static const char key = 0;
+			return static_cast<const void*>(&key);
+		}
+
+		// bumped whenever a cache dies, so no thread trusts a remembered one afterwards
+		inline std::atomic<std::size_t>& interned_string_cache_epoch() noexcept {
+			static std::atomic<std::size_t> epoch { 0 };
+			return epoch;
+		}
+
+		struct interned_string_cache_memo {
+			const void* registry;
+			std::size_t epoch;
+			interned_string_cache* cache;
+		};
+
+		inline interned_string_cache_memo& last_interned_string_cache() noexcept {
+			static thread_local interned_string_cache_memo memo { nullptr, 0, nullptr };
+			return memo;
+		}
+
+		inline int destroy_interned_string_cache(lua_State* L) {
+			// the registry is going away with the state: the references need no releasing
+			static_cast<interned_string_cache*>(lua_touserdata(L, 1))->~interned_string_cache();
+			interned_string_cache_epoch().fetch_add(1, std::memory_order_release);
+			return 0;
+		}
+
+		inline interned_string_cache* find_interned_string_cache(lua_State* L, bool create) {
+			// the registry table is one per state, so its address names the state
+			// without a lookup: most pushes come from the same state as the last one
+			const void* registry = lua_topointer(L, LUA_REGISTRYINDEX);
+			std::size_t epoch = interned_string_cache_epoch().load(std::memory_order_acquire);
+			interned_string_cache_memo& memo = last_interned_string_cache();
+			if (memo.registry == registry && memo.epoch == epoch) {
+				return memo.cache;
+			}
+			lua_rawgetp(L, LUA_REGISTRYINDEX, interned_strings_registry_key());
+			void* memory = lua_touserdata(L, -1);
+			lua_pop(L, 1);
+			if (memory == nullptr) {
+				if (!create) {
+					return nullptr;
+				}
+				memory = lua_newuserdata(L, sizeof(interned_string_cache));
+				new (memory) interned_string_cache();
+				lua_newtable(L);
+				lua_pushcfunction(L, &destroy_interned_string_cache);
+				lua_setfield(L, -2, "__gc");
+				lua_setmetatable(L, -2);
+				lua_rawsetp(L, LUA_REGISTRYINDEX, interned_strings_registry_key());
+			}
+			memo = interned_string_cache_memo { registry, epoch, static_cast<interned_string_cache*>(memory) };
+			return memo.cache;
+		}
+	} // namespace detail
+
+	inline interned_string_stats interned_strings_stats(lua_State* L) {
+		detail::interned_string_cache* cache = detail::find_interned_string_cache(L, false);
+		return cache == nullptr ? detail::interned_string_cache().stats() : cache->stats();
+	}
+
+	// unpins every cached string; the counters keep running
+	inline void clear_interned_strings(lua_State* L) {
+		detail::interned_string_cache* cache = detail::find_interned_string_cache(L, false);
+		if (cache != nullptr) {
+			cache->clear(L);
+		}
+	}
+
+	// lowering the limits unpins nothing: the cache just stops growing until it is cleared
+	inline void set_interned_string_limits(lua_State* L, std::size_t max_entries, std::size_t max_bytes) {
+		detail::find_interned_string_cache(L, true)->set_limits(max_entries, max_bytes);
+	}
+
+	namespace stack {
+		template <typename T>
+		struct unqualified_pusher<interned_t<T>> {
+			static int push(lua_State* L, const interned_t<T>& s) {
+#if SOL_IS_ON(SOL_SAFE_STACK_CHECK)
+				luaL_checkstack(L, 2, detail::not_enough_stack_space_string);
+#endif // make sure stack doesn't overflow
+				if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+					if (s.value() == nullptr) {
+						return stack::push(L, lua_nil);
+					}
+					detail::find_interned_string_cache(L, true)->push(L, static_cast<const char*>(s.value()));
+				}
+				else {
+					detail::find_interned_string_cache(L, true)->push(L, string_view(s.value()));
+				}
+				return 1;
+			}
+		};
+	} // namespace stack
+} // namespace sol
+
+#endif // SOL_INTERNED_HPP
@@ -0,0 +1,156 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_ISOLATED_THREAD_HPP
+#define SOL_ISOLATED_THREAD_HPP
+
+#include <sol/state_view.hpp>
+#include <sol/thread.hpp>
+#include <sol/environment.hpp>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace sol {
+
+	// A reusable Lua thread of a shared, already set up state, for running one request's scripts at a time.
+	// Each request gets a fresh environment whose reads fall through to the shared globals
+	// while its writes stay in the environment; reset() throws the environment and the stack away.
+	class isolated_thread {
+	private:
+		lua_State* m_L;
+		reference m_shared_metatable;
+		thread m_thread;
+		lua_State* m_thread_L;
+		environment m_env;
+		std::size_t m_resets;
+
+		void m_new_environment() {
+			// one table per request: the metatable pointing at the shared globals is made once;
+			// _G names the environment itself, so `_G.x = 1` stays in the request too
+			lua_createtable(m_L, 0, 1);
+			lua_pushvalue(m_L, -1);
+			lua_setfield(m_L, -2, "_G");
+			m_shared_metatable.push(m_L);
+			lua_setmetatable(m_L, -2);
+			m_env = environment(m_L, -1);
+			lua_pop(m_L, 1);
+		}
+
+		void m_new_thread() {
+			m_thread = thread::create(m_L);
+			m_thread_L = m_thread.thread_state();
+		}
+
+	public:
+		// `shared` is what unknown globals are read from; it is the global table unless given
+		explicit isolated_thread(lua_State* L) : isolated_thread(L, state_view(L).globals()) {
+		}
+
+		template <typename Ref, meta::enable<is_lua_reference<meta::unqualified_t<Ref>>> = meta::enabler>
+		isolated_thread(lua_State* L, const Ref& shared)
+		: m_L(L), m_shared_metatable(), m_thread(), m_thread_L(nullptr), m_env(), m_resets(0) {
+			// __metatable hides the metatable from getmetatable/setmetatable, so a request
+			// can neither swap the shared globals out nor write to them through __index
+			lua_createtable(m_L, 0, 2);
+			shared.push(m_L);
+			lua_setfield(m_L, -2, to_string(meta_function::index).c_str());
+			lua_pushboolean(m_L, 0);
+			lua_setfield(m_L, -2, to_string(meta_function::metatable).c_str());
+			m_shared_metatable = reference(m_L, -1);
+			lua_pop(m_L, 1);
+			m_new_thread();
+			m_new_environment();
+		}
+
+		isolated_thread(const isolated_thread&) = delete;
+		isolated_thread& operator=(const isolated_thread&) = delete;
+		isolated_thread(isolated_thread&&) = default;
+		isolated_thread& operator=(isolated_thread&&) = default;
+
+		template <typename Fx,
+		     meta::disable_any<meta::is_string_constructible<meta::unqualified_t<Fx>>,
+		          meta::is_specialization_of<meta::unqualified_t<Fx>, basic_environment>> = meta::enabler>
+		protected_function_result safe_script(
+		     const string_view& code, Fx&& on_error, const std::string& chunkname = detail::default_chunk_name(), load_mode mode = load_mode::any) {
+			return state().safe_script(code, m_env, std::forward<Fx>(on_error), chunkname, mode);
+		}
+
+		protected_function_result safe_script(
+		     const string_view& code, const std::string& chunkname = detail::default_chunk_name(), load_mode mode = load_mode::any) {
+			return state().safe_script(code, m_env, chunkname, mode);
+		}
+
+		template <typename Fx>
+		protected_function_result safe_script_file(const std::string& filename, Fx&& on_error, load_mode mode = load_mode::any) {
+			return state().safe_script_file(filename, m_env, std::forward<Fx>(on_error), mode);
+		}
+
+		protected_function_result safe_script_file(const std::string& filename, load_mode mode = load_mode::any) {
+			return state().safe_script_file(filename, m_env, mode);
+		}
+
+		// drops the request's environment and anything left on the thread's stack;
+		// every result obtained from this thread must be gone by now
+		void reset() {
+			lua_settop(m_thread_L, 0);
+			if (lua_status(m_thread_L) != LUA_OK) {
+				// an error escaped a resume: the thread cannot be used as it is
+#if SOL_LUA_VERSION_I_ >= 504
+				lua_resetthread(m_thread_L);
+#else
+				m_new_thread();
+#endif
+			}
+			m_new_environment();
+			++m_resets;
+		}
+
+		// the globals of the current request
+		const environment& env() const noexcept {
+			return m_env;
+		}
+
+		// a view of the thread itself, for calling functions and reading results on it
+		state_view state() const noexcept {
+			return state_view(m_thread_L);
+		}
+
+		lua_State* thread_state() const noexcept {
+			return m_thread_L;
+		}
+
+		lua_State* lua_state() const noexcept {
+			return m_L;
+		}
+
+		std::size_t resets() const noexcept {
+			return m_resets;
+		}
+	};
+
+} // namespace sol
+
+#endif // SOL_ISOLATED_THREAD_HPP
@@ -0,0 +1,147 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this Spermission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_LUA_BUFFER_HPP
+#define SOL_LUA_BUFFER_HPP
+
+#include <sol/stack.hpp>
+
+#include <cstddef>
+#include <utility>
+
+namespace sol {
+
+	// Appends straight into a luaL_Buffer, so the bytes are produced
+	// in memory Lua owns instead of a C++ container that gets copied afterwards.
+	// While it is alive nothing else may push onto or pop from the Lua stack.
+	class lua_buffer {
+	public:
+		explicit lua_buffer(luaL_Buffer& buffer_) noexcept : m_buffer(&buffer_), m_size(0) {
+		}
+
+		// space for at least `count` bytes: fill some of it, then commit() what was written
+		char* prepare(std::size_t count) {
+			return luaL_prepbuffsize(m_buffer, count);
+		}
+
+		void commit(std::size_t count) {
+			luaL_addsize(m_buffer, count);
+			m_size += count;
+		}
+
+		void write(const void* data, std::size_t count) {
+			luaL_addlstring(m_buffer, static_cast<const char*>(data), count);
+			m_size += count;
+		}
+
+		void write(string_view data) {
+			write(data.data(), data.size());
+		}
+
+		void push_back(char value) {
+			luaL_addchar(m_buffer, value);
+			++m_size;
+		}
+
+		std::size_t size() const noexcept {
+			return m_size;
+		}
+
+		luaL_Buffer& buffer() noexcept {
+			return *m_buffer;
+		}
+
+	private:
+		luaL_Buffer* m_buffer;
+		std::size_t m_size;
+	};
+
+	// Returned from a bound function: `writer(sol::lua_buffer&)` runs when the result
+	// is pushed and whatever it wrote becomes the Lua string returned to the caller.
+	template <typename F>
+	class lua_buffer_writer {
+	public:
+		lua_buffer_writer(F writer_) : m_writer(std::move(writer_)), m_size_hint(0) {
+		}
+
+		lua_buffer_writer(std::size_t size_hint_, F writer_) : m_writer(std::move(writer_)), m_size_hint(size_hint_) {
+		}
+
+		std::size_t size_hint() const noexcept {
+			return m_size_hint;
+		}
+
+		void write(lua_buffer& out) {
+			m_writer(out);
+		}
+
+	private:
+		F m_writer;
+		std::size_t m_size_hint;
+	};
+
+	template <typename F>
+	lua_buffer_writer(F) -> lua_buffer_writer<F>;
+
+	template <typename F>
+	lua_buffer_writer(std::size_t, F) -> lua_buffer_writer<F>;
+
+	// the writer usually reads from arguments that still live on the stack
+	// (string_view, std::span): do not clear them out before it runs
+	template <typename F>
+	struct is_stack_based<lua_buffer_writer<F>> : std::true_type { };
+
+	namespace detail {
+		template <typename F>
+		struct lua_type_of<lua_buffer_writer<F>> : std::integral_constant<type, type::string> { };
+	} // namespace detail
+
+	namespace stack {
+		template <typename F>
+		struct unqualified_pusher<lua_buffer_writer<F>> {
+			static int push(lua_State* L, lua_buffer_writer<F>& writer) {
+#if SOL_IS_ON(SOL_SAFE_STACK_CHECK)
+				// the buffer's box plus the resulting string
+				luaL_checkstack(L, 2, detail::not_enough_stack_space_string);
+#endif // make sure stack doesn't overflow
+				luaL_Buffer b;
+				luaL_buffinit(L, &b);
+				if (writer.size_hint() > 0) {
+					// reserve everything up front: one allocation, no regrowth
+					(void)luaL_prepbuffsize(&b, writer.size_hint());
+				}
+				lua_buffer out(b);
+				writer.write(out);
+				luaL_pushresult(&b);
+				return 1;
+			}
+
+			static int push(lua_State* L, lua_buffer_writer<F>&& writer) {
+				return push(L, writer);
+			}
+		};
+	} // namespace stack
+
+} // namespace sol
+
+#endif // SOL_LUA_BUFFER_HPP
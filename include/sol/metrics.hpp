@@ -0,0 +1,436 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_METRICS_HPP
+#define SOL_METRICS_HPP
+
+#include <sol/compatibility.hpp>
+#include <sol/demangle.hpp>
+#include <sol/external_memory.hpp>
+#include <sol/string_view.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sol {
+
+	struct usertype_metrics {
+		// the demangled C++ type name
+		std::string name;
+		// objects owned by Lua right now: created and not yet collected or disposed of
+		std::int64_t live;
+		// objects created since the program started
+		std::uint64_t created;
+	};
+
+	// a snapshot of one state, plus the process-wide counters sol2 keeps
+	struct state_metrics {
+		// of the state
+		std::size_t heap_bytes = 0;
+		std::size_t external_bytes = 0;
+		bool gc_running = false;
+		std::uint64_t gc_cycles = 0;
+		std::uint64_t gc_steps = 0;
+		double gc_step_seconds = 0.0;
+		std::size_t registry_references = 0;
+
+		// of the whole program: zero when SOL_METRICS is off
+		std::uint64_t closures_created = 0;
+		std::uint64_t protected_call_errors = 0;
+		std::uint64_t threads_created = 0;
+		std::uint64_t coroutine_resumes = 0;
+		std::uint64_t coroutine_errors = 0;
+		std::vector<usertype_metrics> usertypes;
+	};
+
+	namespace detail {
+		enum class runtime_counter : std::size_t {
+			closures_created,
+			protected_call_errors,
+			threads_created,
+			coroutine_resumes,
+			coroutine_errors,
+			count
+		};
+
+		inline std::atomic<std::uint64_t>* runtime_counters() noexcept {
+			static std::atomic<std::uint64_t> counters[static_cast<std::size_t>(runtime_counter::count)] {};
+			return counters;
+		}
+
+		// one relaxed increment: nothing is ordered by these, they are only ever summed up
+		inline void count_runtime_event(runtime_counter which) noexcept {
+#if SOL_IS_ON(SOL_METRICS)
+			runtime_counters()[static_cast<std::size_t>(which)].fetch_add(1, std::memory_order_relaxed);
+#else
+			(void)which;
+#endif
+		}
+
+		inline void count_coroutine_resume(int status) noexcept {
+			count_runtime_event(runtime_counter::coroutine_resumes);
+			if (status != LUA_OK && status != LUA_YIELD) {
+				count_runtime_event(runtime_counter::coroutine_errors);
+			}
+		}
+
+		struct usertype_counter;
+
+		inline std::atomic<usertype_counter*>& usertype_counters() noexcept {
+			static std::atomic<usertype_counter*> head { nullptr };
+			return head;
+		}
+
+		// one per type, created the first time an object of that type is handed to Lua
+		// and never destroyed: the list only ever grows, so reading it needs no lock
+		struct usertype_counter {
+			const std::string& name;
+			std::atomic<std::int64_t> live;
+			std::atomic<std::uint64_t> created;
+			usertype_counter* next;
+
+			explicit usertype_counter(const std::string& name_) noexcept : name(name_), live(0), created(0), next(nullptr) {
+				std::atomic<usertype_counter*>& head = usertype_counters();
+				next = head.load(std::memory_order_relaxed);
+				while (!head.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed)) {
+				}
+			}
+		};
+
+		template <typename T>
+		usertype_counter& usertype_counter_of() {
+			static usertype_counter counter(demangle<T>());
+			return counter;
+		}
+
+		template <typename T>
+		void count_usertype_created() {
+#if SOL_IS_ON(SOL_METRICS)
+			usertype_counter& counter = usertype_counter_of<std::remove_cv_t<T>>();
+			counter.created.fetch_add(1, std::memory_order_relaxed);
+			counter.live.fetch_add(1, std::memory_order_relaxed);
+#endif
+		}
+
+		template <typename T>
+		void count_usertype_destroyed() {
+#if SOL_IS_ON(SOL_METRICS)
+			usertype_counter_of<std::remove_cv_t<T>>().live.fetch_sub(1, std::memory_order_relaxed);
+#endif
+		}
+
+		struct metrics_ledger {
+			std::uint64_t gc_cycles;
+			std::uint64_t gc_steps;
+			std::uint64_t gc_step_nanoseconds;
+		};
+
+		inline const void* metrics_registry_key() noexcept {
+			static const char key = 0;
+			return static_cast<const void*>(&key);
+		}
+
+		inline metrics_ledger* find_metrics_ledger(lua_State* L) {
+			lua_rawgetp(L, LUA_REGISTRYINDEX, metrics_registry_key());
+			void* memory = lua_touserdata(L, -1);
+			lua_pop(L, 1);
+			return static_cast<metrics_ledger*>(memory);
+		}
+
+		inline void make_gc_canary(lua_State* L, int metatable_index) {
+			lua_newuserdata(L, 1);
+			lua_pushvalue(L, metatable_index);
+			lua_setmetatable(L, -2);
+			lua_pop(L, 1);
+		}
+
+		// Lua has no hook for the end of a cycle, but it finalizes every unreachable
+		// object once per cycle: an object nobody holds, whose finalizer counts and
+		// leaves another one behind, is collected exactly once per cycle
+		inline int metrics_gc_canary(lua_State* L) {
+			metrics_ledger& ledger = *static_cast<metrics_ledger*>(lua_touserdata(L, lua_upvalueindex(1)));
+			++ledger.gc_cycles;
+			make_gc_canary(L, lua_upvalueindex(2));
+			return 0;
+		}
+
+		inline metrics_ledger& track_state_metrics(lua_State* L) {
+			metrics_ledger* ledger = find_metrics_ledger(L);
+			if (ledger != nullptr) {
+				return *ledger;
+			}
+			void* memory = lua_newuserdata(L, sizeof(metrics_ledger));
+			ledger = new (memory) metrics_ledger { 0, 0, 0 };
+			int ledger_index = lua_gettop(L);
+			lua_newtable(L);
+			int metatable_index = lua_gettop(L);
+			lua_pushvalue(L, ledger_index);
+			lua_pushvalue(L, metatable_index);
+			lua_pushcclosure(L, &metrics_gc_canary, 2);
+			lua_setfield(L, metatable_index, "__gc");
+			make_gc_canary(L, metatable_index);
+			lua_pop(L, 1);
+			lua_rawsetp(L, LUA_REGISTRYINDEX, metrics_registry_key());
+			return *ledger;
+		}
+
+		// times a collector call made through sol2, if the state is being tracked
+		class gc_step_timer {
+		private:
+			metrics_ledger* m_ledger;
+			std::chrono::steady_clock::time_point m_start;
+
+		public:
+			explicit gc_step_timer(lua_State* L) : m_ledger(find_metrics_ledger(L)), m_start() {
+				if (m_ledger != nullptr) {
+					m_start = std::chrono::steady_clock::now();
+				}
+			}
+
+			gc_step_timer(const gc_step_timer&) = delete;
+			gc_step_timer& operator=(const gc_step_timer&) = delete;
+
+			~gc_step_timer() {
+				if (m_ledger == nullptr) {
+					return;
+				}
+				std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - m_start;
+				++m_ledger->gc_steps;
+				m_ledger->gc_step_nanoseconds += static_cast<std::uint64_t>(elapsed.count());
+			}
+		};
+
+		// slots handed out by luaL_ref on the registry and not yet released
+		inline std::size_t registry_references(lua_State* L) {
+#if SOL_LUA_VERSION_I_ >= 502
+			const lua_Integer reserved = LUA_RIDX_LAST;
+#else
+			const lua_Integer reserved = 0;
+#endif
+#if SOL_LUA_VERSION_I_ >= 504 && defined(LUA_VERSION_RELEASE_NUM) && LUA_VERSION_RELEASE_NUM >= 50403
+			const lua_Integer freelist = LUA_RIDX_LAST + 1;
+#else
+			const lua_Integer freelist = 0;
+#endif
+			std::size_t slots = 0;
+			lua_pushnil(L);
+			while (lua_next(L, LUA_REGISTRYINDEX) != 0) {
+				if (lua_type(L, -2) == LUA_TNUMBER) {
+					lua_Number key = lua_tonumber(L, -2);
+					if (key > static_cast<lua_Number>(reserved) && key != static_cast<lua_Number>(freelist)
+					     && key == static_cast<lua_Number>(static_cast<lua_Integer>(key))) {
+						++slots;
+					}
+				}
+				lua_pop(L, 1);
+			}
+			// released slots stay in the registry, chained through their values
+			std::size_t released = 0;
+			lua_rawgeti(L, LUA_REGISTRYINDEX, freelist);
+			lua_Integer next = lua_type(L, -1) == LUA_TNUMBER ? static_cast<lua_Integer>(lua_tonumber(L, -1)) : 0;
+			lua_pop(L, 1);
+			while (next > reserved && released < slots) {
+				++released;
+				lua_rawgeti(L, LUA_REGISTRYINDEX, next);
+				next = lua_type(L, -1) == LUA_TNUMBER ? static_cast<lua_Integer>(lua_tonumber(L, -1)) : 0;
+				lua_pop(L, 1);
+			}
+			return slots - released;
+		}
+
+		inline void openmetrics_family(std::string& out, const std::string& name, const char* type, const char* unit, const char* help) {
+			out += "# TYPE ";
+			out += name;
+			out += ' ';
+			out += type;
+			out += '\n';
+			if (unit != nullptr) {
+				out += "# UNIT ";
+				out += name;
+				out += ' ';
+				out += unit;
+				out += '\n';
+			}
+			out += "# HELP ";
+			out += name;
+			out += ' ';
+			out += help;
+			out += '\n';
+		}
+
+		inline void openmetrics_label_value(std::string& out, string_view value) {
+			for (char c : value) {
+				switch (c) {
+				case '\\':
+					out += "\\\\";
+					break;
+				case '"':
+					out += "\\\"";
+					break;
+				case '\n':
+					out += "\\n";
+					break;
+				default:
+					out += c;
+					break;
+				}
+			}
+		}
+
+		inline void openmetrics_number(std::string& out, double value) {
+			char buffer[32];
+			int written = std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+			out.append(buffer, static_cast<std::size_t>(written > 0 ? written : 0));
+		}
+
+		template <typename N>
+		void openmetrics_sample(std::string& out, const std::string& name, const char* suffix, const std::string& labels, N value) {
+			out += name;
+			out += suffix;
+			if (!labels.empty()) {
+				out += '{';
+				out += labels;
+				out += '}';
+			}
+			out += ' ';
+			if constexpr (std::is_floating_point_v<N>) {
+				openmetrics_number(out, value);
+			}
+			else {
+				out += std::to_string(value);
+			}
+			out += '\n';
+		}
+	} // namespace detail
+
+	// GC cycles are counted from the first snapshot of a state,
+	// or from its construction when it is a sol::state and SOL_METRICS is on
+	inline state_metrics collect_metrics(lua_State* L) {
+		state_metrics metrics;
+		detail::metrics_ledger& ledger = detail::track_state_metrics(L);
+		metrics.heap_bytes = static_cast<std::size_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + static_cast<std::size_t>(lua_gc(L, LUA_GCCOUNTB, 0));
+		metrics.external_bytes = external_memory_used(L);
+#if SOL_LUA_VERSION_I_ >= 502
+		metrics.gc_running = lua_gc(L, LUA_GCISRUNNING, 0) == 1;
+#else
+		metrics.gc_running = true;
+#endif
+		metrics.gc_cycles = ledger.gc_cycles;
+		metrics.gc_steps = ledger.gc_steps;
+		metrics.gc_step_seconds = static_cast<double>(ledger.gc_step_nanoseconds) / 1e9;
+		metrics.registry_references = detail::registry_references(L);
+
+		const std::atomic<std::uint64_t>* counters = detail::runtime_counters();
+		auto counter = [counters](detail::runtime_counter which) {
+			return counters[static_cast<std::size_t>(which)].load(std::memory_order_relaxed);
+		};
+		metrics.closures_created = counter(detail::runtime_counter::closures_created);
+		metrics.protected_call_errors = counter(detail::runtime_counter::protected_call_errors);
+		metrics.threads_created = counter(detail::runtime_counter::threads_created);
+		metrics.coroutine_resumes = counter(detail::runtime_counter::coroutine_resumes);
+		metrics.coroutine_errors = counter(detail::runtime_counter::coroutine_errors);
+
+		for (const detail::usertype_counter* node = detail::usertype_counters().load(std::memory_order_acquire); node != nullptr;
+		     node = node->next) {
+			metrics.usertypes.push_back(
+			     usertype_metrics { node->name, node->live.load(std::memory_order_relaxed), node->created.load(std::memory_order_relaxed) });
+		}
+		std::sort(metrics.usertypes.begin(), metrics.usertypes.end(), [](const usertype_metrics& left, const usertype_metrics& right) {
+			return left.name < right.name;
+		});
+		return metrics;
+	}
+
+	// the OpenMetrics text exposition of a snapshot, "# EOF" line included;
+	// labels (such as `state="ai"`) are added to every sample as they are
+	inline std::string to_openmetrics(const state_metrics& metrics, const std::string& prefix = "sol", const std::string& labels = "") {
+		std::string out;
+		auto gauge = [&](const char* name, const char* unit, const char* help, auto value) {
+			std::string family = prefix + name;
+			detail::openmetrics_family(out, family, "gauge", unit, help);
+			detail::openmetrics_sample(out, family, "", labels, value);
+		};
+		auto counter = [&](const char* name, const char* unit, const char* help, auto value) {
+			std::string family = prefix + name;
+			detail::openmetrics_family(out, family, "counter", unit, help);
+			detail::openmetrics_sample(out, family, "_total", labels, value);
+		};
+
+		gauge("_heap_bytes", "bytes", "Bytes allocated by the Lua state.", metrics.heap_bytes);
+		gauge("_external_bytes", "bytes", "Bytes reported as held by usertypes outside of the Lua heap.", metrics.external_bytes);
+		gauge("_gc_running", nullptr, "Whether the garbage collector is running.", metrics.gc_running ? 1 : 0);
+		counter("_gc_cycles", nullptr, "Garbage collection cycles completed.", metrics.gc_cycles);
+		counter("_gc_steps", nullptr, "Garbage collector calls made through sol2.", metrics.gc_steps);
+		counter("_gc_step_seconds", "seconds", "Time spent in garbage collector calls made through sol2.", metrics.gc_step_seconds);
+		gauge("_registry_references", nullptr, "Live references held in the registry.", metrics.registry_references);
+		counter("_closures_created", nullptr, "Closures created for bound C++ functions.", metrics.closures_created);
+		counter("_protected_call_errors", nullptr, "Protected function calls that returned an error.", metrics.protected_call_errors);
+		counter("_threads_created", nullptr, "Threads created through sol2.", metrics.threads_created);
+		counter("_coroutine_resumes", nullptr, "Coroutine resumptions made through sol2.", metrics.coroutine_resumes);
+		counter("_coroutine_errors", nullptr, "Coroutine resumptions that ended in an error.", metrics.coroutine_errors);
+
+		std::string live = prefix + "_usertype_live_objects";
+		detail::openmetrics_family(out, live, "gauge", nullptr, "Usertype objects currently owned by Lua.");
+		for (const usertype_metrics& usertype : metrics.usertypes) {
+			out += live;
+			out += '{';
+			if (!labels.empty()) {
+				out += labels;
+				out += ',';
+			}
+			out += "type=\"";
+			detail::openmetrics_label_value(out, usertype.name);
+			out += "\"} ";
+			out += std::to_string(usertype.live);
+			out += '\n';
+		}
+		std::string allocations = prefix + "_usertype_allocations";
+		detail::openmetrics_family(out, allocations, "counter", nullptr, "Usertype objects handed to Lua.");
+		for (const usertype_metrics& usertype : metrics.usertypes) {
+			out += allocations;
+			out += "_total{";
+			if (!labels.empty()) {
+				out += labels;
+				out += ',';
+			}
+			out += "type=\"";
+			detail::openmetrics_label_value(out, usertype.name);
+			out += "\"} ";
+			out += std::to_string(usertype.created);
+			out += '\n';
+		}
+		out += "# EOF\n";
+		return out;
+	}
+
+} // namespace sol
+
+#endif // SOL_METRICS_HPP
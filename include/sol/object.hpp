@@ -96,6 +96,8 @@ namespace sol {
 		}
 		basic_object(lua_State* L_, ref_index index_) noexcept : base_t(L_, index_) {
 		}
+		basic_object(lua_State* L_, detail::borrowed_index index_) noexcept : base_t(L_, index_) {
+		}
 		template <typename T, typename... Args>
 		basic_object(lua_State* L_, in_place_type_t<T>, Args&&... args) noexcept
 		: basic_object(std::integral_constant<bool, !is_stack_based<base_t>::value>(), L_, -stack::push<T>(L_, std::forward<Args>(args)...)) {
@@ -0,0 +1,365 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_PACKAGE_INDEX_HPP
+#define SOL_PACKAGE_INDEX_HPP
+
+#include <sol/state_view.hpp>
+#include <sol/error.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#if SOL_IS_ON(SOL_STD_FILESYSTEM)
+#include <filesystem>
+#endif
+
+namespace sol {
+
+	// Maps module names to files once, so require never has to probe package.path.
+	// Modules come from explicit entries, manifests, or a directory walk; names that are
+	// not indexed can still be probed against path templates, with both found paths and
+	// misses cached. One index may serve any number of states on any number of threads.
+	class package_index {
+	private:
+		mutable std::shared_mutex m_mutex;
+		std::unordered_map<std::string, std::string> m_indexed;
+		std::unordered_map<std::string, std::string> m_found;
+		std::unordered_set<std::string> m_missing;
+		std::vector<std::string> m_templates;
+		std::atomic<std::size_t> m_hits;
+		std::atomic<std::size_t> m_misses;
+		std::atomic<std::size_t> m_probes;
+
+		optional<std::string> probe(const std::string& name, const std::vector<std::string>& templates) {
+			std::string module_path = name;
+			for (char& c : module_path) {
+				if (c == '.') {
+					c = '/';
+				}
+			}
+			for (const std::string& path_template : templates) {
+				std::string filename;
+				filename.reserve(path_template.size() + module_path.size());
+				for (char c : path_template) {
+					if (c == '?') {
+						filename += module_path;
+					}
+					else {
+						filename += c;
+					}
+				}
+				m_probes.fetch_add(1, std::memory_order_relaxed);
+				if (std::FILE* file = std::fopen(filename.c_str(), "r")) {
+					std::fclose(file);
+					return filename;
+				}
+			}
+			return nullopt;
+		}
+
+		int search(lua_State* L, const char* name) {
+			optional<std::string> path = resolve(name);
+			if (!path) {
+#if SOL_LUA_VERSION_I_ >= 504
+				lua_pushfstring(L, "no indexed module '%s'", name);
+#else
+				lua_pushfstring(L, "\n\tno indexed module '%s'", name);
+#endif
+				return 1;
+			}
+			if (detail::load_source_file(L, *path) != LUA_OK) {
+				lua_pushfstring(L, "error loading module '%s' from file '%s':\n\t%s", name, path->c_str(), lua_tostring(L, -1));
+				return -1;
+			}
+			lua_pushlstring(L, path->data(), path->size());
+			return 2;
+		}
+
+		static int lua_search(lua_State* L) {
+			package_index& self = *static_cast<package_index*>(lua_touserdata(L, lua_upvalueindex(1)));
+			const char* name = lua_tostring(L, 1);
+			int results = 0;
+			if (name == nullptr) {
+				lua_pushstring(L, "sol: package_index: module name must be a string");
+				results = -1;
+			}
+			else {
+				results = self.search(L, name);
+			}
+			if (results < 0) {
+				// raised out here, with nothing left to unwind
+				return lua_error(L);
+			}
+			return results;
+		}
+
+	public:
+		package_index() : m_mutex(), m_indexed(), m_found(), m_missing(), m_templates(), m_hits(0), m_misses(0), m_probes(0) {
+		}
+		package_index(const package_index&) = delete;
+		package_index& operator=(const package_index&) = delete;
+
+		// the first entry for a name wins, as it would for the first matching package.path template
+		bool add_module(std::string name, std::string path) {
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			m_missing.erase(name);
+			m_found.erase(name);
+			return m_indexed.emplace(std::move(name), std::move(path)).second;
+		}
+
+		// one "module.name path/to/file.lua" per line; '#' starts a comment,
+		// and relative paths are taken relative to the manifest's directory
+		std::size_t add_manifest(const std::string& manifest_path) {
+			std::string contents;
+			if (!detail::read_whole_file(manifest_path, contents)) {
+				return 0;
+			}
+			std::string directory;
+			std::size_t last_separator = manifest_path.find_last_of("/\\");
+			if (last_separator != std::string::npos) {
+				directory = manifest_path.substr(0, last_separator + 1);
+			}
+			const char* whitespace = " \t\r";
+			std::size_t added = 0;
+			string_view remaining(contents);
+			while (!remaining.empty()) {
+				std::size_t newline = remaining.find('\n');
+				string_view line = remaining.substr(0, newline);
+				remaining.remove_prefix(newline == string_view::npos ? remaining.size() : newline + 1);
+				line = line.substr(0, line.find('#'));
+				std::size_t name_first = line.find_first_not_of(whitespace);
+				if (name_first == string_view::npos) {
+					continue;
+				}
+				std::size_t name_last = line.find_first_of(whitespace, name_first);
+				std::size_t path_first = line.find_first_not_of(whitespace, name_last);
+				if (name_last == string_view::npos || path_first == string_view::npos) {
+					continue;
+				}
+				std::size_t path_last = line.find_last_not_of(whitespace);
+				string_view path = line.substr(path_first, path_last + 1 - path_first);
+				bool absolute = path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':');
+				std::string full_path = absolute ? std::string(path) : directory + std::string(path);
+				if (add_module(std::string(line.substr(name_first, name_last - name_first)), std::move(full_path))) {
+					++added;
+				}
+			}
+			return added;
+		}
+
+#if SOL_IS_ON(SOL_STD_FILESYSTEM)
+		// walks root once; a/b.lua becomes "a.b", and a/init.lua becomes "a" unless a.lua exists
+		std::size_t add_directory(const std::string& root, const std::string& extension = ".lua") {
+			namespace fs = std::filesystem;
+			std::error_code ec;
+			fs::path root_path(root);
+			std::vector<std::pair<std::string, std::string>> modules;
+			std::vector<std::pair<std::string, std::string>> init_modules;
+			for (fs::recursive_directory_iterator it(root_path, ec), last; !ec && it != last; it.increment(ec)) {
+				const fs::directory_entry& entry = *it;
+				if (!entry.is_regular_file(ec) || entry.path().extension().string() != extension) {
+					continue;
+				}
+				fs::path relative = entry.path().lexically_relative(root_path);
+				relative.replace_extension();
+				std::string name;
+				for (const fs::path& part : relative) {
+					if (!name.empty()) {
+						name += '.';
+					}
+					name += part.string();
+				}
+				bool is_init = relative.filename() == "init";
+				if (is_init && relative.has_parent_path()) {
+					name.resize(name.size() - 5);
+					init_modules.emplace_back(std::move(name), entry.path().string());
+				}
+				else {
+					modules.emplace_back(std::move(name), entry.path().string());
+				}
+			}
+			std::size_t added = 0;
+			for (auto& module : modules) {
+				added += add_module(std::move(module.first), std::move(module.second)) ? 1 : 0;
+			}
+			for (auto& module : init_modules) {
+				added += add_module(std::move(module.first), std::move(module.second)) ? 1 : 0;
+			}
+			return added;
+		}
+#endif
+
+		// package.path-style templates ("./?.lua;./?/init.lua") probed for names that are not indexed
+		void set_search_path(const std::string& templates) {
+			std::vector<std::string> split;
+			std::size_t first = 0;
+			while (first <= templates.size()) {
+				std::size_t last = templates.find(';', first);
+				if (last == std::string::npos) {
+					last = templates.size();
+				}
+				if (last > first) {
+					split.emplace_back(templates, first, last - first);
+				}
+				first = last + 1;
+			}
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			m_templates = std::move(split);
+			m_found.clear();
+			m_missing.clear();
+		}
+
+		optional<std::string> resolve(const std::string& name) {
+			std::vector<std::string> templates;
+			{
+				std::shared_lock<std::shared_mutex> lock(m_mutex);
+				auto indexed = m_indexed.find(name);
+				if (indexed != m_indexed.cend()) {
+					m_hits.fetch_add(1, std::memory_order_relaxed);
+					return indexed->second;
+				}
+				auto found = m_found.find(name);
+				if (found != m_found.cend()) {
+					m_hits.fetch_add(1, std::memory_order_relaxed);
+					return found->second;
+				}
+				if (m_templates.empty() || m_missing.find(name) != m_missing.cend()) {
+					m_misses.fetch_add(1, std::memory_order_relaxed);
+					return nullopt;
+				}
+				templates = m_templates;
+			}
+			// the filesystem is touched without the lock held; racing probes agree on the answer
+			optional<std::string> path = probe(name, templates);
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			if (path) {
+				m_found.emplace(name, *path);
+			}
+			else {
+				m_misses.fetch_add(1, std::memory_order_relaxed);
+				m_missing.insert(name);
+			}
+			return path;
+		}
+
+		bool contains(const std::string& name) const {
+			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			return m_indexed.find(name) != m_indexed.cend() || m_found.find(name) != m_found.cend();
+		}
+
+		std::size_t size() const {
+			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			return m_indexed.size();
+		}
+
+		// forgets what probing found or did not find, e.g. after files were added on disk
+		void clear_cache() {
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			m_found.clear();
+			m_missing.clear();
+		}
+
+		void clear() {
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			m_indexed.clear();
+			m_found.clear();
+			m_missing.clear();
+		}
+
+		std::size_t hits() const noexcept {
+			return m_hits.load(std::memory_order_relaxed);
+		}
+
+		std::size_t misses() const noexcept {
+			return m_misses.load(std::memory_order_relaxed);
+		}
+
+		// how many files were opened to probe templates, over the life of the index
+		std::size_t probes() const noexcept {
+			return m_probes.load(std::memory_order_relaxed);
+		}
+
+		closure<void*> searcher() {
+			return make_closure(&package_index::lua_search, static_cast<void*>(this));
+		}
+
+		// puts the searcher right after package.preload's, ahead of the package.path one;
+		// returns false if the package library is not open in L
+		bool install(lua_State* L) {
+			lua_getglobal(L, "package");
+			if (lua_type(L, -1) != LUA_TTABLE) {
+				lua_pop(L, 1);
+				return false;
+			}
+#if SOL_LUA_VERSION_I_ <= 501
+			lua_getfield(L, -1, "loaders");
+#else
+			lua_getfield(L, -1, "searchers");
+#endif
+			if (lua_type(L, -1) != LUA_TTABLE) {
+				lua_pop(L, 2);
+				return false;
+			}
+			lua_Integer count = static_cast<lua_Integer>(lua_rawlen(L, -1));
+			for (lua_Integer i = count; i >= 2; --i) {
+				lua_rawgeti(L, -1, i);
+				lua_rawseti(L, -2, i + 1);
+			}
+			stack::push(L, searcher());
+			lua_rawseti(L, -2, count >= 1 ? 2 : 1);
+			lua_pop(L, 2);
+			return true;
+		}
+
+		// state_view::require_file, fed from the index instead of package.path
+		object require(lua_State* L, const std::string& name, bool create_global = true) {
+			optional<std::string> path = resolve(name);
+			if (!path) {
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+				throw error(detail::direct_error, "sol: package_index: no indexed module '" + name + "'");
+#else
+				return object(L, lua_nil);
+#endif
+			}
+			state_view lua(L);
+			return lua.require_file(name, *path, create_global);
+		}
+	};
+
+	// shared by every state in the process, so a directory is only ever walked once
+	inline package_index& default_package_index() {
+		static package_index index;
+		return index;
+	}
+
+} // namespace sol
+
+#endif // SOL_PACKAGE_INDEX_HPP
@@ -0,0 +1,455 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_PARALLEL_FOR_HPP
+#define SOL_PARALLEL_FOR_HPP
+
+#include <sol/stack.hpp>
+#include <sol/demangle.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sol {
+
+	// A fixed set of worker threads for data-parallel jobs. A job is a number of
+	// chunks; the workers and the thread calling run() claim chunks from a shared
+	// counter until none are left, so a slow chunk never holds up the rest.
+	class thread_pool {
+	private:
+		struct job {
+			const void* target;
+			void (*invoke)(const void*, std::size_t);
+			std::size_t count;
+			std::atomic<std::size_t> next;
+			std::atomic<bool> failed;
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+			std::exception_ptr error;
+#endif
+
+			job(const void* target_, void (*invoke_)(const void*, std::size_t), std::size_t count_) noexcept
+			: target(target_), invoke(invoke_), count(count_), next(0), failed(false) {
+			}
+		};
+
+		std::vector<std::thread> m_workers;
+		std::mutex m_run_mutex;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_finished;
+		job* m_job;
+		std::uint64_t m_generation;
+		std::size_t m_active;
+		bool m_stop;
+
+		static void work(job& j) noexcept {
+			for (;;) {
+				std::size_t chunk = j.next.fetch_add(1, std::memory_order_relaxed);
+				if (chunk >= j.count) {
+					return;
+				}
+				if (j.failed.load(std::memory_order_relaxed)) {
+					// drain the counter without running anything
+					continue;
+				}
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+				try {
+					j.invoke(j.target, chunk);
+				}
+				catch (...) {
+					if (!j.failed.exchange(true)) {
+						j.error = std::current_exception();
+					}
+				}
+#else
+				j.invoke(j.target, chunk);
+#endif
+			}
+		}
+
+		void worker_loop() {
+			std::uint64_t seen = 0;
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for (;;) {
+				m_wake.wait(lock, [&]() { return m_stop || (m_job != nullptr && m_generation != seen); });
+				if (m_stop) {
+					return;
+				}
+				seen = m_generation;
+				job* j = m_job;
+				++m_active;
+				lock.unlock();
+				work(*j);
+				lock.lock();
+				if (--m_active == 0) {
+					m_finished.notify_all();
+				}
+			}
+		}
+
+	public:
+		// the calling thread always helps, so `workers` is the number of extra threads
+		explicit thread_pool(std::size_t workers = default_worker_count())
+		: m_workers(), m_run_mutex(), m_mutex(), m_wake(), m_finished(), m_job(nullptr), m_generation(0), m_active(0), m_stop(false) {
+			m_workers.reserve(workers);
+			for (std::size_t i = 0; i < workers; ++i) {
+				m_workers.emplace_back([this]() { worker_loop(); });
+			}
+		}
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		~thread_pool() {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+			m_wake.notify_all();
+			for (std::thread& worker : m_workers) {
+				worker.join();
+			}
+		}
+
+		static std::size_t default_worker_count() noexcept {
+			unsigned int hardware = std::thread::hardware_concurrency();
+			return hardware > 1 ? static_cast<std::size_t>(hardware - 1) : 0;
+		}
+
+		// worker threads plus the caller
+		std::size_t concurrency() const noexcept {
+			return m_workers.size() + 1;
+		}
+
+		// calls fx(i) once for every i in [0, chunk_count) and returns when all calls are done;
+		// the first exception thrown by fx is rethrown here, and the chunks not yet started are skipped.
+		// runs are serialized, and fx must not start another run on the same pool
+		template <typename Fx>
+		void run(std::size_t chunk_count, Fx&& fx) {
+			if (chunk_count == 0) {
+				return;
+			}
+			using F = std::remove_reference_t<Fx>;
+			auto invoke = [](const void* target, std::size_t chunk) { (*static_cast<F*>(const_cast<void*>(target)))(chunk); };
+			job j(static_cast<const void*>(std::addressof(fx)), invoke, chunk_count);
+			std::lock_guard<std::mutex> run_lock(m_run_mutex);
+			if (chunk_count > 1 && !m_workers.empty()) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_job = &j;
+				++m_generation;
+				m_wake.notify_all();
+			}
+			work(j);
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				// workers that never picked the job up cannot pick it up once it is gone
+				m_finished.wait(lock, [&]() { return m_active == 0; });
+				m_job = nullptr;
+			}
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+			if (j.error) {
+				std::rethrow_exception(j.error);
+			}
+#endif
+		}
+	};
+
+	inline thread_pool& default_thread_pool() {
+		static thread_pool pool;
+		return pool;
+	}
+
+	namespace detail {
+		template <typename List>
+		struct parallel_kernel_signature {
+			static_assert(!meta::meta_detail::always_true<List>::value,
+			     "sol: a parallel kernel must take its chunk first, either as std::span<T> or as (T* data, std::size_t count)");
+		};
+
+#if SOL_IS_ON(SOL_STD_SPAN)
+		template <typename E, typename... Args>
+		struct parallel_kernel_signature<types<std::span<E>, Args...>> {
+			using element_type = E;
+			using arguments = types<Args...>;
+
+			template <typename Fx, typename... Values>
+			static void call(Fx& fx, E* data, std::size_t count, Values&... values) {
+				fx(std::span<E>(data, count), values...);
+			}
+		};
+#endif
+
+		template <typename E, typename N, typename... Args>
+		struct parallel_kernel_signature<types<E*, N, Args...>> {
+			static_assert(std::is_integral_v<N>, "sol: a parallel kernel taking (T* data, N count) needs an integral count");
+			using element_type = E;
+			using arguments = types<Args...>;
+
+			template <typename Fx, typename... Values>
+			static void call(Fx& fx, E* data, std::size_t count, Values&... values) {
+				fx(data, static_cast<N>(count), values...);
+			}
+		};
+
+		template <typename Fx>
+		struct parallel_kernel_traits_of {
+		private:
+			template <typename... Args>
+			static auto unqualify_first(types<Args...>) -> types<meta::unqualified_t<Args>...>;
+			using args_list = typename meta::bind_traits<meta::unqualified_t<Fx>>::args_list;
+
+		public:
+			using signature = parallel_kernel_signature<decltype(unqualify_first(args_list()))>;
+			using element_type = typename signature::element_type;
+			using value_type = std::remove_const_t<element_type>;
+			using arguments = typename signature::arguments;
+		};
+
+		inline std::size_t parallel_chunk_size(std::size_t count, std::size_t concurrency, std::size_t grain) noexcept {
+			// a few chunks per thread, so the shared counter can even out uneven work
+			std::size_t target = concurrency * 4;
+			std::size_t chunk = (count + target - 1) / target;
+			return (std::max)((std::max)(chunk, grain), static_cast<std::size_t>(1));
+		}
+
+		template <typename Signature, typename Fx, typename E, typename Tuple, std::size_t... I>
+		void parallel_for_run(thread_pool& pool, E* data, std::size_t count, std::size_t grain, Fx& fx, Tuple& values, std::index_sequence<I...>) {
+			std::size_t chunk = parallel_chunk_size(count, pool.concurrency(), grain);
+			std::size_t chunk_count = (count + chunk - 1) / chunk;
+			pool.run(chunk_count, [&](std::size_t c) {
+				std::size_t first = c * chunk;
+				Signature::call(fx, data + first, (std::min)(chunk, count - first), std::get<I>(values)...);
+			});
+		}
+	} // namespace detail
+
+	// runs `kernel` over [data, data + count) in chunks of at least `grain` elements on `pool`;
+	// the extra arguments are shared by every chunk
+	template <typename T, typename Fx, typename... Args>
+	void parallel_for(thread_pool& pool, T* data, std::size_t count, std::size_t grain, Fx&& kernel, Args&&... args) {
+		using signature = typename detail::parallel_kernel_traits_of<Fx>::signature;
+		std::tuple<Args&...> values(args...);
+		detail::parallel_for_run<signature>(pool, data, count, grain, kernel, values, std::index_sequence_for<Args...>());
+	}
+
+	// A registry of named C++ kernels that scripts can run with parallel_for(data, name, args...).
+	// Kernels never see the lua_State: the data and the arguments are fetched on the calling
+	// thread, the chunks run on the pool, and the Lua thread waits until the last one is done.
+	class parallel_kernels {
+	private:
+		struct kernel_base {
+			std::size_t grain;
+
+			kernel_base(std::size_t grain_) noexcept : grain(grain_) {
+			}
+			virtual ~kernel_base() {
+			}
+			// leaves an error message on the stack and returns false on failure
+			virtual bool call(lua_State* L, thread_pool& pool, const std::string& name) = 0;
+		};
+
+		template <typename Fx>
+		struct kernel : kernel_base {
+			using traits = detail::parallel_kernel_traits_of<Fx>;
+			using signature = typename traits::signature;
+			using element_type = typename traits::element_type;
+			using value_type = typename traits::value_type;
+			static_assert(!std::is_same_v<value_type, bool>, "sol: std::vector<bool> has no contiguous storage to hand to a parallel kernel");
+
+			Fx fx;
+
+			kernel(Fx fx_, std::size_t grain_) : kernel_base(grain_), fx(std::move(fx_)) {
+			}
+
+			template <typename... Args, std::size_t... I>
+			bool fetch_arguments(lua_State* L, const std::string& name, types<Args...>, std::index_sequence<I...>, std::tuple<std::decay_t<Args>...>& values) {
+				constexpr int first = 3;
+				bool ok = true;
+				int failed_at = 0;
+				(void)detail::swallow { int(), (ok && !stack::check<std::decay_t<Args>>(L, first + static_cast<int>(I), &no_panic) ? (ok = false, failed_at = static_cast<int>(I)) : 0)... };
+				if (!ok) {
+					const std::string* expected = nullptr;
+					(void)detail::swallow { int(), (static_cast<int>(I) == failed_at ? (expected = &detail::demangle<std::decay_t<Args>>(), 0) : 0)... };
+					lua_pushfstring(L,
+					     "sol: parallel_for: kernel '%s' expects argument %d to be a %s",
+					     name.c_str(),
+					     first + failed_at,
+					     expected != nullptr ? expected->c_str() : "?");
+					return false;
+				}
+				values = std::tuple<std::decay_t<Args>...>(stack::get<std::decay_t<Args>>(L, first + static_cast<int>(I))...);
+				return true;
+			}
+
+			template <typename... Args>
+			bool run(lua_State* L, thread_pool& pool, const std::string& name, element_type* data, std::size_t count, types<Args...> args) {
+				std::tuple<std::decay_t<Args>...> values;
+				if (!fetch_arguments(L, name, args, std::index_sequence_for<Args...>(), values)) {
+					return false;
+				}
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+				try {
+					detail::parallel_for_run<signature>(pool, data, count, grain, fx, values, std::index_sequence_for<Args...>());
+				}
+				catch (const std::exception& e) {
+					lua_pushfstring(L, "sol: parallel_for: kernel '%s' failed: %s", name.c_str(), e.what());
+					return false;
+				}
+				catch (...) {
+					lua_pushfstring(L, "sol: parallel_for: kernel '%s' failed with an unknown exception", name.c_str());
+					return false;
+				}
+#else
+				detail::parallel_for_run<signature>(pool, data, count, grain, fx, values, std::index_sequence_for<Args...>());
+#endif
+				return true;
+			}
+
+			bool call(lua_State* L, thread_pool& pool, const std::string& name) override {
+				typename traits::arguments args;
+				if (type_of(L, 1) == type::userdata && stack::check<std::vector<value_type>>(L, 1, &no_panic)) {
+					// a std::vector living in Lua: the kernels work on its storage directly
+					std::vector<value_type>& target = *stack::get<std::vector<value_type>*>(L, 1);
+					return run(L, pool, name, target.data(), target.size(), args);
+				}
+				if (type_of(L, 1) == type::table) {
+					// a plain array: copied out for the kernels, and back in unless they only read it
+					std::size_t count = static_cast<std::size_t>(lua_rawlen(L, 1));
+					std::vector<value_type> copy;
+					copy.reserve(count);
+					for (std::size_t i = 0; i < count; ++i) {
+						lua_rawgeti(L, 1, static_cast<lua_Integer>(i + 1));
+						if (!stack::check<value_type>(L, -1, &no_panic)) {
+							lua_pop(L, 1);
+							lua_pushfstring(L,
+							     "sol: parallel_for: kernel '%s' expects every element to be a %s, but element %d is not",
+							     name.c_str(),
+							     detail::demangle<value_type>().c_str(),
+							     static_cast<int>(i + 1));
+							return false;
+						}
+						copy.push_back(stack::get<value_type>(L, -1));
+						lua_pop(L, 1);
+					}
+					if (!run(L, pool, name, copy.data(), copy.size(), args)) {
+						return false;
+					}
+					if constexpr (!std::is_const_v<element_type>) {
+						for (std::size_t i = 0; i < count; ++i) {
+							stack::push(L, copy[i]);
+							lua_rawseti(L, 1, static_cast<lua_Integer>(i + 1));
+						}
+					}
+					return true;
+				}
+				lua_pushfstring(L,
+				     "sol: parallel_for: kernel '%s' works on a table or a std::vector<%s>, not a %s",
+				     name.c_str(),
+				     detail::demangle<value_type>().c_str(),
+				     luaL_typename(L, 1));
+				return false;
+			}
+		};
+
+		thread_pool* m_pool;
+		std::unordered_map<std::string, std::unique_ptr<kernel_base>> m_kernels;
+
+		static bool dispatch(lua_State* L, parallel_kernels& self) {
+			size_t name_size = 0;
+			const char* name_data = lua_tolstring(L, 2, &name_size);
+			if (name_data == nullptr) {
+				lua_pushstring(L, "sol: parallel_for: argument 2 must be the name of a kernel");
+				return false;
+			}
+			std::string name(name_data, name_size);
+			auto it = self.m_kernels.find(name);
+			if (it == self.m_kernels.cend()) {
+				lua_pushfstring(L, "sol: parallel_for: no kernel named '%s'", name.c_str());
+				return false;
+			}
+			return it->second->call(L, *self.m_pool, name);
+		}
+
+		static int lua_parallel_for(lua_State* L) {
+			parallel_kernels& self = *static_cast<parallel_kernels*>(lua_touserdata(L, lua_upvalueindex(1)));
+			if (dispatch(L, self)) {
+				return 0;
+			}
+			// raised out here, with nothing left to unwind
+			return lua_error(L);
+		}
+
+	public:
+		explicit parallel_kernels(thread_pool& pool = default_thread_pool()) : m_pool(&pool), m_kernels() {
+		}
+		parallel_kernels(const parallel_kernels&) = delete;
+		parallel_kernels& operator=(const parallel_kernels&) = delete;
+
+		// registers `fx` as a kernel: it is called with a chunk of the data (std::span<T> or T*, count)
+		// followed by the extra arguments given in Lua, converted once before any chunk starts.
+		// `grain` is the smallest chunk worth handing to a thread (0: let the pool decide)
+		template <typename Fx>
+		parallel_kernels& add(std::string name, Fx&& fx, std::size_t grain = 0) {
+			m_kernels[std::move(name)] = std::make_unique<kernel<std::decay_t<Fx>>>(std::forward<Fx>(fx), grain);
+			return *this;
+		}
+
+		bool remove(const std::string& name) {
+			return m_kernels.erase(name) > 0;
+		}
+
+		bool contains(const std::string& name) const {
+			return m_kernels.find(name) != m_kernels.cend();
+		}
+
+		std::size_t size() const noexcept {
+			return m_kernels.size();
+		}
+
+		thread_pool& pool() const noexcept {
+			return *m_pool;
+		}
+
+		// the parallel_for(data, name, args...) function for Lua; it refers to this registry,
+		// which must outlive every state it is set into
+		closure<void*> lua_function() {
+			return make_closure(&parallel_kernels::lua_parallel_for, static_cast<void*>(this));
+		}
+	};
+
+} // namespace sol
+
+#endif // SOL_PARALLEL_FOR_HPP
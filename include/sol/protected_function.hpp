@@ -42,6 +42,7 @@ namespace sol {
 		template <bool ShouldPush_, typename Handler_>
 		inline void handle_protected_exception(
 		     lua_State* L_, optional<const std::exception&> maybe_ex, const char* error, detail::protected_handler<ShouldPush_, Handler_>& handler_) {
+			count_runtime_event(runtime_counter::protected_call_errors);
 			handler_.stack_index = 0;
 			if (ShouldPush_) {
 				handler_.target.push(L_);
@@ -176,6 +177,13 @@ namespace sol {
 			stack::check<basic_protected_function>(lua_state(), -1, handler);
 #endif // Safety
 		}
+		basic_protected_function(lua_State* L_, detail::borrowed_index index_)
+		: base_t(L_, index_), m_error_handler(get_default_handler(L_)) {
+#if SOL_IS_ON(SOL_SAFE_REFERENCES)
+			constructor_handler handler {};
+			stack::check<basic_protected_function>(L_, index_.index, handler);
+#endif // Safety
+		}
 
 		using base_t::lua_state;
 
@@ -312,7 +320,11 @@ namespace sol {
 
 		template <bool b>
 		call_status luacall(std::ptrdiff_t argcount, std::ptrdiff_t result_count_, detail::protected_handler<b, handler_t>& h) const {
-			return static_cast<call_status>(lua_pcall(lua_state(), static_cast<int>(argcount), static_cast<int>(result_count_), h.stack_index));
+			int status = lua_pcall(lua_state(), static_cast<int>(argcount), static_cast<int>(result_count_), h.stack_index);
+			if (status != LUA_OK) {
+				detail::count_runtime_event(detail::runtime_counter::protected_call_errors);
+			}
+			return static_cast<call_status>(status);
 		}
 
 		template <std::size_t... I, bool b, typename... Ret>
@@ -0,0 +1,799 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_RECORD_HPP
+#define SOL_RECORD_HPP
+
+#include <sol/reference.hpp>
+#include <sol/stack.hpp>
+#include <sol/table.hpp>
+#include <sol/error.hpp>
+#include <sol/demangle.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sol {
+
+	enum class record_field_type : unsigned char { boolean, int8, uint8, int16, uint16, int32, uint32, int64, uint64, float32, float64 };
+
+	struct record_field {
+		std::string name;
+		record_field_type type;
+		std::size_t offset;
+	};
+
+	class record_schema;
+
+	namespace detail {
+		// what Lua guarantees for userdata memory (LUAI_MAXALIGN), and so the most a record can ask for
+		union record_max_align {
+			double d;
+			long long ll;
+			void* p;
+			long l;
+		};
+
+		// every record block starts with its schema; the fields follow at a fixed offset
+		inline constexpr std::size_t record_data_offset = sizeof(record_max_align) < sizeof(void*) ? sizeof(void*) : sizeof(record_max_align);
+
+		struct record_metatable_key_t { };
+		inline constexpr record_metatable_key_t record_metatable_key {};
+
+		template <typename T>
+		struct record_tag {
+			static constexpr char value = 0;
+		};
+
+		template <typename T>
+		constexpr record_field_type record_field_type_of() {
+			using U = std::remove_cv_t<T>;
+			static_assert(std::is_arithmetic_v<U>, "record fields must be bool, a fixed-size integer, float or double");
+			if constexpr (std::is_same_v<U, bool>) {
+				return record_field_type::boolean;
+			}
+			else if constexpr (std::is_floating_point_v<U>) {
+				static_assert(sizeof(U) == 4 || sizeof(U) == 8, "record float fields must be 32 or 64 bits wide");
+				return sizeof(U) == 4 ? record_field_type::float32 : record_field_type::float64;
+			}
+			else if constexpr (sizeof(U) == 1) {
+				return std::is_signed_v<U> ? record_field_type::int8 : record_field_type::uint8;
+			}
+			else if constexpr (sizeof(U) == 2) {
+				return std::is_signed_v<U> ? record_field_type::int16 : record_field_type::uint16;
+			}
+			else if constexpr (sizeof(U) == 4) {
+				return std::is_signed_v<U> ? record_field_type::int32 : record_field_type::uint32;
+			}
+			else {
+				static_assert(sizeof(U) == 8, "record integer fields must be at most 64 bits wide");
+				return std::is_signed_v<U> ? record_field_type::int64 : record_field_type::uint64;
+			}
+		}
+
+		inline std::size_t record_field_size(record_field_type type) noexcept {
+			switch (type) {
+			case record_field_type::boolean:
+				return sizeof(bool);
+			case record_field_type::int8:
+			case record_field_type::uint8:
+				return 1;
+			case record_field_type::int16:
+			case record_field_type::uint16:
+				return 2;
+			case record_field_type::int32:
+			case record_field_type::uint32:
+			case record_field_type::float32:
+				return 4;
+			default:
+				return 8;
+			}
+		}
+
+		inline const char* record_field_type_name(record_field_type type) noexcept {
+			static const char* const names[] = { "bool", "i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64", "f32", "f64" };
+			return names[static_cast<std::size_t>(type)];
+		}
+
+		inline optional<record_field_type> record_field_type_from_name(string_view name) noexcept {
+			for (std::size_t i = 0; i <= static_cast<std::size_t>(record_field_type::float64); ++i) {
+				if (name == record_field_type_name(static_cast<record_field_type>(i))) {
+					return static_cast<record_field_type>(i);
+				}
+			}
+			if (name == "boolean") {
+				return record_field_type::boolean;
+			}
+			if (name == "int") {
+				return record_field_type::int32;
+			}
+			if (name == "integer") {
+				return record_field_type::int64;
+			}
+			if (name == "float") {
+				return record_field_type::float32;
+			}
+			if (name == "double" || name == "number") {
+				return record_field_type::float64;
+			}
+			return nullopt;
+		}
+
+		template <typename U>
+		U record_load(const char* source) noexcept {
+			U value;
+			std::memcpy(&value, source, sizeof(U));
+			return value;
+		}
+
+		template <typename U>
+		void record_store(char* target, U value) noexcept {
+			std::memcpy(target, &value, sizeof(U));
+		}
+
+		inline void record_push_field(lua_State* L, const char* source, record_field_type type) {
+			switch (type) {
+			case record_field_type::boolean:
+				lua_pushboolean(L, record_load<bool>(source) ? 1 : 0);
+				break;
+			case record_field_type::int8:
+				lua_pushinteger(L, static_cast<lua_Integer>(record_load<std::int8_t>(source)));
+				break;
+			case record_field_type::uint8:
+				lua_pushinteger(L, static_cast<lua_Integer>(record_load<std::uint8_t>(source)));
+				break;
+			case record_field_type::int16:
+				lua_pushinteger(L, static_cast<lua_Integer>(record_load<std::int16_t>(source)));
+				break;
+			case record_field_type::uint16:
+				lua_pushinteger(L, static_cast<lua_Integer>(record_load<std::uint16_t>(source)));
+				break;
+			case record_field_type::int32:
+				lua_pushinteger(L, static_cast<lua_Integer>(record_load<std::int32_t>(source)));
+				break;
+			case record_field_type::uint32:
+				lua_pushinteger(L, static_cast<lua_Integer>(record_load<std::uint32_t>(source)));
+				break;
+			case record_field_type::int64:
+				lua_pushinteger(L, static_cast<lua_Integer>(record_load<std::int64_t>(source)));
+				break;
+			case record_field_type::uint64:
+				lua_pushinteger(L, static_cast<lua_Integer>(record_load<std::uint64_t>(source)));
+				break;
+			case record_field_type::float32:
+				lua_pushnumber(L, static_cast<lua_Number>(record_load<float>(source)));
+				break;
+			case record_field_type::float64:
+				lua_pushnumber(L, static_cast<lua_Number>(record_load<double>(source)));
+				break;
+			}
+		}
+
+		// integers must be numbers with an integral value; they wrap to the field's width like a C cast
+		inline bool record_store_field(lua_State* L, int index, char* target, record_field_type type) {
+			if (type == record_field_type::boolean) {
+				if (lua_type(L, index) != LUA_TBOOLEAN) {
+					return false;
+				}
+				record_store<bool>(target, lua_toboolean(L, index) != 0);
+				return true;
+			}
+			if (lua_type(L, index) != LUA_TNUMBER) {
+				return false;
+			}
+			if (type == record_field_type::float32) {
+				record_store<float>(target, static_cast<float>(lua_tonumber(L, index)));
+				return true;
+			}
+			if (type == record_field_type::float64) {
+				record_store<double>(target, static_cast<double>(lua_tonumber(L, index)));
+				return true;
+			}
+			int isnum = 0;
+			lua_Integer value = lua_tointegerx(L, index, &isnum);
+			if (isnum == 0) {
+				return false;
+			}
+			switch (type) {
+			case record_field_type::int8:
+				record_store<std::int8_t>(target, static_cast<std::int8_t>(value));
+				break;
+			case record_field_type::uint8:
+				record_store<std::uint8_t>(target, static_cast<std::uint8_t>(value));
+				break;
+			case record_field_type::int16:
+				record_store<std::int16_t>(target, static_cast<std::int16_t>(value));
+				break;
+			case record_field_type::uint16:
+				record_store<std::uint16_t>(target, static_cast<std::uint16_t>(value));
+				break;
+			case record_field_type::int32:
+				record_store<std::int32_t>(target, static_cast<std::int32_t>(value));
+				break;
+			case record_field_type::uint32:
+				record_store<std::uint32_t>(target, static_cast<std::uint32_t>(value));
+				break;
+			case record_field_type::int64:
+				record_store<std::int64_t>(target, static_cast<std::int64_t>(value));
+				break;
+			default:
+				record_store<std::uint64_t>(target, static_cast<std::uint64_t>(value));
+				break;
+			}
+			return true;
+		}
+
+		// a field's offset and type, packed into the integer its accessor looks up
+		inline lua_Integer record_field_code(const record_field& field) noexcept {
+			return static_cast<lua_Integer>(field.offset) * 16 + static_cast<lua_Integer>(field.type);
+		}
+
+		inline char* record_data(void* block) noexcept {
+			return static_cast<char*>(block) + record_data_offset;
+		}
+
+		inline const record_schema* record_schema_of(const void* block) noexcept {
+			return *static_cast<const record_schema* const*>(block);
+		}
+	} // namespace detail
+
+	// The layout of a record: named numeric and boolean fields at fixed offsets.
+	// Fields added one at a time are laid out like the members of a C struct;
+	// of<T>() takes the layout of an existing struct instead.
+	class record_schema {
+	private:
+		std::string m_name;
+		std::vector<record_field> m_fields;
+		std::size_t m_size;
+		std::size_t m_alignment;
+		const void* m_cpp_type;
+
+		template <typename T, typename Name, typename Member, typename... Rest>
+		void add_members(const T* base, Name&& field_name, Member T::*member, Rest&&... rest) {
+			static_assert(std::is_arithmetic_v<Member>, "record fields must be bool, a fixed-size integer, float or double");
+			std::size_t offset
+			     = static_cast<std::size_t>(reinterpret_cast<const char*>(&(base->*member)) - reinterpret_cast<const char*>(base));
+			m_fields.push_back(record_field { std::string(std::forward<Name>(field_name)), detail::record_field_type_of<Member>(), offset });
+			if constexpr (sizeof...(Rest) > 0) {
+				add_members(base, std::forward<Rest>(rest)...);
+			}
+		}
+
+	public:
+		explicit record_schema(std::string name) : m_name(std::move(name)), m_fields(), m_size(0), m_alignment(1), m_cpp_type(nullptr) {
+		}
+
+		// appends a field at the next offset aligned for its type
+		record_schema& add(std::string field_name, record_field_type type) {
+			if (find(field_name) != nullptr) {
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+				throw error(detail::direct_error, "sol: record '" + m_name + "' already has a field named '" + field_name + "'");
+#else
+				return *this;
+#endif
+			}
+			std::size_t field_size = detail::record_field_size(type);
+			std::size_t offset = (m_size + field_size - 1) / field_size * field_size;
+			m_fields.push_back(record_field { std::move(field_name), type, offset });
+			m_alignment = (std::max)(m_alignment, field_size);
+			m_size = offset + field_size;
+			m_size = (m_size + m_alignment - 1) / m_alignment * m_alignment;
+			m_cpp_type = nullptr;
+			return *this;
+		}
+
+		template <typename U>
+		record_schema& add(std::string field_name) {
+			return add(std::move(field_name), detail::record_field_type_of<U>());
+		}
+
+		// the layout of T itself, so C++ can use the record memory as a T;
+		// fields are given as "name", &T::member pairs
+		template <typename T, typename... Args>
+		static record_schema of(std::string name, Args&&... args) {
+			static_assert(std::is_standard_layout_v<T> && std::is_trivially_copyable_v<T>,
+			     "a record's C++ type must be a standard-layout, trivially copyable struct");
+			static_assert(alignof(T) <= alignof(detail::record_max_align), "a record's C++ type cannot be over-aligned");
+			static_assert(sizeof...(Args) % 2 == 0, "record members are given as \"name\", &T::member pairs");
+			record_schema schema(std::move(name));
+			alignas(T) unsigned char storage[sizeof(T)];
+			if constexpr (sizeof...(Args) > 0) {
+				schema.add_members(reinterpret_cast<const T*>(&storage[0]), std::forward<Args>(args)...);
+			}
+			schema.m_size = sizeof(T);
+			schema.m_alignment = alignof(T);
+			schema.m_cpp_type = &detail::record_tag<T>::value;
+			return schema;
+		}
+
+		// from { { "x", "f32" }, { "alive", "bool" }, ... }, laid out in order
+		static record_schema from_lua(std::string name, const table& description) {
+			record_schema schema(std::move(name));
+			std::size_t count = description.size();
+			for (std::size_t i = 1; i <= count; ++i) {
+				optional<table> entry = description.get<optional<table>>(i);
+				optional<std::string> field_name = entry ? entry->get<optional<std::string>>(1) : nullopt;
+				optional<std::string> type_name = entry ? entry->get<optional<std::string>>(2) : nullopt;
+				optional<record_field_type> type = type_name ? detail::record_field_type_from_name(*type_name) : nullopt;
+				if (!field_name || !type) {
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+					throw error(detail::direct_error,
+					     "sol: record '" + schema.m_name + "' field #" + std::to_string(i) + " must be { name, type } with a known type name");
+#else
+					continue;
+#endif
+				}
+				schema.add(std::move(*field_name), *type);
+			}
+			return schema;
+		}
+
+		const record_field* find(string_view field_name) const noexcept {
+			for (const record_field& field : m_fields) {
+				if (field.name == field_name) {
+					return &field;
+				}
+			}
+			return nullptr;
+		}
+
+		template <typename T>
+		bool is() const noexcept {
+			return m_cpp_type == &detail::record_tag<T>::value;
+		}
+
+		const std::string& name() const noexcept {
+			return m_name;
+		}
+
+		const std::vector<record_field>& fields() const noexcept {
+			return m_fields;
+		}
+
+		std::size_t size() const noexcept {
+			return m_size;
+		}
+
+		std::size_t alignment() const noexcept {
+			return m_alignment;
+		}
+	};
+
+	// A record already in Lua, seen from C++: the pointer is taken once,
+	// and every access after that is a plain load or store into the userdata.
+	template <typename T = void>
+	class record_view {
+	private:
+		reference m_ref;
+		const record_schema* m_schema;
+		char* m_data;
+
+	public:
+		record_view() noexcept : m_ref(), m_schema(nullptr), m_data(nullptr) {
+		}
+
+		record_view(lua_State* L, int index) : m_ref(L, index), m_schema(nullptr), m_data(nullptr) {
+			void* block = lua_touserdata(L, index);
+			if (block != nullptr) {
+				m_schema = detail::record_schema_of(block);
+				m_data = detail::record_data(block);
+			}
+		}
+
+		template <typename U = T, meta::disable<std::is_void<U>> = meta::enabler>
+		U* get() const noexcept {
+			return reinterpret_cast<U*>(m_data);
+		}
+
+		template <typename U = T, meta::disable<std::is_void<U>> = meta::enabler>
+		U* operator->() const noexcept {
+			return get<U>();
+		}
+
+		template <typename U = T, meta::disable<std::is_void<U>> = meta::enabler>
+		U& operator*() const noexcept {
+			return *get<U>();
+		}
+
+		// by name, through the schema; for records whose layout has no C++ struct
+		template <typename U>
+		U get(string_view field_name) const {
+			const record_field* field = m_schema->find(field_name);
+			sol_m_assert("sol: the record has no field by that name", field != nullptr);
+			switch (field->type) {
+			case record_field_type::boolean:
+				return static_cast<U>(detail::record_load<bool>(m_data + field->offset));
+			case record_field_type::int8:
+				return static_cast<U>(detail::record_load<std::int8_t>(m_data + field->offset));
+			case record_field_type::uint8:
+				return static_cast<U>(detail::record_load<std::uint8_t>(m_data + field->offset));
+			case record_field_type::int16:
+				return static_cast<U>(detail::record_load<std::int16_t>(m_data + field->offset));
+			case record_field_type::uint16:
+				return static_cast<U>(detail::record_load<std::uint16_t>(m_data + field->offset));
+			case record_field_type::int32:
+				return static_cast<U>(detail::record_load<std::int32_t>(m_data + field->offset));
+			case record_field_type::uint32:
+				return static_cast<U>(detail::record_load<std::uint32_t>(m_data + field->offset));
+			case record_field_type::int64:
+				return static_cast<U>(detail::record_load<std::int64_t>(m_data + field->offset));
+			case record_field_type::uint64:
+				return static_cast<U>(detail::record_load<std::uint64_t>(m_data + field->offset));
+			case record_field_type::float32:
+				return static_cast<U>(detail::record_load<float>(m_data + field->offset));
+			default:
+				return static_cast<U>(detail::record_load<double>(m_data + field->offset));
+			}
+		}
+
+		template <typename U>
+		void set(string_view field_name, U value) const {
+			const record_field* field = m_schema->find(field_name);
+			sol_m_assert("sol: the record has no field by that name", field != nullptr);
+			char* target = m_data + field->offset;
+			switch (field->type) {
+			case record_field_type::boolean:
+				detail::record_store<bool>(target, static_cast<bool>(value));
+				break;
+			case record_field_type::int8:
+				detail::record_store<std::int8_t>(target, static_cast<std::int8_t>(value));
+				break;
+			case record_field_type::uint8:
+				detail::record_store<std::uint8_t>(target, static_cast<std::uint8_t>(value));
+				break;
+			case record_field_type::int16:
+				detail::record_store<std::int16_t>(target, static_cast<std::int16_t>(value));
+				break;
+			case record_field_type::uint16:
+				detail::record_store<std::uint16_t>(target, static_cast<std::uint16_t>(value));
+				break;
+			case record_field_type::int32:
+				detail::record_store<std::int32_t>(target, static_cast<std::int32_t>(value));
+				break;
+			case record_field_type::uint32:
+				detail::record_store<std::uint32_t>(target, static_cast<std::uint32_t>(value));
+				break;
+			case record_field_type::int64:
+				detail::record_store<std::int64_t>(target, static_cast<std::int64_t>(value));
+				break;
+			case record_field_type::uint64:
+				detail::record_store<std::uint64_t>(target, static_cast<std::uint64_t>(value));
+				break;
+			case record_field_type::float32:
+				detail::record_store<float>(target, static_cast<float>(value));
+				break;
+			default:
+				detail::record_store<double>(target, static_cast<double>(value));
+				break;
+			}
+		}
+
+		void* data() const noexcept {
+			return m_data;
+		}
+
+		const record_schema& schema() const noexcept {
+			return *m_schema;
+		}
+
+		bool valid() const noexcept {
+			return m_data != nullptr;
+		}
+
+		explicit operator bool() const noexcept {
+			return valid();
+		}
+
+		const reference& lua_reference() const noexcept {
+			return m_ref;
+		}
+
+		lua_State* lua_state() const noexcept {
+			return m_ref.lua_state();
+		}
+	};
+
+	// A record schema brought into one state: its metatable, holding the field accessors,
+	// and its class table, holding `new`, `name`, `size` and anything scripts add as methods.
+	class record_type {
+	private:
+		lua_State* m_L;
+		const record_schema* m_schema;
+		reference m_class;
+		reference m_metatable;
+
+		static int lua_destroy_schema(lua_State* L) {
+			record_schema* schema = static_cast<record_schema*>(lua_touserdata(L, 1));
+			schema->~record_schema();
+			return 0;
+		}
+
+		// __index: upvalue 1 maps field names to packed offset/type codes, upvalue 2 is the class table
+		static int lua_index(lua_State* L) {
+			void* block = lua_touserdata(L, 1);
+			lua_pushvalue(L, 2);
+			lua_rawget(L, lua_upvalueindex(1));
+			if (block != nullptr && lua_type(L, -1) == LUA_TNUMBER) {
+				lua_Integer code = lua_tointeger(L, -1);
+				lua_pop(L, 1);
+				detail::record_push_field(L, detail::record_data(block) + code / 16, static_cast<record_field_type>(code % 16));
+				return 1;
+			}
+			lua_pop(L, 1);
+			lua_pushvalue(L, 2);
+			lua_rawget(L, lua_upvalueindex(2));
+			return 1;
+		}
+
+		static int lua_new_index(lua_State* L) {
+			void* block = lua_touserdata(L, 1);
+			lua_pushvalue(L, 2);
+			lua_rawget(L, lua_upvalueindex(1));
+			if (block == nullptr || lua_type(L, -1) != LUA_TNUMBER) {
+				const char* record_name = block != nullptr ? detail::record_schema_of(block)->name().c_str() : "?";
+				return luaL_error(L, "sol: record '%s' has no field '%s'", record_name, luaL_tolstring(L, 2, nullptr));
+			}
+			lua_Integer code = lua_tointeger(L, -1);
+			lua_pop(L, 1);
+			record_field_type type = static_cast<record_field_type>(code % 16);
+			if (!detail::record_store_field(L, 3, detail::record_data(block) + code / 16, type)) {
+				return luaL_error(L,
+				     "sol: record field '%s.%s' expects %s, got %s",
+				     detail::record_schema_of(block)->name().c_str(),
+				     lua_tostring(L, 2),
+				     detail::record_field_type_name(type),
+				     luaL_typename(L, 3));
+			}
+			return 0;
+		}
+
+		static int lua_tostring_record(lua_State* L) {
+			void* block = lua_touserdata(L, 1);
+			lua_pushfstring(L, "%s: %p", detail::record_schema_of(block)->name().c_str(), block);
+			return 1;
+		}
+
+		// class.new([fields]): upvalue 1 is the schema, upvalue 2 the metatable; fields start zeroed
+		static int lua_create(lua_State* L) {
+			const record_schema& schema = *static_cast<const record_schema*>(lua_touserdata(L, lua_upvalueindex(1)));
+			void* block = create_block(L, schema, lua_upvalueindex(2));
+			if (lua_type(L, 1) == LUA_TTABLE) {
+				char* data = detail::record_data(block);
+				for (const record_field& field : schema.fields()) {
+					lua_getfield(L, 1, field.name.c_str());
+					bool stored = lua_isnil(L, -1) || detail::record_store_field(L, -1, data + field.offset, field.type);
+					if (!stored) {
+						return luaL_error(L,
+						     "sol: record field '%s.%s' expects %s, got %s",
+						     schema.name().c_str(),
+						     field.name.c_str(),
+						     detail::record_field_type_name(field.type),
+						     luaL_typename(L, -1));
+					}
+					lua_pop(L, 1);
+				}
+			}
+			return 1;
+		}
+
+		static void* create_block(lua_State* L, const record_schema& schema, int metatable_index) {
+			int metatable = lua_absindex(L, metatable_index);
+			void* block = lua_newuserdata(L, detail::record_data_offset + schema.size());
+			std::memset(block, 0, detail::record_data_offset + schema.size());
+			*static_cast<const record_schema**>(block) = &schema;
+			lua_pushvalue(L, metatable);
+			lua_setmetatable(L, -2);
+			return block;
+		}
+
+		static int lua_define_record(lua_State* L) {
+			int results = 0;
+			{
+				if (lua_type(L, 1) != LUA_TSTRING || lua_type(L, 2) != LUA_TTABLE) {
+					lua_pushstring(L, "sol: define_record expects a name and a { { name, type }, ... } table");
+				}
+				else {
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+					try {
+#endif
+						record_type type(L, record_schema::from_lua(stack::get<std::string>(L, 1), stack::get<table>(L, 2)));
+						type.m_class.push(L);
+						results = 1;
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+					}
+					catch (const std::exception& ex) {
+						lua_pushstring(L, ex.what());
+					}
+#endif
+				}
+			}
+			if (results == 0) {
+				// raised out here, with nothing left to unwind
+				return lua_error(L);
+			}
+			return results;
+		}
+
+	public:
+		record_type(lua_State* L, record_schema schema) : m_L(L), m_schema(nullptr), m_class(), m_metatable() {
+			// the schema lives in a userdata that every record's metatable holds on to,
+			// so it stays alive for as long as any record (or the class table's `new`) does
+			void* schema_memory = lua_newuserdata(L, sizeof(record_schema));
+			record_schema* stored = new (schema_memory) record_schema(std::move(schema));
+			m_schema = stored;
+			if (luaL_newmetatable(L, "sol.record_schema") != 0) {
+				lua_pushcfunction(L, &record_type::lua_destroy_schema);
+				lua_setfield(L, -2, "__gc");
+			}
+			lua_setmetatable(L, -2);
+			int schema_index = lua_gettop(L);
+
+			lua_createtable(L, 0, static_cast<int>(stored->fields().size()));
+			int fields_index = lua_gettop(L);
+			for (const record_field& field : stored->fields()) {
+				lua_pushinteger(L, detail::record_field_code(field));
+				lua_setfield(L, fields_index, field.name.c_str());
+			}
+
+			lua_createtable(L, 0, 4);
+			int class_index = lua_gettop(L);
+			lua_pushlstring(L, stored->name().data(), stored->name().size());
+			lua_setfield(L, class_index, "name");
+			lua_pushinteger(L, static_cast<lua_Integer>(stored->size()));
+			lua_setfield(L, class_index, "size");
+			lua_createtable(L, static_cast<int>(stored->fields().size()), 0);
+			lua_Integer position = 1;
+			for (const record_field& field : stored->fields()) {
+				lua_pushlstring(L, field.name.data(), field.name.size());
+				lua_rawseti(L, -2, position++);
+			}
+			lua_setfield(L, class_index, "fields");
+
+			lua_createtable(L, 0, 5);
+			int metatable_index = lua_gettop(L);
+			lua_pushvalue(L, fields_index);
+			lua_pushvalue(L, class_index);
+			lua_pushcclosure(L, &record_type::lua_index, 2);
+			lua_setfield(L, metatable_index, "__index");
+			lua_pushvalue(L, fields_index);
+			lua_pushcclosure(L, &record_type::lua_new_index, 1);
+			lua_setfield(L, metatable_index, "__newindex");
+			lua_pushcfunction(L, &record_type::lua_tostring_record);
+			lua_setfield(L, metatable_index, "__tostring");
+			lua_pushlstring(L, stored->name().data(), stored->name().size());
+			lua_setfield(L, metatable_index, "__name");
+			lua_pushlightuserdata(L, const_cast<void*>(static_cast<const void*>(&detail::record_metatable_key)));
+			lua_pushvalue(L, schema_index);
+			lua_rawset(L, metatable_index);
+
+			lua_pushvalue(L, schema_index);
+			lua_pushvalue(L, metatable_index);
+			lua_pushcclosure(L, &record_type::lua_create, 2);
+			lua_setfield(L, class_index, "new");
+
+			m_metatable = reference(L, metatable_index);
+			m_class = reference(L, class_index);
+			lua_settop(L, schema_index - 1);
+		}
+
+		// a new, zeroed record
+		template <typename T = void>
+		record_view<T> create() const {
+			m_metatable.push(m_L);
+			create_block(m_L, *m_schema, -1);
+			record_view<T> view(m_L, -1);
+			lua_pop(m_L, 2);
+			return view;
+		}
+
+		table class_table() const {
+			return table(m_L, m_class);
+		}
+
+		const record_schema& schema() const noexcept {
+			return *m_schema;
+		}
+
+		lua_State* lua_state() const noexcept {
+			return m_L;
+		}
+
+		// for scripts: define_record(name, { { "x", "f32" }, ... }) returns the new class table
+		static lua_CFunction lua_define() noexcept {
+			return &record_type::lua_define_record;
+		}
+	};
+
+	namespace detail {
+		template <typename T>
+		struct lua_type_of<record_view<T>> : std::integral_constant<type, type::userdata> { };
+
+		// a userdata is a record of this schema only if its metatable was made for that schema
+		inline const record_schema* record_schema_at(lua_State* L, int index) {
+			void* block = lua_touserdata(L, index);
+			if (block == nullptr || lua_type(L, index) != LUA_TUSERDATA || lua_getmetatable(L, index) == 0) {
+				return nullptr;
+			}
+			lua_pushlightuserdata(L, const_cast<void*>(static_cast<const void*>(&record_metatable_key)));
+			lua_rawget(L, -2);
+			const record_schema* schema = static_cast<const record_schema*>(lua_touserdata(L, -1));
+			lua_pop(L, 2);
+			if (schema == nullptr || schema != record_schema_of(block)) {
+				return nullptr;
+			}
+			return schema;
+		}
+	} // namespace detail
+
+	template <typename T>
+	struct is_container<record_view<T>> : std::false_type { };
+
+	template <typename T>
+	struct is_lua_primitive<record_view<T>> : std::true_type { };
+
+	namespace stack {
+		template <typename T>
+		struct unqualified_checker<record_view<T>, type::userdata> {
+			template <typename Handler>
+			static bool check(lua_State* L, int index, Handler&& handler, record& tracking) {
+				tracking.use(1);
+				const record_schema* schema = detail::record_schema_at(L, index);
+				if (schema == nullptr) {
+					handler(L, index, type::userdata, type_of(L, index), "value is not a record");
+					return false;
+				}
+				if constexpr (!std::is_void_v<T>) {
+					if (!schema->template is<T>()) {
+						handler(L, index, type::userdata, type::userdata, "value is a record, but its schema was not made from this C++ type");
+						return false;
+					}
+				}
+				return true;
+			}
+		};
+
+		template <typename T>
+		struct unqualified_getter<record_view<T>> {
+			static record_view<T> get(lua_State* L, int index, record& tracking) {
+				tracking.use(1);
+				return record_view<T>(L, index);
+			}
+		};
+
+		template <typename T>
+		struct unqualified_pusher<record_view<T>> {
+			static int push(lua_State* L, const record_view<T>& view) {
+				return view.lua_reference().push(L);
+			}
+		};
+	} // namespace stack
+
+} // namespace sol
+
+#endif // SOL_RECORD_HPP
@@ -28,6 +28,7 @@
 #include <sol/stack_reference.hpp>
 
 #include <functional>
+#include <vector>
 
 namespace sol {
 	namespace detail {
@@ -35,6 +36,16 @@ namespace sol {
 			static const char name[9] = "sol.\xF0\x9F\x93\x8C";
 			return name;
 		}
+
+		// registry index reported by a reference that borrows a stack slot
+		constexpr const int borrowed_ref = LUA_NOREF - 1;
+
+		struct borrowed_index {
+			int index;
+
+			explicit borrowed_index(int index_) noexcept : index(index_) {
+			}
+		};
 	} // namespace detail
 
 	namespace stack {
@@ -478,10 +489,99 @@ namespace sol {
 	private:
 		template <bool o_main_only>
 		friend class basic_reference;
+		// absolute stack index of a borrowed argument, -1 for a borrowed argument
+		// that has been moved out of, and 0 for a plain registry reference
+		int borrowed = 0;
 		lua_State* luastate = nullptr; // non-owning
 
+		struct borrow_entry {
+			const basic_reference* anchor;
+			basic_reference* holder;
+			const void* pointer;
+			int value_type;
+		};
+
+		// one entry per borrowed argument of the calls currently on the C stack:
+		// "anchor" is the argument sol created for the call, "holder" is whichever
+		// reference currently owns the borrow after being moved around
+		static std::vector<borrow_entry>& borrow_ledger() {
+#if SOL_IS_ON(SOL_USE_THREAD_LOCAL)
+			static thread_local std::vector<borrow_entry> ledger;
+#else
+			static std::vector<borrow_entry> ledger;
+#endif
+			return ledger;
+		}
+
+		void adopt_borrowed(basic_reference& r) noexcept {
+			bool from_anchor = false;
+			std::vector<borrow_entry>& ledger = borrow_ledger();
+			for (std::size_t i = ledger.size(); i-- > 0;) {
+				if (ledger[i].holder == &r) {
+					ledger[i].holder = this;
+					from_anchor = ledger[i].anchor == &r;
+					break;
+				}
+			}
+			borrowed = r.borrowed;
+			r.borrowed = from_anchor ? -1 : 0;
+		}
+
+		void promote_borrowed() noexcept {
+#if SOL_IS_ON(SOL_SAFE_STACK_CHECK)
+			luaL_checkstack(luastate, 1, "not enough Lua stack space to push this reference value");
+#endif // make sure stack doesn't overflow
+			lua_pushvalue(luastate, borrowed);
+			ref = luaL_ref(luastate, LUA_REGISTRYINDEX);
+			borrowed = 0;
+		}
+
+		void release_borrowed() noexcept {
+			std::vector<borrow_entry>& ledger = borrow_ledger();
+			for (std::size_t i = ledger.size(); i-- > 0;) {
+				borrow_entry& entry = ledger[i];
+				if (entry.anchor == this) {
+					// the call is ending: anything still holding the value
+					// outlives the stack slot, so it gets a real reference now
+					if (entry.holder != nullptr && entry.holder != this) {
+						entry.holder->promote_borrowed();
+					}
+					// anything above belongs to calls that were unwound past us
+					ledger.resize(i);
+					break;
+				}
+				if (entry.holder == this) {
+					entry.holder = nullptr;
+					break;
+				}
+			}
+			borrowed = 0;
+			if (ref == detail::borrowed_ref) {
+				ref = LUA_NOREF;
+			}
+		}
+
+		void check_borrowed() const noexcept {
+			const std::vector<borrow_entry>& ledger = borrow_ledger();
+			for (std::size_t i = ledger.size(); i-- > 0;) {
+				const borrow_entry& entry = ledger[i];
+				if (entry.holder == this) {
+					if (lua_type(luastate, borrowed) == entry.value_type && lua_topointer(luastate, borrowed) == entry.pointer) {
+						return;
+					}
+					break;
+				}
+			}
+			luaL_error(luastate,
+			     "sol: a borrowed table, function or object argument was used after its call returned or from inside another call; copy it to "
+			     "keep it");
+		}
+
 		template <bool r_main_only>
 		void copy_assign_complex(const basic_reference<r_main_only>& r) {
+			if (borrowed != 0) {
+				release_borrowed();
+			}
 			if (valid()) {
 				deref();
 			}
@@ -506,6 +606,9 @@ namespace sol {
 
 		template <bool r_main_only>
 		void move_assign(basic_reference<r_main_only>&& r) {
+			if (borrowed != 0) {
+				release_borrowed();
+			}
 			if (valid()) {
 				deref();
 			}
@@ -526,6 +629,18 @@ namespace sol {
 			}
 
 			luastate = detail::pick_main_thread < main_only && !r_main_only > (r.lua_state(), r.lua_state());
+			if (r.borrowed > 0) {
+				if constexpr (main_only == r_main_only) {
+					ref = r.ref;
+					r.ref = LUA_NOREF;
+					r.luastate = nullptr;
+					adopt_borrowed(r);
+				}
+				else {
+					ref = r.copy_ref();
+				}
+				return;
+			}
 			ref = r.ref;
 			r.ref = LUA_NOREF;
 			r.luastate = nullptr;
@@ -538,7 +653,8 @@ namespace sol {
 		basic_reference(lua_State* L_, global_tag_t, global_tag_t) noexcept : stateless_reference(L_, global_tag), luastate(L_) {
 		}
 
-		basic_reference(lua_State* oL, const basic_reference<!main_only>& o) noexcept : stateless_reference(oL, o), luastate(oL) {
+		basic_reference(lua_State* oL, const basic_reference<!main_only>& o) noexcept
+		: stateless_reference(oL == nullptr ? LUA_NOREF : o.copy_ref(oL)), luastate(oL) {
 		}
 
 		void deref() const noexcept {
@@ -550,6 +666,10 @@ namespace sol {
 		}
 
 		int copy_ref(lua_State* L_) const noexcept {
+			if (borrowed > 0) {
+				push(L_);
+				return luaL_ref(L_, LUA_REGISTRYINDEX);
+			}
 			return stateless_reference::copy_ref(L_);
 		}
 
@@ -594,6 +714,10 @@ namespace sol {
 				ref = luaL_ref(lua_state(), LUA_REGISTRYINDEX);
 				return;
 			}
+			if (r.borrowed > 0) {
+				ref = r.copy_ref();
+				return;
+			}
 			ref = r.ref;
 			r.ref = LUA_NOREF;
 			r.luastate = nullptr;
@@ -626,10 +750,40 @@ namespace sol {
 			lua_rawgeti(lua_state(), LUA_REGISTRYINDEX, index.index);
 			ref = luaL_ref(lua_state(), LUA_REGISTRYINDEX);
 		}
+		// refers to the value in the stack slot directly: only meant for arguments of
+		// the C function currently running; copies (and anything still holding the
+		// value when the call ends) get promoted to a registry reference
+		basic_reference(lua_State* L_, detail::borrowed_index index_) noexcept : luastate(detail::pick_main_thread<main_only>(L_, L_)) {
+			if constexpr (main_only) {
+#if SOL_IS_ON(SOL_SAFE_STACK_CHECK)
+				luaL_checkstack(L_, 1, "not enough Lua stack space to push this reference value");
+#endif // make sure stack doesn't overflow
+				lua_pushvalue(L_, index_.index);
+				ref = luaL_ref(L_, LUA_REGISTRYINDEX);
+			}
+			else {
+				int index = lua_absindex(L_, index_.index);
+				int value_type = lua_type(L_, index);
+				if (value_type == LUA_TNONE || value_type == LUA_TNIL) {
+					ref = LUA_REFNIL;
+					return;
+				}
+				ref = detail::borrowed_ref;
+				borrowed = index;
+#if SOL_IS_ON(SOL_SAFE_REFERENCES)
+				borrow_ledger().push_back(borrow_entry { this, this, lua_topointer(L_, index), value_type });
+#else
+				borrow_ledger().push_back(borrow_entry { this, this, nullptr, value_type });
+#endif // Safety
+			}
+		}
 		basic_reference(lua_State* L_, lua_nil_t) noexcept : luastate(detail::pick_main_thread<main_only>(L_, L_)) {
 		}
 
 		~basic_reference() noexcept {
+			if (borrowed != 0) {
+				release_borrowed();
+			}
 			if (lua_state() == nullptr || ref == LUA_NOREF)
 				return;
 			deref();
@@ -640,6 +794,9 @@ namespace sol {
 
 		basic_reference(basic_reference&& o) noexcept : stateless_reference(std::move(o)), luastate(o.lua_state()) {
 			o.luastate = nullptr;
+			if (o.borrowed > 0) {
+				adopt_borrowed(o);
+			}
 		}
 
 		basic_reference(const basic_reference<!main_only>& o) noexcept
@@ -648,6 +805,12 @@ namespace sol {
 
 		basic_reference(basic_reference<!main_only>&& o) noexcept
 		: stateless_reference(std::move(o)), luastate(detail::pick_main_thread<main_only>(o.lua_state(), o.lua_state())) {
+			if (o.borrowed > 0) {
+				// the other kind of reference cannot take over the borrow
+				o.ref = ref;
+				ref = o.copy_ref();
+				return;
+			}
 			o.luastate = nullptr;
 			o.ref = LUA_NOREF;
 		}
@@ -688,6 +851,9 @@ namespace sol {
 		}
 
 		void reset() noexcept {
+			if (borrowed != 0) {
+				release_borrowed();
+			}
 			stateless_reference::reset(luastate);
 			luastate = nullptr;
 		}
@@ -700,7 +866,15 @@ namespace sol {
 				lua_pushnil(L_);
 				return 1;
 			}
-			lua_rawgeti(lua_state(), LUA_REGISTRYINDEX, ref);
+			if (borrowed > 0) {
+#if SOL_IS_ON(SOL_SAFE_REFERENCES)
+				check_borrowed();
+#endif // Safety
+				lua_pushvalue(lua_state(), borrowed);
+			}
+			else {
+				lua_rawgeti(lua_state(), LUA_REGISTRYINDEX, ref);
+			}
 			if (L_ != lua_state()) {
 				lua_xmove(lua_state(), L_, 1);
 			}
@@ -727,7 +901,17 @@ namespace sol {
 			return stateless_reference::valid(L_);
 		}
 
+		bool is_borrowed() const noexcept {
+			return borrowed > 0;
+		}
+
 		const void* pointer() const noexcept {
+			if (borrowed > 0) {
+#if SOL_IS_ON(SOL_SAFE_REFERENCES)
+				check_borrowed();
+#endif // Safety
+				return lua_topointer(lua_state(), borrowed);
+			}
 			return stateless_reference::pointer(lua_state());
 		}
 
@@ -736,6 +920,12 @@ namespace sol {
 		}
 
 		type get_type() const noexcept {
+			if (borrowed > 0) {
+#if SOL_IS_ON(SOL_SAFE_REFERENCES)
+				check_borrowed();
+#endif // Safety
+				return static_cast<type>(lua_type(lua_state(), borrowed));
+			}
 			return stateless_reference::get_type(lua_state());
 		}
 
@@ -0,0 +1,420 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_SANDBOX_HPP
+#define SOL_SANDBOX_HPP
+
+#include <sol/state_view.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <initializer_list>
+
+namespace sol {
+
+	enum class sandbox_violation : int {
+		none,
+		memory,
+		instructions,
+		time,
+	};
+
+	inline const std::string& to_string(sandbox_violation v) {
+		static const std::array<std::string, 4> names { { "none", "memory", "instructions", "time" } };
+		return names[static_cast<std::size_t>(v)];
+	}
+
+	struct sandbox_limits {
+		// all limits are per-run, and 0 (or a zero duration) means "unlimited"
+		// memory is the maximum net growth of the Lua heap, in bytes
+		std::size_t memory = 0;
+		// instructions are counted in multiples of the hook interval
+		std::size_t instructions = 0;
+		std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+		// how many VM instructions run between budget checks
+		int hook_interval = 1000;
+	};
+
+	namespace detail {
+		inline const void* sandbox_registry_key() noexcept {
+			static const char key = 0;
+			return static_cast<const void*>(&key);
+		}
+
+		inline const std::array<string_view, 24>& default_sandbox_globals() {
+			static const std::array<string_view, 24> names { { "assert",
+				"error",
+				"ipairs",
+				"next",
+				"pairs",
+				"pcall",
+				"print",
+				"rawequal",
+				"rawget",
+				"rawlen",
+				"rawset",
+				"select",
+				"setmetatable",
+				"tonumber",
+				"tostring",
+				"type",
+				"unpack",
+				"xpcall",
+				"_VERSION",
+				"coroutine",
+				"math",
+				"string",
+				"table",
+				"utf8" } };
+			return names;
+		}
+	} // namespace detail
+
+	class sandbox {
+	private:
+		lua_State* m_L;
+		sandbox_limits m_limits;
+		table m_template;
+		environment m_env;
+		lua_Alloc m_parent_alloc;
+		void* m_parent_alloc_ud;
+		std::ptrdiff_t m_memory_used;
+		std::ptrdiff_t m_peak_memory_used;
+		std::size_t m_instructions_used;
+		std::chrono::steady_clock::time_point m_deadline;
+		sandbox_violation m_violation;
+
+		static constexpr bool can_track_memory() noexcept {
+#if SOL_IS_ON(SOL_USE_LUAJIT) && SOL_LUAJIT_VERSION_I_ < 20100 && (UINTPTR_MAX > 0xFFFFFFFF)
+			// LuaJIT 2.0.X in x64 mode does not support a custom allocator
+			return false;
+#else
+			return true;
+#endif
+		}
+
+		static void* allocate(void* ud, void* ptr, std::size_t osize, std::size_t nsize) noexcept {
+			sandbox& self = *static_cast<sandbox*>(ud);
+			// when ptr is null, osize is an object type code, not a size
+			std::ptrdiff_t old_size = ptr == nullptr ? 0 : static_cast<std::ptrdiff_t>(osize);
+			std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(nsize) - old_size;
+			if (difference > 0 && self.m_limits.memory != 0) {
+				if (self.m_memory_used + difference > static_cast<std::ptrdiff_t>(self.m_limits.memory)) {
+					// refusing growth makes Lua raise a memory error;
+					// shrinking and freeing always go through
+					self.m_violation = sandbox_violation::memory;
+					return nullptr;
+				}
+			}
+			void* result = self.m_parent_alloc(self.m_parent_alloc_ud, ptr, osize, nsize);
+			if (result != nullptr || nsize == 0) {
+				self.m_memory_used += difference;
+				if (self.m_memory_used > self.m_peak_memory_used) {
+					self.m_peak_memory_used = self.m_memory_used;
+				}
+			}
+			return result;
+		}
+
+		static void budget_hook(lua_State* L_, lua_Debug*) {
+			lua_rawgetp(L_, LUA_REGISTRYINDEX, detail::sandbox_registry_key());
+			sandbox* self = static_cast<sandbox*>(lua_touserdata(L_, -1));
+			lua_pop(L_, 1);
+			if (self == nullptr) {
+				// a coroutine created inside of a sandbox inherits the hook,
+				// but it may outlive the run: nothing to check
+				return;
+			}
+			self->m_instructions_used += static_cast<std::size_t>(self->m_limits.hook_interval);
+			if (self->m_limits.instructions != 0 && self->m_instructions_used > self->m_limits.instructions) {
+				self->m_violation = sandbox_violation::instructions;
+				// lua_pushfstring has no format for a size_t before 5.3, and %d would truncate it
+				char budget[32];
+				std::snprintf(budget, sizeof(budget), "%zu", self->m_limits.instructions);
+				luaL_error(L_, "sol: sandbox exceeded its budget of %s instructions", budget);
+				return;
+			}
+			if (self->m_limits.time != std::chrono::steady_clock::duration::zero() && std::chrono::steady_clock::now() >= self->m_deadline) {
+				self->m_violation = sandbox_violation::time;
+				luaL_error(L_, "sol: sandbox exceeded its time budget");
+				return;
+			}
+		}
+
+		struct activation {
+			sandbox& self;
+			void* previous_sandbox;
+			lua_Hook previous_hook;
+			int previous_hook_mask;
+			int previous_hook_count;
+			bool hooked;
+
+			activation(sandbox& self_)
+			: self(self_), previous_sandbox(nullptr), previous_hook(nullptr), previous_hook_mask(0), previous_hook_count(0), hooked(false) {
+				lua_State* L_ = self.m_L;
+				self.m_violation = sandbox_violation::none;
+				self.m_memory_used = 0;
+				self.m_peak_memory_used = 0;
+				self.m_instructions_used = 0;
+				self.m_deadline = std::chrono::steady_clock::now() + self.m_limits.time;
+
+				// sandboxes may nest on the same state:
+				// remember who was active before us
+				lua_rawgetp(L_, LUA_REGISTRYINDEX, detail::sandbox_registry_key());
+				previous_sandbox = lua_touserdata(L_, -1);
+				lua_pop(L_, 1);
+				lua_pushlightuserdata(L_, static_cast<void*>(&self));
+				lua_rawsetp(L_, LUA_REGISTRYINDEX, detail::sandbox_registry_key());
+
+				if constexpr (can_track_memory()) {
+					self.m_parent_alloc = lua_getallocf(L_, &self.m_parent_alloc_ud);
+					lua_setallocf(L_, &sandbox::allocate, static_cast<void*>(&self));
+				}
+
+				bool needs_hook = self.m_limits.instructions != 0 || self.m_limits.time != std::chrono::steady_clock::duration::zero();
+				if (needs_hook) {
+					previous_hook = lua_gethook(L_);
+					previous_hook_mask = lua_gethookmask(L_);
+					previous_hook_count = lua_gethookcount(L_);
+					lua_sethook(L_, &sandbox::budget_hook, LUA_MASKCOUNT, (std::max)(self.m_limits.hook_interval, 1));
+					hooked = true;
+				}
+			}
+
+			activation(const activation&) = delete;
+			activation& operator=(const activation&) = delete;
+
+			~activation() {
+				lua_State* L_ = self.m_L;
+				if (hooked) {
+					lua_sethook(L_, previous_hook, previous_hook_mask, previous_hook_count);
+				}
+				if constexpr (can_track_memory()) {
+					lua_setallocf(L_, self.m_parent_alloc, self.m_parent_alloc_ud);
+				}
+				if (previous_sandbox == nullptr) {
+					lua_pushnil(L_);
+				}
+				else {
+					lua_pushlightuserdata(L_, previous_sandbox);
+				}
+				lua_rawsetp(L_, LUA_REGISTRYINDEX, detail::sandbox_registry_key());
+			}
+		};
+
+		template <typename Fx>
+		decltype(auto) enter(Fx&& fx) {
+			activation act(*this);
+			return fx();
+		}
+
+		template <typename It>
+		void add_to_template(It first, It last) {
+			auto pp = stack::push_pop(m_template);
+			int template_index = pp.index_of(m_template);
+			lua_pushglobaltable(m_L);
+			int globals_index = lua_gettop(m_L);
+			for (; first != last; ++first) {
+				string_view name = *first;
+				lua_pushlstring(m_L, name.data(), name.size());
+				lua_pushvalue(m_L, -1);
+				lua_rawget(m_L, globals_index);
+				if (lua_type(m_L, -1) == LUA_TNIL) {
+					// not present in this state (e.g., library was never opened)
+					lua_pop(m_L, 2);
+					continue;
+				}
+				lua_rawset(m_L, template_index);
+			}
+			lua_pop(m_L, 1);
+		}
+
+		struct no_globals_tag { };
+
+		sandbox(lua_State* L_, sandbox_limits limits_, no_globals_tag)
+		: m_L(L_)
+		, m_limits(limits_)
+		, m_template(L_, create)
+		, m_env(L_, create)
+		, m_parent_alloc(nullptr)
+		, m_parent_alloc_ud(nullptr)
+		, m_memory_used(0)
+		, m_peak_memory_used(0)
+		, m_instructions_used(0)
+		, m_deadline()
+		, m_violation(sandbox_violation::none) {
+		}
+
+	public:
+		sandbox(lua_State* L_, sandbox_limits limits_ = {}) : sandbox(L_, limits_, no_globals_tag {}) {
+			add_to_template(detail::default_sandbox_globals().cbegin(), detail::default_sandbox_globals().cend());
+			reset();
+		}
+
+		sandbox(lua_State* L_, sandbox_limits limits_, std::initializer_list<string_view> allowed_globals_) : sandbox(L_, limits_, no_globals_tag {}) {
+			add_to_template(allowed_globals_.begin(), allowed_globals_.end());
+			reset();
+		}
+
+		sandbox(const sandbox&) = delete;
+		sandbox(sandbox&&) = default;
+		sandbox& operator=(const sandbox&) = delete;
+		sandbox& operator=(sandbox&&) = default;
+
+		lua_State* lua_state() const noexcept {
+			return m_L;
+		}
+
+		const sandbox_limits& limits() const noexcept {
+			return m_limits;
+		}
+
+		void set_limits(sandbox_limits limits_) noexcept {
+			m_limits = limits_;
+		}
+
+		const environment& env() const noexcept {
+			return m_env;
+		}
+
+		environment& env() noexcept {
+			return m_env;
+		}
+
+		// the global names copied (shallowly, for tables) into the environment on every reset
+		void allow(string_view name) {
+			add_to_template(&name, &name + 1);
+		}
+
+		void reset() {
+			lua_State* L_ = m_L;
+			auto env_pp = stack::push_pop(m_env);
+			int env_index = env_pp.index_of(m_env);
+			stack::clear(L_, env_index);
+			lua_pushnil(L_);
+			lua_setmetatable(L_, env_index);
+
+			auto template_pp = stack::push_pop(m_template);
+			int template_index = template_pp.index_of(m_template);
+			lua_pushnil(L_);
+			while (lua_next(L_, template_index) != 0) {
+				if (lua_type(L_, -1) == LUA_TTABLE) {
+					// library tables are copied so a script
+					// cannot poison them for the host or for the next run
+					int source_index = lua_gettop(L_);
+					lua_createtable(L_, 0, 0);
+					int copy_index = lua_gettop(L_);
+					lua_pushnil(L_);
+					while (lua_next(L_, source_index) != 0) {
+						lua_pushvalue(L_, -2);
+						lua_insert(L_, -2);
+						lua_rawset(L_, copy_index);
+					}
+					lua_replace(L_, source_index);
+				}
+				lua_pushvalue(L_, -2);
+				lua_insert(L_, -2);
+				lua_rawset(L_, env_index);
+			}
+			lua_pushliteral(L_, "_G");
+			lua_pushvalue(L_, env_index);
+			lua_rawset(L_, env_index);
+
+			m_violation = sandbox_violation::none;
+			m_memory_used = 0;
+			m_peak_memory_used = 0;
+			m_instructions_used = 0;
+		}
+
+		sandbox_violation violation() const noexcept {
+			return m_violation;
+		}
+
+		// net bytes the Lua heap grew by during the last run
+		std::size_t memory_used() const noexcept {
+			return m_memory_used > 0 ? static_cast<std::size_t>(m_memory_used) : 0;
+		}
+
+		std::size_t peak_memory_used() const noexcept {
+			return static_cast<std::size_t>(m_peak_memory_used);
+		}
+
+		std::size_t instructions_used() const noexcept {
+			return m_instructions_used;
+		}
+
+		load_result load(const string_view& code, const std::string& chunkname = detail::default_chunk_name(), load_mode mode = load_mode::text) {
+			return enter([&]() {
+				load_result lr = state_view(m_L).load(code, chunkname, mode);
+				if (lr.valid()) {
+					set_environment(m_env, stack_reference(m_L, lr.stack_index()));
+				}
+				return lr;
+			});
+		}
+
+		template <typename... Args>
+		protected_function_result call(const protected_function& fx, Args&&... args) {
+			return enter([&]() { return fx(std::forward<Args>(args)...); });
+		}
+
+		template <typename Fx,
+		     meta::disable_any<meta::is_string_constructible<meta::unqualified_t<Fx>>,
+		          meta::is_specialization_of<meta::unqualified_t<Fx>, basic_environment>> = meta::enabler>
+		protected_function_result safe_script(
+		     const string_view& code, Fx&& on_error, const std::string& chunkname = detail::default_chunk_name(), load_mode mode = load_mode::text) {
+			protected_function_result pfr
+			     = enter([&]() { return state_view(m_L).safe_script(code, m_env, script_pass_on_error, chunkname, mode); });
+			if (!pfr.valid()) {
+				return on_error(m_L, std::move(pfr));
+			}
+			return pfr;
+		}
+
+		protected_function_result safe_script(
+		     const string_view& code, const std::string& chunkname = detail::default_chunk_name(), load_mode mode = load_mode::text) {
+			return safe_script(code, script_default_on_error, chunkname, mode);
+		}
+
+		template <typename Fx,
+		     meta::disable_any<meta::is_string_constructible<meta::unqualified_t<Fx>>,
+		          meta::is_specialization_of<meta::unqualified_t<Fx>, basic_environment>> = meta::enabler>
+		protected_function_result safe_script_file(const std::string& filename, Fx&& on_error, load_mode mode = load_mode::text) {
+			protected_function_result pfr = enter([&]() { return state_view(m_L).safe_script_file(filename, m_env, script_pass_on_error, mode); });
+			if (!pfr.valid()) {
+				return on_error(m_L, std::move(pfr));
+			}
+			return pfr;
+		}
+
+		protected_function_result safe_script_file(const std::string& filename, load_mode mode = load_mode::text) {
+			return safe_script_file(filename, script_default_on_error, mode);
+		}
+	};
+
+} // namespace sol
+
+#endif // SOL_SANDBOX_HPP
@@ -0,0 +1,320 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_SEQUENCE_VIEW_HPP
+#define SOL_SEQUENCE_VIEW_HPP
+
+#include <sol/stack.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace sol {
+
+	// A read-only, random-access view over the array part (1 .. #t) of a table.
+	// The table is kept on the stack for the lifetime of the view and every
+	// element is read with lua_rawgeti: no proxies, no metamethods, no allocation.
+	template <typename T>
+	class sequence_view {
+	private:
+		lua_State* m_L;
+		int m_index;
+		std::size_t m_size;
+		bool m_owns_slot;
+
+		void m_clear() noexcept {
+			if (m_owns_slot && m_L != nullptr) {
+				lua_remove(m_L, m_index);
+			}
+			m_owns_slot = false;
+		}
+
+		// views the table `right` views; a slot we own is refilled in place
+		// rather than removed, so no other slot on the stack moves;
+		// returns true when this view took over right's slot instead
+		bool m_assign(const sequence_view& right, bool owns) noexcept {
+			if (m_owns_slot && m_L == right.m_L) {
+				if (m_index != right.m_index) {
+					lua_pushvalue(m_L, right.m_index);
+					lua_replace(m_L, m_index);
+				}
+				m_size = right.m_size;
+				return false;
+			}
+			m_clear();
+			m_L = right.m_L;
+			m_index = right.m_index;
+			m_size = right.m_size;
+			m_owns_slot = owns;
+			return owns;
+		}
+
+		void m_measure() noexcept {
+			m_size = lua_type(m_L, m_index) == LUA_TTABLE ? static_cast<std::size_t>(lua_rawlen(m_L, m_index)) : 0;
+		}
+
+	public:
+		using value_type = T;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		class iterator {
+		private:
+			lua_State* m_L;
+			int m_index;
+			lua_Integer m_position;
+
+		public:
+			using value_type = T;
+			using reference = T;
+			using pointer = void;
+			using difference_type = std::ptrdiff_t;
+			// elements are produced on demand, so `reference` is a value:
+			// enough for every non-mutating algorithm, and a random_access_iterator for <ranges>
+			using iterator_category = std::random_access_iterator_tag;
+			using iterator_concept = std::random_access_iterator_tag;
+
+			iterator() noexcept : m_L(nullptr), m_index(0), m_position(1) {
+			}
+			iterator(lua_State* L, int index, lua_Integer position) noexcept : m_L(L), m_index(index), m_position(position) {
+			}
+
+			reference operator*() const {
+				lua_rawgeti(m_L, m_index, m_position);
+				T value = stack::get<T>(m_L, -1);
+				lua_pop(m_L, 1);
+				return value;
+			}
+
+			reference operator[](difference_type n) const {
+				return *(*this + n);
+			}
+
+			// the 1-based Lua index of the element this iterator refers to
+			lua_Integer lua_index() const noexcept {
+				return m_position;
+			}
+
+			iterator& operator++() noexcept {
+				++m_position;
+				return *this;
+			}
+
+			iterator operator++(int) noexcept {
+				iterator it = *this;
+				++m_position;
+				return it;
+			}
+
+			iterator& operator--() noexcept {
+				--m_position;
+				return *this;
+			}
+
+			iterator operator--(int) noexcept {
+				iterator it = *this;
+				--m_position;
+				return it;
+			}
+
+			iterator& operator+=(difference_type n) noexcept {
+				m_position += static_cast<lua_Integer>(n);
+				return *this;
+			}
+
+			iterator& operator-=(difference_type n) noexcept {
+				m_position -= static_cast<lua_Integer>(n);
+				return *this;
+			}
+
+			friend iterator operator+(iterator it, difference_type n) noexcept {
+				return it += n;
+			}
+
+			friend iterator operator+(difference_type n, iterator it) noexcept {
+				return it += n;
+			}
+
+			friend iterator operator-(iterator it, difference_type n) noexcept {
+				return it -= n;
+			}
+
+			friend difference_type operator-(const iterator& left, const iterator& right) noexcept {
+				return static_cast<difference_type>(left.m_position - right.m_position);
+			}
+
+			friend bool operator==(const iterator& left, const iterator& right) noexcept {
+				return left.m_position == right.m_position;
+			}
+
+			friend bool operator!=(const iterator& left, const iterator& right) noexcept {
+				return left.m_position != right.m_position;
+			}
+
+			friend bool operator<(const iterator& left, const iterator& right) noexcept {
+				return left.m_position < right.m_position;
+			}
+
+			friend bool operator>(const iterator& left, const iterator& right) noexcept {
+				return left.m_position > right.m_position;
+			}
+
+			friend bool operator<=(const iterator& left, const iterator& right) noexcept {
+				return left.m_position <= right.m_position;
+			}
+
+			friend bool operator>=(const iterator& left, const iterator& right) noexcept {
+				return left.m_position >= right.m_position;
+			}
+		};
+
+		using const_iterator = iterator;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = reverse_iterator;
+
+		sequence_view() noexcept : m_L(nullptr), m_index(0), m_size(0), m_owns_slot(false) {
+		}
+
+		// views a table already on the stack; the slot must outlive the view
+		sequence_view(lua_State* L, int index) noexcept : m_L(L), m_index(lua_absindex(L, index)), m_size(0), m_owns_slot(false) {
+			m_measure();
+		}
+
+		// pushes the table and keeps it on the stack until the view is destroyed
+		template <typename Ref, meta::enable<is_lua_reference<meta::unqualified_t<Ref>>> = meta::enabler>
+		sequence_view(const Ref& table) : m_L(table.lua_state()), m_index(0), m_size(0), m_owns_slot(true) {
+			table.push(m_L);
+			m_index = lua_gettop(m_L);
+			m_measure();
+		}
+
+		// copies only alias the slot, like a stack_reference: they must not outlive the view that pinned the table
+		sequence_view(const sequence_view& right) noexcept : m_L(right.m_L), m_index(right.m_index), m_size(right.m_size), m_owns_slot(false) {
+		}
+
+		sequence_view& operator=(const sequence_view& right) noexcept {
+			if (this != &right) {
+				m_assign(right, false);
+			}
+			return *this;
+		}
+
+		sequence_view(sequence_view&& right) noexcept
+		: m_L(right.m_L), m_index(right.m_index), m_size(right.m_size), m_owns_slot(right.m_owns_slot) {
+			right.m_owns_slot = false;
+		}
+
+		sequence_view& operator=(sequence_view&& right) noexcept {
+			if (this != &right) {
+				if (m_assign(right, right.m_owns_slot)) {
+					right.m_owns_slot = false;
+				}
+			}
+			return *this;
+		}
+
+		~sequence_view() {
+			m_clear();
+		}
+
+		iterator begin() const noexcept {
+			return iterator(m_L, m_index, 1);
+		}
+
+		iterator end() const noexcept {
+			return iterator(m_L, m_index, static_cast<lua_Integer>(m_size) + 1);
+		}
+
+		const_iterator cbegin() const noexcept {
+			return begin();
+		}
+
+		const_iterator cend() const noexcept {
+			return end();
+		}
+
+		reverse_iterator rbegin() const noexcept {
+			return reverse_iterator(end());
+		}
+
+		reverse_iterator rend() const noexcept {
+			return reverse_iterator(begin());
+		}
+
+		// 0-based, like every other C++ range; element i is t[i + 1]
+		T operator[](size_type i) const {
+			return begin()[static_cast<difference_type>(i)];
+		}
+
+		T front() const {
+			return *begin();
+		}
+
+		T back() const {
+			return *(end() - 1);
+		}
+
+		size_type size() const noexcept {
+			return m_size;
+		}
+
+		bool empty() const noexcept {
+			return m_size == 0;
+		}
+
+		// re-reads #t, for when the table was resized while the view is alive
+		void refresh() noexcept {
+			m_measure();
+		}
+
+		lua_State* lua_state() const noexcept {
+			return m_L;
+		}
+
+		int stack_index() const noexcept {
+			return m_index;
+		}
+	};
+
+	template <typename T>
+	struct is_container<sequence_view<T>> : std::false_type { };
+
+	namespace detail {
+		template <typename T>
+		struct lua_type_of<sequence_view<T>> : std::integral_constant<type, type::table> { };
+	} // namespace detail
+
+	namespace stack {
+		template <typename T>
+		struct unqualified_getter<sequence_view<T>> {
+			static sequence_view<T> get(lua_State* L, int index, record& tracking) {
+				tracking.use(1);
+				return sequence_view<T>(L, index);
+			}
+		};
+	} // namespace stack
+
+} // namespace sol
+
+#endif // SOL_SEQUENCE_VIEW_HPP
@@ -50,17 +50,29 @@
 #include <sol/assert.hpp>
 #include <sol/bytecode.hpp>
 #include <sol/stack.hpp>
+#include <sol/deferred_destruction.hpp>
 #include <sol/object.hpp>
 #include <sol/function.hpp>
 #include <sol/protected_function.hpp>
 #include <sol/usertype.hpp>
+#include <sol/static_usertype.hpp>
 #include <sol/table.hpp>
 #include <sol/state.hpp>
+#include <sol/sandbox.hpp>
 #include <sol/coroutine.hpp>
 #include <sol/thread.hpp>
+#include <sol/generator.hpp>
+#include <sol/isolated_thread.hpp>
+#include <sol/package_index.hpp>
 #include <sol/userdata.hpp>
 #include <sol/metatable.hpp>
 #include <sol/as_args.hpp>
+#include <sol/as_iterator.hpp>
+#include <sol/sequence_view.hpp>
+#include <sol/parallel_for.hpp>
+#include <sol/record.hpp>
+#include <sol/lua_buffer.hpp>
+#include <sol/interned.hpp>
 #include <sol/variadic_args.hpp>
 #include <sol/variadic_results.hpp>
 #include <sol/lua_value.hpp>
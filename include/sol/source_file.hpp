@@ -0,0 +1,193 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SOL_SOURCE_FILE_HPP
+#define SOL_SOURCE_FILE_HPP
+
+#include <sol/types.hpp>
+#include <sol/string_view.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#if SOL_IS_ON(SOL_MAPPED_FILE_LOAD)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sol { namespace detail {
+
+	// one fopen, one fread: the whole file lands in memory at once
+	inline bool read_whole_file(const std::string& path, std::string& out) {
+		std::FILE* file = std::fopen(path.c_str(), "rb");
+		if (file == nullptr) {
+			return false;
+		}
+		bool ok = std::fseek(file, 0, SEEK_END) == 0;
+		long size = ok ? std::ftell(file) : -1;
+		ok = size >= 0 && std::fseek(file, 0, SEEK_SET) == 0;
+		if (ok) {
+			out.resize(static_cast<std::size_t>(size));
+			std::size_t read = size > 0 ? std::fread(&out[0], 1, out.size(), file) : 0;
+			ok = std::ferror(file) == 0;
+			out.resize(read);
+		}
+		std::fclose(file);
+		return ok;
+	}
+
+	// what luaL_loadfilex skips: a UTF-8 BOM, then a leading '#' line;
+	// the line's newline is kept so line numbers hold, unless a binary chunk follows
+	inline string_view source_file_body(string_view contents) {
+		if (contents.size() >= 3 && contents.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+			contents.remove_prefix(3);
+		}
+		if (!contents.empty() && contents[0] == '#') {
+			std::size_t newline = contents.find('\n');
+			contents.remove_prefix(newline == string_view::npos ? contents.size() : newline);
+			if (contents.size() > 1 && contents[1] == LUA_SIGNATURE[0]) {
+				contents.remove_prefix(1);
+			}
+		}
+		return contents;
+	}
+
+	// a read-only view of a whole file: mapped where the platform allows, read in one go otherwise
+	class source_file {
+	private:
+		const char* m_data;
+		std::size_t m_size;
+		bool m_mapped;
+		std::string m_buffer;
+
+	public:
+		enum class open_result { ok, failed, not_regular };
+
+		source_file() noexcept : m_data(nullptr), m_size(0), m_mapped(false), m_buffer() {
+		}
+		source_file(const source_file&) = delete;
+		source_file& operator=(const source_file&) = delete;
+
+		~source_file() {
+#if SOL_IS_ON(SOL_MAPPED_FILE_LOAD)
+			if (m_mapped) {
+				::munmap(const_cast<char*>(m_data), m_size);
+			}
+#endif
+		}
+
+		open_result open(const std::string& filename) {
+#if SOL_IS_ON(SOL_MAPPED_FILE_LOAD)
+			int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0) {
+				return open_result::failed;
+			}
+			struct stat info;
+			if (::fstat(fd, &info) != 0) {
+				::close(fd);
+				return open_result::failed;
+			}
+			if (!S_ISREG(info.st_mode)) {
+				// pipes, devices and the like have no size to map
+				::close(fd);
+				return open_result::not_regular;
+			}
+			m_size = static_cast<std::size_t>(info.st_size);
+			if (m_size == 0) {
+				::close(fd);
+				m_data = "";
+				return open_result::ok;
+			}
+			void* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (mapping != MAP_FAILED) {
+#if defined(MADV_SEQUENTIAL)
+				::madvise(mapping, m_size, MADV_SEQUENTIAL);
+#endif
+				m_data = static_cast<const char*>(mapping);
+				m_mapped = true;
+				return open_result::ok;
+			}
+			m_size = 0;
+			// some filesystems cannot be mapped: read those instead
+#endif
+			if (!read_whole_file(filename, m_buffer)) {
+				return open_result::failed;
+			}
+			m_data = m_buffer.data();
+			m_size = m_buffer.size();
+			return open_result::ok;
+		}
+
+		string_view view() const noexcept {
+			return string_view(m_data, m_size);
+		}
+
+		bool mapped() const noexcept {
+			return m_mapped;
+		}
+	};
+
+	struct source_file_reader {
+		string_view body;
+	};
+
+	inline const char* read_source_file(lua_State*, void* data, std::size_t* size) {
+		source_file_reader& reader = *static_cast<source_file_reader*>(data);
+		*size = reader.body.size();
+		const char* chunk = reader.body.empty() ? nullptr : reader.body.data();
+		reader.body = string_view();
+		return chunk;
+	}
+
+	// luaL_loadfilex, minus the stdio buffering: the file goes to lua_load as a single chunk,
+	// named "@filename" so errors point at the file, with the same BOM and '#' line handling
+	inline int load_source_file(lua_State* L, const std::string& filename, load_mode mode = load_mode::any) {
+		int status = LUA_OK;
+		{
+			source_file file;
+			source_file::open_result opened = file.open(filename);
+			if (opened == source_file::open_result::not_regular) {
+				status = luaL_loadfilex(L, filename.c_str(), to_string(mode).c_str());
+			}
+			else if (opened == source_file::open_result::failed) {
+				int error_number = errno;
+				lua_pushfstring(L, "cannot open %s: %s", filename.c_str(), std::strerror(error_number));
+				status = LUA_ERRFILE;
+			}
+			else {
+				std::string chunkname = "@" + filename;
+				source_file_reader reader { source_file_body(file.view()) };
+				status = lua_load(L, &read_source_file, &reader, chunkname.c_str(), to_string(mode).c_str());
+			}
+		}
+		return status;
+	}
+
+}} // namespace sol::detail
+
+#endif // SOL_SOURCE_FILE_HPP
@@ -35,6 +35,7 @@
 #include <sol/stack_field.hpp>
 #include <sol/stack_probe.hpp>
 #include <sol/assert.hpp>
+#include <sol/source_file.hpp>
 
 #include <cstring>
 #include <array>
@@ -324,7 +325,7 @@ namespace sol {
 		}
 
 		inline void script_file(lua_State* L, const std::string& filename, load_mode mode = load_mode::any) {
-			if (luaL_loadfilex(L, filename.c_str(), to_string(mode).c_str()) || lua_pcall(L, 0, LUA_MULTRET, 0)) {
+			if (detail::load_source_file(L, filename, mode) || lua_pcall(L, 0, LUA_MULTRET, 0)) {
 				lua_error(L);
 			}
 		}
@@ -35,6 +35,10 @@
 #include <sol/stack_guard.hpp>
 #include <sol/demangle.hpp>
 #include <sol/forward_detail.hpp>
+#include <sol/external_memory.hpp>
+#include <sol/metrics.hpp>
+#include <sol/aligned_allocator.hpp>
+#include <sol/usertype_declaration.hpp>
 
 #include <vector>
 #include <bitset>
@@ -47,7 +51,20 @@
 #include <type_traits>
 
 namespace sol {
+	// specialize to std::true_type to have the garbage collector hand objects of T
+	// (or the unique holder owning them) to sol::default_deferred_destruction_queue()
+	// instead of running the destructor inside the finalizer; the queue itself lives
+	// in <sol/deferred_destruction.hpp>, which sol.hpp includes
+	template <typename T>
+	struct is_deferred_destruction : std::false_type { };
+
+	template <typename T>
+	inline constexpr bool is_deferred_destruction_v = is_deferred_destruction<T>::value;
+
 	namespace detail {
+		template <typename T>
+		void defer_destruction(T& value) noexcept;
+
 		struct with_function_tag { };
 		struct as_reference_tag { };
 		template <typename T>
@@ -125,6 +142,19 @@ namespace sol {
 			}
 		}
 
+		// over-aligned types need no room for a worse placement, nor any fix-up,
+		// when the state promises its userdata start on a boundary good enough for them
+		template <typename T>
+		bool userdata_aligned_for(lua_State* L) {
+			if constexpr (alignof(T) > alignof(std::max_align_t)) {
+				return userdata_alignment(L) >= alignof(T);
+			}
+			else {
+				(void)L;
+				return false;
+			}
+		}
+
 		inline void* align_usertype_pointer(void* ptr) {
 			using use_align = std::integral_constant<bool,
 #if SOL_IS_OFF(SOL_ALIGN_MEMORY)
@@ -323,6 +353,18 @@ namespace sol {
 				T*& pointerreference = *pointerpointer;
 				T* allocationtarget = reinterpret_cast<T*>(pointerpointer + 1);
 				pointerreference = allocationtarget;
+				count_usertype_created<T>();
+				return allocationtarget;
+			}
+
+			if (userdata_aligned_for<T>(L)) {
+				constexpr std::size_t data_offset = aligned_space_for<T*, T>(0) - sizeof(T);
+				char* block = static_cast<char*>(alloc_newuserdata(L, data_offset + sizeof(T)));
+				T** pointerpointer = reinterpret_cast<T**>(block);
+				T*& pointerreference = *pointerpointer;
+				T* allocationtarget = reinterpret_cast<T*>(block + data_offset);
+				pointerreference = allocationtarget;
+				count_usertype_created<T>();
 				return allocationtarget;
 			}
 
@@ -346,6 +388,7 @@ namespace sol {
 			T*& pointerreference = *pointerpointer;
 			T* allocationtarget = reinterpret_cast<T*>(data_adjusted);
 			pointerreference = allocationtarget;
+			count_usertype_created<T>();
 			return allocationtarget;
 		}
 
@@ -418,6 +461,10 @@ namespace sol {
 				return pointer;
 			}
 
+			if (userdata_aligned_for<T>(L)) {
+				return static_cast<T*>(alloc_newuserdata(L, sizeof(T)));
+			}
+
 			constexpr std::size_t initial_size = aligned_space_for<T>();
 
 			std::size_t allocated_size = initial_size;
@@ -436,18 +483,53 @@ namespace sol {
 			memory = align_usertype_pointer(memory);
 			T** pdata = static_cast<T**>(memory);
 			T* data = *pdata;
+			if constexpr (is_disposable_v<T>) {
+				if (data == nullptr) {
+					// disposed of already
+					return 0;
+				}
+			}
+			refund_external_memory(L, *data);
+			count_usertype_destroyed<T>();
+			if constexpr (is_deferred_destruction_v<T>) {
+				defer_destruction(*data);
+			}
 			std::allocator<T> alloc {};
 			std::allocator_traits<std::allocator<T>>::destroy(alloc, data);
 			return 0;
 		}
 
+		template <typename T, bool = is_unique_usertype_v<T>>
+		struct unique_destroy_element {
+			using type = T;
+		};
+
+		template <typename T>
+		struct unique_destroy_element<T, true> {
+			using type = unique_usertype_element_t<T>;
+		};
+
 		template <typename T>
 		int unique_destroy(lua_State* L) noexcept {
+			using element = typename unique_destroy_element<T>::type;
 			void* memory = lua_touserdata(L, 1);
+			if constexpr (has_external_size_v<element> || is_disposable_v<element>) {
+				element* data = *static_cast<element**>(align_usertype_pointer(memory));
+				if constexpr (is_disposable_v<element>) {
+					if (data == nullptr) {
+						// disposed of already
+						return 0;
+					}
+				}
+				if (data != nullptr) {
+					refund_external_memory(L, *data);
+				}
+			}
 			memory = align_usertype_unique_destructor(memory);
 			unique_destructor& dx = *static_cast<unique_destructor*>(memory);
 			memory = align_usertype_unique_tag<true>(memory);
 			(dx)(memory);
+			count_usertype_destroyed<element>();
 			return 0;
 		}
 
@@ -465,8 +547,42 @@ namespace sol {
 		void usertype_unique_alloc_destroy(void* memory) {
 			void* aligned_memory = align_usertype_unique<Real, true>(memory);
 			Real* typed_memory = static_cast<Real*>(aligned_memory);
+			if constexpr (is_deferred_destruction_v<T>) {
+				// only the owning holder moves: whatever it releases goes with it
+				defer_destruction(*typed_memory);
+			}
 			std::allocator<Real> alloc;
 			std::allocator_traits<std::allocator<Real>>::destroy(alloc, typed_memory);
+			if constexpr (is_disposable_v<T> && std::is_default_constructible_v<Real>) {
+				// leave an empty holder behind so a disposed userdata
+				// still hands out something valid when asked for it
+				std::allocator_traits<std::allocator<Real>>::construct(alloc, typed_memory);
+			}
+		}
+
+		template <typename T>
+		int disposed_error(lua_State* L) {
+			return luaL_error(L, "sol: attempt to use a '%s' after it was disposed", detail::demangle<T>().data());
+		}
+
+		template <typename T>
+		int dispose(lua_State* L) {
+			lua_CFunction gc = nullptr;
+			if (type_of(L, 1) == type::userdata && luaL_getmetafield(L, 1, "__gc") != 0) {
+				gc = lua_tocfunction(L, -1);
+				lua_pop(L, 1);
+			}
+			if (gc == &usertype_alloc_destroy<T> || gc == &unique_destroy<T>) {
+				T** pdata = static_cast<T**>(align_usertype_pointer(lua_touserdata(L, 1)));
+				// both are no-ops once the object pointer is null,
+				// so disposing twice (or closing, then collecting) is harmless
+				(gc)(L);
+				*pdata = nullptr;
+				return 0;
+			}
+			return luaL_error(L,
+			     "sol: cannot dispose of '%s': only values and unique usertypes owned by Lua can be disposed, not references or pointers",
+			     detail::demangle<T>().data());
 		}
 
 		template <typename T>
@@ -787,7 +903,7 @@ namespace sol {
 				}
 
 				void operator()() const {
-					if (luaL_newmetatable(L, key) == 1) {
+					if (detail::new_metatable(L, key) == 1) {
 						on_new_table(stack_reference(L, -1));
 					}
 					lua_setmetatable(L, -2);
@@ -1279,12 +1395,32 @@ namespace sol {
 		}
 
 		namespace stack_detail {
+			// table, function and object arguments taken by value, const& or && read their
+			// value straight from the argument's stack slot instead of making a registry reference
+			template <typename T, typename Tu = meta::unqualified_t<T>>
+			inline constexpr bool is_borrowed_argument_v = SOL_IS_ON(SOL_BORROWED_ARGUMENTS)
+			     && !(std::is_lvalue_reference_v<T> && !std::is_const_v<std::remove_reference_t<T>>) && is_lua_reference_v<Tu> && !is_global_table_v<Tu>
+			     && !meta::meta_detail::is_adl_sol_lua_get_v<Tu> && std::is_base_of_v<basic_reference<false>, Tu>
+			     && std::is_constructible_v<Tu, lua_State*, detail::borrowed_index>;
+
 			template <typename T, typename Handler>
 			decltype(auto) check_get_arg(lua_State* L_, int index_, Handler&& handler_, record& tracking_) {
 				if constexpr (meta::meta_detail::is_adl_sol_lua_check_access_v<T>) {
 					sol_lua_check_access(types<meta::unqualified_t<T>>(), L_, index_, tracking_);
 				}
-				return check_get<T>(L_, index_, std::forward<Handler>(handler_), tracking_);
+				if constexpr (is_borrowed_argument_v<T>) {
+					using Tu = meta::unqualified_t<T>;
+					bool success = lua_isnoneornil(L_, index_) == 0 && stack::check<Tu>(L_, index_, &no_panic);
+					if (!success) {
+						handler_(L_, index_, type::poly, type_of(L_, index_), "");
+						return optional<Tu>(nullopt);
+					}
+					tracking_.use(1);
+					return optional<Tu>(in_place, L_, detail::borrowed_index(index_));
+				}
+				else {
+					return check_get<T>(L_, index_, std::forward<Handler>(handler_), tracking_);
+				}
 			}
 
 			template <typename T>
@@ -1292,7 +1428,13 @@ namespace sol {
 				if constexpr (meta::meta_detail::is_adl_sol_lua_check_access_v<T>) {
 					sol_lua_check_access(types<meta::unqualified_t<T>>(), L_, index_, tracking_);
 				}
-				return unchecked_get<T>(L_, index_, tracking_);
+				if constexpr (is_borrowed_argument_v<T>) {
+					tracking_.use(1);
+					return meta::unqualified_t<T>(L_, detail::borrowed_index(index_));
+				}
+				else {
+					return unchecked_get<T>(L_, index_, tracking_);
+				}
 			}
 		} // namespace stack_detail
 
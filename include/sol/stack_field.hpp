@@ -39,9 +39,7 @@ namespace sol { namespace stack {
 		inline constexpr bool is_get_direct_v = (is_get_direct_tableless_v<T, global, raw>) // cf-hack
 			|| (!global && !raw && (meta::is_c_str_or_string_v<T> || meta::is_string_of_v<T, char>)) // cf-hack
 			|| (!global && raw && (std::is_integral_v<T> && !std::is_same_v<T, bool>))
-#if SOL_LUA_VERSION_I_ >= 503
 			|| (!global && !raw && (std::is_integral_v<T> && !std::is_same_v<T, bool>))
-#endif // integer keys 5.3 or better
 #if SOL_LUA_VERSION_I_ >= 502
 			|| (!global && raw && std::is_pointer_v<T> && std::is_void_v<std::remove_pointer_t<T>>)
 #endif // void pointer keys 5.2 or better
@@ -54,9 +52,7 @@ namespace sol { namespace stack {
 		inline constexpr bool is_set_direct_v = (is_set_direct_tableless_v<T, global, raw>) // cf-hack
 			|| (!global && !raw && (meta::is_c_str_or_string_v<T> || meta::is_string_of_v<T, char>)) // cf-hack
 			|| (!global && raw && (std::is_integral_v<T> && !std::is_same_v<T, bool>))     // cf-hack
-#if SOL_LUA_VERSION_I_ >= 503
 			|| (!global && !raw && (std::is_integral_v<T> && !std::is_same_v<T, bool>))
-#endif // integer keys 5.3 or better
 #if SOL_LUA_VERSION_I_ >= 502
 			|| (!global && raw && (std::is_pointer_v<T> && std::is_void_v<std::remove_pointer_t<T>>))
 #endif // void pointer keys 5.2 or better
@@ -120,11 +116,10 @@ namespace sol { namespace stack {
 					const auto& real_key = to_string(key);
 					lua_getfield(L, tableindex, &real_key[0]);
 				}
-#if SOL_LUA_VERSION_I_ >= 503
 				else if constexpr (std::is_integral_v<T> && !std::is_same_v<bool, T>) {
+					// before 5.3 this is the compatibility layer's, which goes raw on tables without a metatable
 					lua_geti(L, tableindex, static_cast<lua_Integer>(key));
 				}
-#endif // Lua 5.3.x+
 				else {
 					push(L, std::forward<Key>(key));
 					lua_gettable(L, tableindex);
@@ -223,12 +218,10 @@ namespace sol { namespace stack {
 						lua_setfield(L, tableindex, &key[0]);
 					}
 				}
-#if SOL_LUA_VERSION_I_ >= 503
 				else if constexpr (std::is_integral_v<T> && !std::is_same_v<bool, T>) {
 					push(L, std::forward<Value>(value));
 					lua_seti(L, tableindex, static_cast<lua_Integer>(key));
 				}
-#endif // Lua 5.3.x
 				else {
 					push(L, std::forward<Key>(key));
 					push(L, std::forward<Value>(value));
@@ -398,7 +398,12 @@ namespace sol { namespace stack {
 				lua_pop(L, lua_size<V>::value);
 			}
 #else
-			// Zzzz slower but necessary thanks to the lower version API and missing functions qq
+			// no lua_geti before 5.3: when nothing can intercept the read,
+			// lua_rawgeti is exact and skips the compatibility shim
+			const bool raw = lua_getmetatable(L, index) == 0;
+			if (!raw) {
+				lua_pop(L, 1);
+			}
 			for (lua_Integer i = 0;; i += lua_size<V>::value, lua_pop(L, lua_size<V>::value)) {
 				if (idx >= cont.max_size()) {
 					// see above comment
@@ -409,8 +414,12 @@ namespace sol { namespace stack {
 #endif // make sure stack doesn't overflow
 				bool isnil = false;
 				for (int vi = 0; vi < lua_size<V>::value; ++vi) {
-					lua_pushinteger(L, i);
-					lua_gettable(L, index);
+					if (raw) {
+						lua_rawgeti(L, index, static_cast<int>(i + vi));
+					}
+					else {
+						lua_geti(L, index, i + vi);
+					}
 					type vt = type_of(L, -1);
 					isnil = vt == type::lua_nil;
 					if (isnil) {
@@ -518,15 +527,23 @@ namespace sol { namespace stack {
 				++idx;
 			}
 #else
-			// Zzzz slower but necessary thanks to the lower version API and missing functions qq
+			// see the vector getter above
+			const bool raw = lua_getmetatable(L, index) == 0;
+			if (!raw) {
+				lua_pop(L, 1);
+			}
 			for (lua_Integer i = 0;; i += lua_size<V>::value, lua_pop(L, lua_size<V>::value)) {
 				if (idx >= cont.max_size()) {
 					goto done;
 				}
 				bool isnil = false;
 				for (int vi = 0; vi < lua_size<V>::value; ++vi) {
-					lua_pushinteger(L, i);
-					lua_gettable(L, index);
+					if (raw) {
+						lua_rawgeti(L, index, static_cast<int>(i + vi));
+					}
+					else {
+						lua_geti(L, index, i + vi);
+					}
 					type t = type_of(L, -1);
 					isnil = t == type::lua_nil;
 					if (isnil) {
@@ -703,6 +720,18 @@ namespace sol { namespace stack {
 		}
 	};
 
+#if SOL_IS_ON(SOL_STD_SPAN)
+	template <>
+	struct unqualified_getter<std::span<const std::byte>> {
+		static std::span<const std::byte> get(lua_State* L, int index, record& tracking) {
+			tracking.use(1);
+			size_t sz;
+			const char* str = lua_tolstring(L, index, &sz);
+			return std::span<const std::byte>(reinterpret_cast<const std::byte*>(str), sz);
+		}
+	};
+#endif // views straight into the Lua string's bytes
+
 	template <typename Traits, typename Al>
 	struct unqualified_getter<std::basic_string<wchar_t, Traits, Al>> {
 		using S = std::basic_string<wchar_t, Traits, Al>;
@@ -915,7 +944,13 @@ namespace sol { namespace stack {
 		}
 
 		static T& get(lua_State* L, int index, record& tracking) {
-			return *get_no_lua_nil(L, index, tracking);
+			T* obj = get_no_lua_nil(L, index, tracking);
+			if constexpr (is_disposable_v<T>) {
+				if (obj == nullptr) {
+					detail::disposed_error<T>(L);
+				}
+			}
+			return *obj;
 		}
 	};
 
@@ -936,7 +971,13 @@ namespace sol { namespace stack {
 	struct unqualified_getter<non_null<T*>> {
 		static T* get(lua_State* L, int index, record& tracking) {
 			unqualified_getter<detail::as_value_tag<T>> g{};
-			return g.get_no_lua_nil(L, index, tracking);
+			T* obj = g.get_no_lua_nil(L, index, tracking);
+			if constexpr (is_disposable_v<T>) {
+				if (obj == nullptr) {
+					detail::disposed_error<T>(L);
+				}
+			}
+			return obj;
 		}
 	};
 
@@ -167,6 +167,7 @@ namespace sol { namespace stack {
 			f();
 			std::allocator<T> alloc {};
 			std::allocator_traits<std::allocator<T>>::construct(alloc, obj, std::forward<Args>(args)...);
+			detail::charge_external_memory(L, *obj);
 			return 1;
 		}
 
@@ -263,7 +264,8 @@ namespace sol { namespace stack {
 				detail::unique_destructor* fx = nullptr;
 				detail::unique_tag* id = nullptr;
 				actual* typed_memory = detail::usertype_unique_allocate<element, actual>(L, pointer_to_memory, fx, id);
-				if (luaL_newmetatable(L, &usertype_traits<d::u<std::remove_cv_t<element>>>::metatable()[0]) == 1) {
+				detail::count_usertype_created<element>();
+				if (detail::new_metatable(L, &usertype_traits<d::u<std::remove_cv_t<element>>>::metatable()[0]) == 1) {
 					detail::lua_reg_table registration_table {};
 					int index = 0;
 					detail::indexed_insert insert_callable(registration_table, index);
@@ -276,6 +278,11 @@ namespace sol { namespace stack {
 				*id = &detail::inheritance<element>::template type_unique_cast<actual>;
 				detail::default_construct::construct(typed_memory, std::forward<Args>(args)...);
 				*pointer_to_memory = detail::unique_get<T>(L, *typed_memory);
+				if constexpr (has_external_size_v<element>) {
+					if (*pointer_to_memory != nullptr) {
+						detail::charge_external_memory(L, **pointer_to_memory);
+					}
+				}
 				return 1;
 			}
 		};
@@ -430,29 +437,13 @@ namespace sol { namespace stack {
 					lua_seti(L, tableindex, static_cast<lua_Integer>(index++));
 				}
 #else
-#if SOL_IS_ON(SOL_SAFE_STACK_CHECK)
-				luaL_checkstack(L, 1, detail::not_enough_stack_space_generic);
-#endif // make sure stack doesn't overflow
-				lua_pushinteger(L, static_cast<lua_Integer>(index));
+				// the table is fresh and has no metatable, so raw sets are exact
+				// and skip the emulated lua_seti; the first value keeps the lowest index
 				int p = is_nested ? stack::push(L, as_nested_ref(i)) : stack::push(L, i);
-				if (p == 1) {
-					++index;
-					lua_settable(L, tableindex);
-				}
-				else {
-					int firstindex = tableindex + 1 + 1;
-					for (int pi = 0; pi < p; ++pi) {
-						stack::push(L, index);
-#if SOL_IS_ON(SOL_SAFE_STACK_CHECK)
-						luaL_checkstack(L, 1, detail::not_enough_stack_space_generic);
-#endif // make sure stack doesn't overflow
-						lua_pushvalue(L, firstindex);
-						lua_settable(L, tableindex);
-						++index;
-						++firstindex;
-					}
-					lua_pop(L, 1 + p);
+				for (int pi = p; pi > 0; --pi) {
+					lua_rawseti(L, tableindex, static_cast<int>(index + pi - 1));
 				}
+				index += static_cast<std::size_t>(p);
 #endif // Lua Version 5.3 and others
 			}
 			// TODO: figure out a better way to do this...?
@@ -599,6 +590,7 @@ namespace sol { namespace stack {
 			luaL_checkstack(L, 1, detail::not_enough_stack_space_generic);
 #endif // make sure stack doesn't overflow
 			lua_pushcclosure(L, cc.c_function, cc.upvalues);
+			detail::count_runtime_event(detail::runtime_counter::closures_created);
 			return 1;
 		}
 	};
@@ -940,6 +932,19 @@ namespace sol { namespace stack {
 		}
 	};
 
+#if SOL_IS_ON(SOL_STD_SPAN)
+	template <>
+	struct unqualified_pusher<std::span<const std::byte>> {
+		static int push(lua_State* L, const std::span<const std::byte>& bytes) {
+#if SOL_IS_ON(SOL_SAFE_STACK_CHECK)
+			luaL_checkstack(L, 1, detail::not_enough_stack_space_string);
+#endif // make sure stack doesn't overflow
+			lua_pushlstring(L, reinterpret_cast<const char*>(bytes.data()), bytes.size());
+			return 1;
+		}
+	};
+#endif // byte spans as strings
+
 	template <>
 	struct unqualified_pusher<meta_function> {
 		static int push(lua_State* L, meta_function m) {
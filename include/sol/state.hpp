@@ -36,11 +36,17 @@ namespace sol {
 	public:
 		state(lua_CFunction panic = default_at_panic) : unique_base(luaL_newstate()), state_view(unique_base::get()) {
 			set_default_state(unique_base::get(), panic);
+#if SOL_IS_ON(SOL_METRICS)
+			detail::track_state_metrics(unique_base::get());
+#endif
 		}
 
 		state(lua_CFunction panic, lua_Alloc alfunc, void* alpointer = nullptr)
 		: unique_base(lua_newstate(alfunc, alpointer)), state_view(unique_base::get()) {
 			set_default_state(unique_base::get(), panic);
+#if SOL_IS_ON(SOL_METRICS)
+			detail::track_state_metrics(unique_base::get());
+#endif
 		}
 
 		state(const state&) = delete;
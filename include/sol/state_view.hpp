@@ -29,6 +29,7 @@
 #include <sol/environment.hpp>
 #include <sol/load_result.hpp>
 #include <sol/state_handling.hpp>
+#include <sol/static_usertype.hpp>
 
 #include <memory>
 #include <cstddef>
@@ -341,7 +342,7 @@ namespace sol {
 
 		template <typename E>
 		protected_function_result do_file(const std::string& filename, const basic_environment<E>& env, load_mode mode = load_mode::any) {
-			load_status x = static_cast<load_status>(luaL_loadfilex(L, filename.c_str(), to_string(mode).c_str()));
+			load_status x = static_cast<load_status>(detail::load_source_file(L, filename, mode));
 			if (x != load_status::ok) {
 				return protected_function_result(L, absolute_index(L, -1), 0, 1, static_cast<call_status>(x));
 			}
@@ -351,7 +352,7 @@ namespace sol {
 		}
 
 		protected_function_result do_file(const std::string& filename, load_mode mode = load_mode::any) {
-			load_status x = static_cast<load_status>(luaL_loadfilex(L, filename.c_str(), to_string(mode).c_str()));
+			load_status x = static_cast<load_status>(detail::load_source_file(L, filename, mode));
 			if (x != load_status::ok) {
 				return protected_function_result(L, absolute_index(L, -1), 0, 1, static_cast<call_status>(x));
 			}
@@ -496,7 +497,7 @@ namespace sol {
 		template <typename E>
 		unsafe_function_result unsafe_script_file(const std::string& filename, const basic_environment<E>& env, load_mode mode = load_mode::any) {
 			int index = lua_gettop(L);
-			if (luaL_loadfilex(L, filename.c_str(), to_string(mode).c_str())) {
+			if (detail::load_source_file(L, filename, mode)) {
 				lua_error(L);
 			}
 			set_environment(env, stack_reference(L, raw_index(index + 1)));
@@ -591,7 +592,7 @@ namespace sol {
 		}
 
 		load_result load_file(const std::string& filename, load_mode mode = load_mode::any) {
-			load_status x = static_cast<load_status>(luaL_loadfilex(L, filename.c_str(), to_string(mode).c_str()));
+			load_status x = static_cast<load_status>(detail::load_source_file(L, filename, mode));
 			return load_result(L, absolute_index(L, -1), 1, 1, x);
 		}
 
@@ -636,6 +637,23 @@ namespace sol {
 			return total_memory_used(lua_state());
 		}
 
+		std::size_t external_memory_used() const {
+			return sol::external_memory_used(lua_state());
+		}
+
+		void adjust_external_memory(std::ptrdiff_t delta_bytes) {
+			sol::adjust_external_memory(lua_state(), delta_bytes);
+		}
+
+		template <typename T>
+		void update_external_memory(const T& obj) {
+			sol::update_external_memory(lua_state(), obj);
+		}
+
+		state_metrics metrics() const {
+			return collect_metrics(lua_state());
+		}
+
 		int stack_top() const {
 			return stack::top(L);
 		}
@@ -665,6 +683,7 @@ namespace sol {
 		}
 
 		void collect_garbage() {
+			detail::gc_step_timer timer(lua_state());
 			lua_gc(lua_state(), LUA_GCCOLLECT, 0);
 		}
 
@@ -676,6 +695,7 @@ namespace sol {
 			// THOUGHT: std::chrono-alikes to map "kilobyte size" here...?
 			// Make it harder to give MB or KB to a B parameter...?
 			// Probably overkill for now.
+			detail::gc_step_timer timer(lua_state());
 #if SOL_LUA_VERSION_I_ >= 504
 			// The manual implies that this function is almost always successful...
 			// is it?? It could depend on the GC mode...
@@ -785,6 +805,43 @@ namespace sol {
 			return global.new_usertype<Class>(std::forward<Args>(args)...);
 		}
 
+		// registers Class only when it is first used: scripts see a placeholder class table under name,
+		// and the first access through it, or the first push of a Class from C++, runs
+		// new_usertype<Class>(name) and then registrar on the result
+		template <typename Class, typename Registrar>
+		state_view& declare_usertype(const string_view& name, Registrar&& registrar) {
+			static_assert(std::is_invocable_v<Registrar&, usertype<Class>&>, "the registrar must be callable with a sol::usertype<Class>&");
+			std::string key(name.data(), name.size());
+			auto registration = [key, registrar = std::forward<Registrar>(registrar)](lua_State* L) mutable -> int {
+				usertype<Class> class_table = state_view(L).new_usertype<Class>(key);
+				registrar(class_table);
+				class_table.push(L);
+				return luaL_ref(L, LUA_REGISTRYINDEX);
+			};
+			detail::push_usertype_declaration(L,
+			     key,
+			     std::move(registration),
+			     { &usertype_traits<Class>::metatable()[0],
+			          &usertype_traits<const Class>::metatable()[0],
+			          &usertype_traits<d::u<Class>>::metatable()[0],
+			          &usertype_traits<Class*>::metatable()[0],
+			          &usertype_traits<Class const*>::metatable()[0] });
+			lua_setglobal(L, key.c_str());
+			return *this;
+		}
+
+		// registers Class from the members listed in sol::static_usertype<Class>: only the metatables
+		// and the class table are created, member lookups go through tables built at compile time
+		template <typename Class>
+		table new_static_usertype(const string_view& name) {
+			static_assert(is_static_usertype_v<Class>, "new_static_usertype<Class> needs sol::static_usertype<Class> to provide a static constexpr members list");
+			detail::push_static_usertype<Class>(L);
+			table class_table(L, -1);
+			std::string key(name.data(), name.size());
+			lua_setglobal(L, key.c_str());
+			return class_table;
+		}
+
 		template <bool read_only = true, typename... Args>
 		state_view& new_enum(const string_view& name, Args&&... args) {
 			global.new_enum<read_only>(name, std::forward<Args>(args)...);
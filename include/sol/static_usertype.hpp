@@ -0,0 +1,455 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_STATIC_USERTYPE_HPP
+#define SOL_STATIC_USERTYPE_HPP
+
+#include <sol/stack.hpp>
+#include <sol/call.hpp>
+#include <sol/usertype_core.hpp>
+#include <sol/usertype_traits.hpp>
+#include <sol/raii.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace sol {
+
+	// one entry of a static usertype: a name and what it binds to, both known at compile time
+	template <typename F>
+	struct static_member {
+		string_view name;
+		F value;
+	};
+
+	template <typename F>
+	static_member(string_view, F) -> static_member<F>;
+
+	template <typename... F>
+	constexpr std::tuple<static_member<F>...> static_members(static_member<F>... members) {
+		return std::tuple<static_member<F>...>(members...);
+	}
+
+	// specialize with `static constexpr auto members = sol::static_members(...);`
+	// to register T with new_static_usertype
+	template <typename T>
+	struct static_usertype { };
+
+	template <typename T, typename = void>
+	struct is_static_usertype : std::false_type { };
+
+	template <typename T>
+	struct is_static_usertype<T, std::void_t<decltype(static_usertype<T>::members)>> : std::true_type { };
+
+	template <typename T>
+	inline constexpr bool is_static_usertype_v = is_static_usertype<T>::value;
+
+	namespace detail {
+		constexpr std::uint64_t static_key_hash(string_view key) noexcept {
+			std::uint64_t hash = 14695981039346656037ull;
+			for (char c : key) {
+				hash ^= static_cast<unsigned char>(c);
+				hash *= 1099511628211ull;
+			}
+			// fnv-1a alone leaves the high half weakly mixed for names that differ only near the end
+			hash ^= hash >> 33;
+			hash *= 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 33;
+			return hash;
+		}
+
+		constexpr std::size_t static_key_slot(std::uint64_t hash, std::uint32_t seed, std::size_t bits) noexcept {
+			std::uint32_t x = static_cast<std::uint32_t>(hash) ^ (seed * 0x85EBCA6Bu);
+			x ^= x >> 16;
+			x *= 0x7FEB352Du;
+			x ^= x >> 15;
+			return static_cast<std::size_t>(x >> (32 - bits));
+		}
+
+		constexpr std::size_t static_key_capacity(std::size_t count) noexcept {
+			std::size_t capacity = 2;
+			while (capacity < count) {
+				capacity *= 2;
+			}
+			return capacity;
+		}
+
+		constexpr std::size_t static_key_bits(std::size_t capacity) noexcept {
+			std::size_t bits = 0;
+			while ((std::size_t(1) << bits) < capacity) {
+				++bits;
+			}
+			return bits;
+		}
+
+		// a minimal perfect hash over N names: the high half of a name's hash picks a bucket, and
+		// the bucket's seed scatters the low half into slots so that no two names share one
+		template <std::size_t N>
+		struct static_key_table {
+			static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+			// a seed with this bit set names the slot of a bucket's only name directly
+			static constexpr std::uint32_t direct_seed = 1u << 31;
+			static constexpr std::size_t capacity = static_key_capacity(N);
+			static constexpr std::size_t bits = static_key_bits(capacity);
+
+			std::array<string_view, N> names {};
+			std::array<std::uint32_t, capacity> seeds {};
+			// member index + 1, 0 for an empty slot
+			std::array<std::uint32_t, capacity> slots {};
+			bool duplicate_names = false;
+			bool complete = false;
+
+			static constexpr std::size_t bucket(std::uint64_t hash) noexcept {
+				return static_cast<std::size_t>(hash >> 32) & (capacity - 1);
+			}
+
+			constexpr std::size_t find(string_view key) const noexcept {
+				std::uint64_t hash = static_key_hash(key);
+				std::uint32_t seed = seeds[bucket(hash)];
+				std::uint32_t slot = slots[(seed & direct_seed) != 0 ? (seed & ~direct_seed) : static_key_slot(hash, seed, bits)];
+				if (slot == 0 || names[slot - 1] != key) {
+					return npos;
+				}
+				return slot - 1;
+			}
+		};
+
+		// hash and displace: fill the fullest buckets first, each with the first seed that sends
+		// all of its names to free slots, then hand the leftover slots to single-name buckets
+		template <std::size_t N>
+		constexpr static_key_table<N> make_static_key_table(const std::array<string_view, N>& names) noexcept {
+			using table_t = static_key_table<N>;
+			constexpr std::uint32_t seed_limit = 1u << 20;
+			table_t table {};
+			table.names = names;
+			std::array<std::uint64_t, N> hashes {};
+			std::array<std::size_t, table_t::capacity + 1> bucket_starts {};
+			std::size_t largest_bucket = 0;
+			for (std::size_t i = 0; i < N; ++i) {
+				hashes[i] = static_key_hash(names[i]);
+				++bucket_starts[table_t::bucket(hashes[i]) + 1];
+			}
+			for (std::size_t b = 0; b < table_t::capacity; ++b) {
+				largest_bucket = bucket_starts[b + 1] > largest_bucket ? bucket_starts[b + 1] : largest_bucket;
+				bucket_starts[b + 1] += bucket_starts[b];
+			}
+			// the names sorted by bucket, so a bucket only ever looks at its own names
+			std::array<std::size_t, N> by_bucket {};
+			std::array<std::size_t, table_t::capacity> filled {};
+			for (std::size_t i = 0; i < N; ++i) {
+				std::size_t b = table_t::bucket(hashes[i]);
+				by_bucket[bucket_starts[b] + filled[b]++] = i;
+			}
+			// equal names land in the same bucket, and no seed can ever separate them
+			for (std::size_t b = 0; b < table_t::capacity; ++b) {
+				for (std::size_t x = bucket_starts[b]; x < bucket_starts[b + 1]; ++x) {
+					for (std::size_t y = x + 1; y < bucket_starts[b + 1]; ++y) {
+						if (names[by_bucket[x]] == names[by_bucket[y]]) {
+							table.duplicate_names = true;
+							return table;
+						}
+					}
+				}
+			}
+			for (std::size_t size = largest_bucket; size > 1; --size) {
+				for (std::size_t b = 0; b < table_t::capacity; ++b) {
+					const std::size_t first = bucket_starts[b];
+					const std::size_t last = bucket_starts[b + 1];
+					if (last - first != size) {
+						continue;
+					}
+					std::uint32_t seed = 0;
+					for (; seed < seed_limit; ++seed) {
+						std::size_t placed = first;
+						for (; placed < last; ++placed) {
+							std::size_t i = by_bucket[placed];
+							std::size_t slot = static_key_slot(hashes[i], seed, table_t::bits);
+							if (table.slots[slot] != 0) {
+								break;
+							}
+							table.slots[slot] = static_cast<std::uint32_t>(i + 1);
+						}
+						if (placed == last) {
+							break;
+						}
+						for (std::size_t undo = first; undo < placed; ++undo) {
+							table.slots[static_key_slot(hashes[by_bucket[undo]], seed, table_t::bits)] = 0;
+						}
+					}
+					if (seed == seed_limit) {
+						return table;
+					}
+					table.seeds[b] = seed;
+				}
+			}
+			std::size_t free_slot = 0;
+			for (std::size_t b = 0; b < table_t::capacity; ++b) {
+				if (bucket_starts[b + 1] - bucket_starts[b] != 1) {
+					continue;
+				}
+				while (table.slots[free_slot] != 0) {
+					++free_slot;
+				}
+				table.slots[free_slot] = static_cast<std::uint32_t>(by_bucket[bucket_starts[b]] + 1);
+				table.seeds[b] = table_t::direct_seed | static_cast<std::uint32_t>(free_slot);
+			}
+			table.complete = true;
+			return table;
+		}
+
+		template <typename Members, std::size_t... I>
+		constexpr std::array<string_view, sizeof...(I)> static_member_names(const Members& members, std::index_sequence<I...>) noexcept {
+			return { { std::get<I>(members).name... } };
+		}
+	} // namespace detail
+
+	// the compile-time side of a static usertype: name lookups and typed access to its members,
+	// without touching Lua or the heap
+	template <typename T>
+	class static_member_table {
+	private:
+		static_assert(is_static_usertype_v<T>, "sol::static_member_table<T> needs sol::static_usertype<T> to provide a static constexpr members list");
+
+		static constexpr const auto& members = static_usertype<T>::members;
+		static constexpr std::size_t count = std::tuple_size_v<meta::unqualified_t<decltype(static_usertype<T>::members)>>;
+		static constexpr std::array<string_view, count> names = detail::static_member_names(members, std::make_index_sequence<count>());
+
+		static constexpr detail::static_key_table<count> keys = detail::make_static_key_table(names);
+
+		static_assert(!keys.duplicate_names, "the members of a sol::static_usertype<T> must have unique names");
+		static_assert(keys.complete, "sol2 could not build a perfect hash over these member names: please file a bug with the names used");
+
+		template <typename Fx, std::size_t... I>
+		static constexpr bool visit_at(std::size_t index, Fx& fx, std::index_sequence<I...>) {
+			return ((index == I ? (fx(std::get<I>(members).value), true) : false) || ...);
+		}
+
+	public:
+		static constexpr std::size_t npos = detail::static_key_table<count>::npos;
+
+		static constexpr std::size_t size() noexcept {
+			return count;
+		}
+
+		static constexpr std::size_t find(string_view name) noexcept {
+			return keys.find(name);
+		}
+
+		static constexpr string_view name(std::size_t index) noexcept {
+			return names[index];
+		}
+
+		// calls fx with the member bound under name; false if there is none
+		template <typename Fx>
+		static constexpr bool visit(string_view name, Fx&& fx) {
+			return visit_at(find(name), fx, std::make_index_sequence<count>());
+		}
+	};
+
+	namespace detail {
+		template <typename T, std::size_t I>
+		constexpr const auto& static_member_value() noexcept {
+			return std::get<I>(static_usertype<T>::members).value;
+		}
+
+		template <typename T, std::size_t I>
+		using static_member_value_t = meta::unqualified_t<decltype(static_member_value<T, I>())>;
+
+		// sol2's call wrappers take what they call by mutable reference: hand them a copy,
+		// which for member pointers, function pointers and constructor lists costs nothing
+		template <typename T, std::size_t I, bool is_index, bool is_variable>
+		int call_static_member(lua_State* L) {
+			static_member_value_t<T, I> value = static_member_value<T, I>();
+			return call_detail::call_wrapped<T, is_index, is_variable>(L, value);
+		}
+
+		template <typename T, std::size_t I>
+		inline constexpr bool is_static_member_variable_v = call_detail::is_var_bind<static_member_value_t<T, I>>::value;
+
+		template <typename T, std::size_t I>
+		int static_member_call(lua_State* L) {
+			return call_static_member<T, I, false, false>(L);
+		}
+
+		template <typename T, std::size_t I>
+		int static_member_index(lua_State* L) {
+			if constexpr (is_static_member_variable_v<T, I>) {
+				return call_static_member<T, I, true, true>(L);
+			}
+			else {
+				lua_CFunction call = &static_trampoline<&static_member_call<T, I>>;
+				lua_pushcfunction(L, call);
+				return 1;
+			}
+		}
+
+		template <typename T, std::size_t I>
+		int static_member_new_index(lua_State* L) {
+			if constexpr (is_static_member_variable_v<T, I>) {
+				return call_static_member<T, I, false, true>(L);
+			}
+			else {
+				return luaL_error(L, "sol: cannot assign to '%s': it is a function of a static usertype", lua_tostring(L, 2));
+			}
+		}
+
+		template <typename T, std::size_t... I>
+		constexpr std::array<lua_CFunction, sizeof...(I)> static_index_functions(std::index_sequence<I...>) noexcept {
+			return { { &static_member_index<T, I>... } };
+		}
+
+		template <typename T, std::size_t... I>
+		constexpr std::array<bool, sizeof...(I)> static_variable_flags(std::index_sequence<I...>) noexcept {
+			return { { is_static_member_variable_v<T, I>... } };
+		}
+
+		template <typename T, std::size_t... I>
+		constexpr std::array<lua_CFunction, sizeof...(I)> static_new_index_functions(std::index_sequence<I...>) noexcept {
+			return { { &static_member_new_index<T, I>... } };
+		}
+
+		template <typename T>
+		std::size_t static_member_key(lua_State* L) {
+			if (lua_type(L, 2) != LUA_TSTRING) {
+				return static_member_table<T>::npos;
+			}
+			std::size_t length = 0;
+			const char* key = lua_tolstring(L, 2, &length);
+			return static_member_table<T>::find(string_view(key, length));
+		}
+
+		// __index of every object metatable: members first, then whatever Lua code put in the class table
+		template <typename T>
+		int static_usertype_index(lua_State* L) {
+			static constexpr auto functions = static_index_functions<T>(std::make_index_sequence<static_member_table<T>::size()>());
+			std::size_t index = static_member_key<T>(L);
+			if (index != static_member_table<T>::npos) {
+				return functions[index](L);
+			}
+			lua_settop(L, 2);
+			lua_rawget(L, lua_upvalueindex(1));
+			return 1;
+		}
+
+		template <typename T>
+		int static_usertype_new_index(lua_State* L) {
+			static constexpr auto functions = static_new_index_functions<T>(std::make_index_sequence<static_member_table<T>::size()>());
+			std::size_t index = static_member_key<T>(L);
+			if (index != static_member_table<T>::npos) {
+				return functions[index](L);
+			}
+			if (lua_type(L, 2) != LUA_TSTRING) {
+				return luaL_error(L, "sol: cannot set a %s key on %s", luaL_typename(L, 2), detail::demangle<T>().c_str());
+			}
+			return luaL_error(L, "sol: cannot set '%s': %s has no such member", lua_tostring(L, 2), detail::demangle<T>().c_str());
+		}
+
+		template <typename T>
+		int static_usertype_default_new(lua_State* L) {
+			constructors<T()> default_constructor;
+			return call_detail::call_wrapped<T, false, false>(L, default_constructor);
+		}
+
+		// __index of the class table: the functions, and a default "new" when there is no other
+		template <typename T>
+		int static_usertype_class_index(lua_State* L) {
+			std::size_t index = static_member_key<T>(L);
+			if (index != static_member_table<T>::npos) {
+				static constexpr auto functions = static_index_functions<T>(std::make_index_sequence<static_member_table<T>::size()>());
+				static constexpr auto variables = static_variable_flags<T>(std::make_index_sequence<static_member_table<T>::size()>());
+				if (variables[index]) {
+					lua_pushnil(L);
+					return 1;
+				}
+				return functions[index](L);
+			}
+			if constexpr (std::is_default_constructible_v<T>) {
+				if (lua_type(L, 2) == LUA_TSTRING && string_view(lua_tostring(L, 2)) == "new") {
+					lua_CFunction default_new = &static_trampoline<&static_usertype_default_new<T>>;
+					lua_pushcfunction(L, default_new);
+					return 1;
+				}
+			}
+			lua_pushnil(L);
+			return 1;
+		}
+
+		template <typename T, typename X>
+		void set_static_usertype_metatable(lua_State* L, int class_table_index) {
+			luaL_newmetatable(L, &usertype_traits<X>::metatable()[0]);
+			stack_reference metatable(L, -1);
+			if constexpr (std::is_same_v<X, d::u<T>>) {
+				stack::stack_detail::set_undefined_methods_on<T*>(metatable);
+				lua_pushcfunction(L, &detail::unique_destroy<T>);
+				lua_setfield(L, -2, to_string(meta_function::garbage_collect).c_str());
+			}
+			else {
+				stack::stack_detail::set_undefined_methods_on<std::conditional_t<std::is_pointer_v<X>, T*, T>>(metatable);
+			}
+			lua_pushlightuserdata(L, reinterpret_cast<void*>(&detail::inheritance<T>::type_check));
+			lua_setfield(L, -2, &detail::base_class_check_key()[0]);
+			lua_pushlightuserdata(L, reinterpret_cast<void*>(&detail::inheritance<T>::type_cast));
+			lua_setfield(L, -2, &detail::base_class_cast_key()[0]);
+			lua_pushvalue(L, class_table_index);
+			lua_CFunction index = &static_trampoline<&static_usertype_index<T>>;
+			lua_pushcclosure(L, index, 1);
+			lua_setfield(L, -2, to_string(meta_function::index).c_str());
+			lua_CFunction new_index = &static_trampoline<&static_usertype_new_index<T>>;
+			lua_pushcfunction(L, new_index);
+			lua_setfield(L, -2, to_string(meta_function::new_index).c_str());
+			lua_pop(L, 1);
+		}
+
+		// creates the metatables sol2 looks T up by and leaves the class table on the stack:
+		// the members themselves live in static tables, so nothing per member is built here
+		template <typename T>
+		int push_static_usertype(lua_State* L) {
+			lua_createtable(L, 0, 0);
+			int class_table_index = lua_gettop(L);
+			lua_createtable(L, 0, 1);
+			lua_CFunction class_index = &static_trampoline<&static_usertype_class_index<T>>;
+			lua_pushcfunction(L, class_index);
+			lua_setfield(L, -2, to_string(meta_function::index).c_str());
+			lua_setmetatable(L, class_table_index);
+
+			// constructors compare their first argument with this entry to tell T:new() from T.new()
+			lua_pushvalue(L, class_table_index);
+			lua_setfield(L, LUA_REGISTRYINDEX, &usertype_traits<T>::user_metatable()[0]);
+
+			set_static_usertype_metatable<T, T>(L, class_table_index);
+			set_static_usertype_metatable<T, const T>(L, class_table_index);
+			set_static_usertype_metatable<T, T*>(L, class_table_index);
+			set_static_usertype_metatable<T, T const*>(L, class_table_index);
+			set_static_usertype_metatable<T, d::u<T>>(L, class_table_index);
+			return 1;
+		}
+	} // namespace detail
+
+} // namespace sol
+
+#endif // SOL_STATIC_USERTYPE_HPP
@@ -174,6 +174,7 @@ namespace sol {
 
 		static basic_thread create(lua_State* L) {
 			lua_newthread(L);
+			detail::count_runtime_event(detail::runtime_counter::threads_created);
 			basic_thread result(L);
 			if (!is_stack_based<base_t>::value) {
 				lua_pop(L, 1);
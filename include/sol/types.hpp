@@ -44,6 +44,10 @@
 #if SOL_IS_ON(SOL_STD_VARIANT)
 #include <variant>
 #endif // variant shenanigans (thanks, Mac OSX)
+#if SOL_IS_ON(SOL_STD_SPAN)
+#include <cstddef>
+#include <span>
+#endif // byte spans as strings
 
 namespace sol {
 	namespace d {
@@ -105,6 +109,14 @@ namespace sol {
 	struct metatable_key_t { };
 	inline constexpr metatable_key_t metatable_key {};
 
+	// usertype values: `ut["set"] = sol::bulk_set` gives objects an obj:set{ x = 1, y = 2 } method,
+	// and `ut["get"] = sol::bulk_get` an obj:get("x", "y") method
+	struct bulk_set_t { };
+	inline constexpr bulk_set_t bulk_set {};
+
+	struct bulk_get_t { };
+	inline constexpr bulk_get_t bulk_get {};
+
 	struct global_tag_t {
 	} inline constexpr global_tag {};
 
@@ -796,12 +808,13 @@ namespace sol {
 		gc_names,
 		static_index,
 		static_new_index,
+		close,
 	};
 
 	typedef meta_function meta_method;
 
-	inline const std::array<std::string, 37>& meta_function_names() {
-		static const std::array<std::string, 37> names = { { "new",
+	inline const std::array<std::string, 38>& meta_function_names() {
+		static const std::array<std::string, 38> names = { { "new",
 			"__index",
 			"__newindex",
 			"__mode",
@@ -840,7 +853,9 @@ namespace sol {
 			"__sol.storage",
 			"__sol.gc_names",
 			"__sol.static_index",
-			"__sol.static_new_index" } };
+			"__sol.static_new_index",
+
+			"__close" } };
 		return names;
 	}
 
@@ -901,6 +916,11 @@ namespace sol {
 	            T> && !std::is_same_v<state, T> && !meta::is_initializer_list_v<T> && !meta::is_string_like_v<T> && !meta::is_string_literal_array_v<T> && !is_transparent_argument_v<T> && !is_lua_reference_v<T> && (meta::has_begin_end_v<T> || std::is_array_v<T>)> {
 	};
 
+#if SOL_IS_ON(SOL_STD_SPAN)
+	template <>
+	struct is_container<std::span<const std::byte>> : std::false_type { };
+#endif // byte spans are strings, not containers
+
 	template <typename T>
 	constexpr inline bool is_container_v = is_container<T>::value;
 
@@ -927,6 +947,11 @@ namespace sol {
 		template <typename C, typename T>
 		struct lua_type_of<basic_string_view<C, T>> : std::integral_constant<type, type::string> { };
 
+#if SOL_IS_ON(SOL_STD_SPAN)
+		template <>
+		struct lua_type_of<std::span<const std::byte>> : std::integral_constant<type, type::string> { };
+#endif
+
 		template <std::size_t N>
 		struct lua_type_of<char[N]> : std::integral_constant<type, type::string> { };
 
@@ -1366,6 +1391,14 @@ namespace sol {
 	                     meta::unqualified_t<T>> || (!std::is_same_v<meta::unqualified_t<T>, state> && !std::is_same_v<meta::unqualified_t<T>, state_view>))> {
 	};
 
+	// specialize to std::true_type to give a usertype a `dispose` method and a
+	// Lua 5.4 `__close` metamethod that destroy the C++ object ahead of the collector
+	template <typename T>
+	struct is_disposable : std::false_type { };
+
+	template <typename T>
+	inline constexpr bool is_disposable_v = is_disposable<T>::value;
+
 	template <typename T>
 	inline type type_of() {
 		return lua_type_of<meta::unqualified_t<T>>::value;
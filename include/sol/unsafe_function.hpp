@@ -116,6 +116,12 @@ namespace sol {
 			stack::check<basic_function>(lua_state(), -1, handler);
 #endif // Safety
 		}
+		basic_function(lua_State* L, detail::borrowed_index index) : base_t(L, index) {
+#if SOL_IS_ON(SOL_SAFE_REFERENCES)
+			constructor_handler handler {};
+			stack::check<basic_function>(L, index.index, handler);
+#endif // Safety
+		}
 
 		template <typename Fx>
 		int dump(lua_Writer writer, void* userdata, bool strip, Fx&& on_error) const {
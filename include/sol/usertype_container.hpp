@@ -276,6 +276,18 @@ namespace sol {
 			static constexpr bool value = std::is_same_v<decltype(test<T>(0)), meta::sfinae_yes_t>;
 		};
 
+		template <typename T>
+		struct has_traits_each_test {
+		private:
+			template <typename C>
+			static meta::sfinae_yes_t test(decltype(&C::each));
+			template <typename C>
+			static meta::sfinae_no_t test(...);
+
+		public:
+			static constexpr bool value = std::is_same_v<decltype(test<T>(0)), meta::sfinae_yes_t>;
+		};
+
 		template <typename T>
 		struct has_traits_size_test {
 		private:
@@ -354,6 +366,9 @@ namespace sol {
 		template <typename T>
 		using has_traits_erase = meta::boolean<has_traits_erase_test<T>::value>;
 
+		template <typename T>
+		using has_traits_each = meta::boolean<has_traits_each_test<T>::value>;
+
 		template <typename T>
 		struct is_forced_container : is_container<T> { };
 
@@ -393,6 +408,89 @@ namespace sol {
 			return t.second;
 		}
 
+		// Calls the method named `method` on every element of [first, last), passing the
+		// `argc` values that start at `args_index`. The method is looked up once, and a single
+		// pointer userdata is re-aimed at each element instead of pushing a new one per element.
+		// On failure the status is returned with "element N ('method'): message" on top of the stack.
+		template <typename It, typename Sentinel, typename Projection>
+		int each_call_range(lua_State* L_, It first, Sentinel last, Projection&& proj, const char* method, int args_index, int argc, std::size_t& visited) {
+			using projected_t = decltype(detail::deref(proj(*first)));
+			using element_t = meta::unqualified_t<projected_t>;
+			visited = 0;
+			if constexpr (!std::is_class_v<element_t> || is_lua_reference_v<element_t>) {
+				(void)last;
+				(void)method;
+				(void)args_index;
+				(void)argc;
+				lua_pushfstring(L_, "sol: cannot call 'each' on elements of type '%s': they are not usertypes", detail::demangle<element_t>().c_str());
+				return LUA_ERRRUN;
+			}
+			else {
+				if (first == last) {
+					return LUA_OK;
+				}
+				int top = lua_gettop(L_);
+				const std::size_t start = static_cast<std::size_t>(SOL_CONTAINER_START_INDEX_I_);
+				auto element_pointer = [&proj](auto&& element) -> element_t* {
+					if constexpr (meta::is_pointer_like_v<meta::unqualified_t<decltype(proj(element))>>) {
+						if (proj(element) == nullptr) {
+							return nullptr;
+						}
+					}
+					return const_cast<element_t*>(std::addressof(detail::deref(proj(element))));
+				};
+				element_t* target = element_pointer(*first);
+				if (target == nullptr) {
+					lua_pushfstring(L_, "sol: each: element %d ('%s') is nil", static_cast<int>(start), method);
+					return LUA_ERRRUN;
+				}
+				stack::push<element_t*>(L_, target);
+				int self_index = lua_gettop(L_);
+				element_t** slot = static_cast<element_t**>(detail::align_usertype_pointer(lua_touserdata(L_, self_index)));
+				lua_getfield(L_, self_index, method);
+				int fx_index = lua_gettop(L_);
+				if (type_of(L_, fx_index) == type::lua_nil) {
+					lua_settop(L_, top);
+					lua_pushfstring(L_, "sol: each: '%s' is not a member of '%s'", method, detail::demangle<element_t>().c_str());
+					return LUA_ERRRUN;
+				}
+				int status = LUA_OK;
+				for (; first != last; ++first, ++visited) {
+					target = element_pointer(*first);
+					if (target == nullptr) {
+						lua_pushfstring(L_, "sol: each: element %d ('%s') is nil", static_cast<int>(visited + start), method);
+						status = LUA_ERRRUN;
+						break;
+					}
+					*slot = target;
+					lua_pushvalue(L_, fx_index);
+					lua_pushvalue(L_, self_index);
+					for (int i = 0; i < argc; ++i) {
+						lua_pushvalue(L_, args_index + i);
+					}
+					status = lua_pcall(L_, argc + 1, 0, 0);
+					if (status != LUA_OK) {
+						const char* message = lua_tostring(L_, -1);
+						lua_pushfstring(L_,
+						     "sol: each: element %d ('%s'): %s",
+						     static_cast<int>(visited + start),
+						     method,
+						     message != nullptr ? message : luaL_typename(L_, -1));
+						break;
+					}
+				}
+				// the userdata may have been stashed away by a method: leave it pointing at nothing
+				*slot = nullptr;
+				if (status != LUA_OK) {
+					lua_replace(L_, top + 1);
+					lua_settop(L_, top + 1);
+					return status;
+				}
+				lua_settop(L_, top);
+				return LUA_OK;
+			}
+		}
+
 		template <typename X, typename = void>
 		struct usertype_container_default {
 		private:
@@ -455,6 +553,10 @@ namespace sol {
 				return luaL_error(L_, "sol: cannot call 'erase' on type '%s': it is not recognized as a container", detail::demangle<T>().c_str());
 			}
 
+			static int each(lua_State* L_) {
+				return luaL_error(L_, "sol: cannot call 'each' on type '%s': it is not recognized as a container", detail::demangle<T>().c_str());
+			}
+
 			static int next(lua_State* L_) {
 				return luaL_error(L_, "sol: cannot call 'next' on type '%s': it is not recognized as a container", detail::demangle<T>().c_str());
 			}
@@ -1359,6 +1461,28 @@ namespace sol {
 				return stack::push(L_, empty_start(L_, self));
 			}
 
+			static int each(lua_State* L_) {
+				auto& self = get_src(L_);
+				const char* method = lua_tostring(L_, 2);
+				if (method == nullptr) {
+					return luaL_error(L_, "sol: cannot call 'each' on '%s': the method name must be a string", detail::demangle<T>().c_str());
+				}
+				auto proj = [](auto&& element) -> decltype(auto) {
+					if constexpr (is_associative::value) {
+						return (element.second);
+					}
+					else {
+						return (element);
+					}
+				};
+				std::size_t visited = 0;
+				int status = each_call_range(L_, deferred_uc::begin(L_, self), deferred_uc::end(L_, self), proj, method, 3, lua_gettop(L_) - 2, visited);
+				if (status != LUA_OK) {
+					return lua_error(L_);
+				}
+				return 0;
+			}
+
 			static std::ptrdiff_t index_adjustment(lua_State*, T&) {
 				return static_cast<std::ptrdiff_t>((SOL_CONTAINER_START_INDEX_I_) == 0 ? 0 : -(SOL_CONTAINER_START_INDEX_I_));
 			}
@@ -1522,6 +1646,21 @@ namespace sol {
 				return stack::push(L_, std::extent<T>::value > 0);
 			}
 
+			static int each(lua_State* L_) {
+				T& self = get_src(L_);
+				const char* method = lua_tostring(L_, 2);
+				if (method == nullptr) {
+					return luaL_error(L_, "sol: cannot call 'each' on '%s': the method name must be a string", detail::demangle<T>().c_str());
+				}
+				auto proj = [](auto&& element) -> decltype(auto) { return (element); };
+				std::size_t visited = 0;
+				int status = each_call_range(L_, deferred_uc::begin(L_, self), deferred_uc::end(L_, self), proj, method, 3, lua_gettop(L_) - 2, visited);
+				if (status != LUA_OK) {
+					return lua_error(L_);
+				}
+				return 0;
+			}
+
 			static int pairs(lua_State* L_) {
 				auto& src = get_src(L_);
 				stack::push(L_, next_iter);
@@ -1558,6 +1697,28 @@ namespace sol {
 	template <typename T>
 	struct usertype_container : container_detail::usertype_container_default<T> { };
 
+	// C++-side counterpart of the containers' `each` method: calls `method` on every
+	// element of `range`, converting `args` to Lua values only once for the whole loop
+	template <typename Range, typename... Args>
+	std::size_t for_each_call(lua_State* L, Range& range, const char* method, Args&&... args) {
+		using std::begin;
+		using std::end;
+		int top = lua_gettop(L);
+		int argc = stack::multi_push(L, std::forward<Args>(args)...);
+		auto proj = [](auto&& element) -> decltype(auto) { return (element); };
+		std::size_t visited = 0;
+		int status = container_detail::each_call_range(L, begin(range), end(range), proj, method, top + 1, argc, visited);
+		if (status != LUA_OK) {
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+			std::string message = stack::get<std::string>(L, -1);
+			lua_settop(L, top);
+			throw error(detail::direct_error, std::move(message));
+#endif
+		}
+		lua_settop(L, top);
+		return visited;
+	}
+
 } // namespace sol
 
 #endif // SOL_USERTYPE_CONTAINER_HPP
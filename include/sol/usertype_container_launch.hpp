@@ -59,6 +59,7 @@ namespace sol {
 					{ "find", &real_find_call },
 					{ "index_of", &real_index_of_call },
 					{ "erase", &real_erase_call },
+					{ "each", &real_each_call },
 					{ "pairs", &pairs_call },
 					{ "next", &next_call },
 				};
@@ -250,6 +251,15 @@ namespace sol {
 				}
 			}
 
+			static inline int real_each_call(lua_State* L) {
+				if constexpr (container_detail::has_traits_each<uc>()) {
+					return uc::each(L);
+				}
+				else {
+					return default_uc::each(L);
+				}
+			}
+
 			static inline int add_call(lua_State* L) {
 				return detail::typed_static_trampoline<decltype(&real_add_call), (&real_add_call)>(L);
 			}
@@ -270,6 +280,10 @@ namespace sol {
 				return detail::typed_static_trampoline<decltype(&real_empty_call), (&real_empty_call)>(L);
 			}
 
+			static inline int each_call(lua_State* L) {
+				return detail::typed_static_trampoline<decltype(&real_each_call), (&real_each_call)>(L);
+			}
+
 			static inline int find_call(lua_State* L) {
 				return detail::typed_static_trampoline<decltype(&real_find_call), (&real_find_call)>(L);
 			}
@@ -330,7 +344,7 @@ namespace sol {
 					     = container_detail::u_c_launch<meta::conditional_t<is_shim, as_container_t<std::remove_pointer_t<T>>, std::remove_pointer_t<T>>>;
 					static const char* metakey
 					     = is_shim ? &usertype_traits<as_container_t<std::remove_pointer_t<T>>>::metatable()[0] : &usertype_traits<T>::metatable()[0];
-					static const std::array<luaL_Reg, 20> reg = { {
+					static const std::array<luaL_Reg, 21> reg = { {
 						// clang-format off
 						{ "__pairs", &meta_usertype_container::pairs_call },
 						{ "__ipairs", &meta_usertype_container::ipairs_call },
@@ -350,6 +364,7 @@ namespace sol {
 						{ "find", &meta_usertype_container::find_call },
 						{ "index_of", &meta_usertype_container::index_of_call },
 						{ "erase", &meta_usertype_container::erase_call },
+						{ "each", &meta_usertype_container::each_call },
 						std::is_pointer<T>::value ? luaL_Reg{ nullptr, nullptr } : luaL_Reg{ "__gc", &detail::usertype_alloc_destroy<T> },
 						{ nullptr, nullptr }
 						// clang-format on 
@@ -0,0 +1,188 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_USERTYPE_DECLARATION_HPP
+#define SOL_USERTYPE_DECLARATION_HPP
+
+#include <sol/compatibility.hpp>
+#include <sol/trampoline.hpp>
+
+#include <functional>
+#include <initializer_list>
+#include <new>
+#include <string>
+#include <utility>
+
+namespace sol {
+
+	namespace detail {
+		// a usertype declared with state_view::declare_usertype: the registration it will run, and
+		// afterwards the class table that registration made. It lives in a userdata the state owns
+		struct usertype_declaration {
+			std::function<int(lua_State*)> registration;
+			// the global the registration's new_usertype stores the class table under
+			std::string name;
+			// set only once the registration succeeded
+			int class_table_ref = LUA_NOREF;
+			// set when the registration starts, and never cleared: it must not run again
+			// from the metatables it creates, nor a second time after it failed
+			bool registering = false;
+		};
+
+		// registry[key] maps every metatable name of a declared usertype to its declaration
+		inline const void* usertype_declarations_registry_key() noexcept {
+			static const char key = 0;
+			return static_cast<const void*>(&key);
+		}
+
+		inline int destroy_usertype_declaration(lua_State* L) {
+			usertype_declaration* declaration = static_cast<usertype_declaration*>(lua_touserdata(L, 1));
+			declaration->~usertype_declaration();
+			return 0;
+		}
+
+		inline void materialize_usertype(lua_State* L, usertype_declaration& declaration) {
+			if (declaration.registering) {
+				return;
+			}
+			declaration.registering = true;
+			declaration.class_table_ref = declaration.registration(L);
+			declaration.registration = nullptr;
+		}
+
+		// runs the registration declared for the metatable named key, if there is one still waiting
+		inline bool materialize_declared_usertype(lua_State* L, const char* key) {
+			if (lua_rawgetp(L, LUA_REGISTRYINDEX, usertype_declarations_registry_key()) != LUA_TTABLE) {
+				lua_pop(L, 1);
+				return false;
+			}
+			lua_getfield(L, -1, key);
+			usertype_declaration* declaration = static_cast<usertype_declaration*>(lua_touserdata(L, -1));
+			lua_pop(L, 2);
+			if (declaration == nullptr || declaration->registering) {
+				return false;
+			}
+			materialize_usertype(L, *declaration);
+			return true;
+		}
+
+		// luaL_newmetatable, except that when the metatable is missing because its usertype was only
+		// declared so far, the usertype is registered and its metatable used instead of a fresh one
+		inline int new_metatable(lua_State* L, const char* key) {
+			lua_getfield(L, LUA_REGISTRYINDEX, key);
+			if (lua_type(L, -1) != LUA_TNIL) {
+				return 0;
+			}
+			lua_pop(L, 1);
+			if (materialize_declared_usertype(L, key)) {
+				lua_getfield(L, LUA_REGISTRYINDEX, key);
+				if (lua_type(L, -1) != LUA_TNIL) {
+					return 0;
+				}
+				lua_pop(L, 1);
+			}
+			return luaL_newmetatable(L, key);
+		}
+
+		inline void push_declared_class_table(lua_State* L) {
+			usertype_declaration& declaration = *static_cast<usertype_declaration*>(lua_touserdata(L, lua_upvalueindex(1)));
+			materialize_usertype(L, declaration);
+			if (declaration.class_table_ref != LUA_NOREF) {
+				lua_rawgeti(L, LUA_REGISTRYINDEX, declaration.class_table_ref);
+				return;
+			}
+			// the registration failed part way: what new_usertype had already set up stays, as it
+			// would without the declaration, and a placeholder kept from before reaches it as well
+			lua_getglobal(L, declaration.name.c_str());
+			if (lua_type(L, -1) != LUA_TTABLE || lua_rawequal(L, -1, 1)) {
+				(void)luaL_error(L, "sol: the registration of usertype '%s' failed", declaration.name.c_str());
+			}
+		}
+
+		// the placeholder class table forwards everything to the real one, registering it first
+		inline int declared_class_index(lua_State* L) {
+			push_declared_class_table(L);
+			lua_pushvalue(L, 2);
+			lua_gettable(L, -2);
+			return 1;
+		}
+
+		inline int declared_class_new_index(lua_State* L) {
+			push_declared_class_table(L);
+			lua_pushvalue(L, 2);
+			lua_pushvalue(L, 3);
+			lua_settable(L, -3);
+			return 0;
+		}
+
+		inline int declared_class_call(lua_State* L) {
+			push_declared_class_table(L);
+			lua_replace(L, 1);
+			lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);
+			return lua_gettop(L);
+		}
+
+		// leaves a placeholder class table on the stack, which scripts see until the type is used
+		inline void push_usertype_declaration(lua_State* L, std::string name, std::function<int(lua_State*)> registration,
+		     std::initializer_list<const char*> metatable_keys) {
+			void* memory = lua_newuserdata(L, sizeof(usertype_declaration));
+			new (memory) usertype_declaration { std::move(registration), std::move(name), LUA_NOREF, false };
+			if (luaL_newmetatable(L, "sol.usertype_declaration") != 0) {
+				lua_pushcfunction(L, &destroy_usertype_declaration);
+				lua_setfield(L, -2, "__gc");
+			}
+			lua_setmetatable(L, -2);
+			int declaration_index = lua_gettop(L);
+
+			if (lua_rawgetp(L, LUA_REGISTRYINDEX, usertype_declarations_registry_key()) != LUA_TTABLE) {
+				lua_pop(L, 1);
+				lua_newtable(L);
+				lua_pushvalue(L, -1);
+				lua_rawsetp(L, LUA_REGISTRYINDEX, usertype_declarations_registry_key());
+			}
+			for (const char* key : metatable_keys) {
+				lua_pushvalue(L, declaration_index);
+				lua_setfield(L, -2, key);
+			}
+			lua_pop(L, 1);
+
+			lua_newtable(L);
+			lua_createtable(L, 0, 3);
+			lua_pushvalue(L, declaration_index);
+			lua_pushcclosure(L, &static_trampoline<&declared_class_index>, 1);
+			lua_setfield(L, -2, "__index");
+			lua_pushvalue(L, declaration_index);
+			lua_pushcclosure(L, &static_trampoline<&declared_class_new_index>, 1);
+			lua_setfield(L, -2, "__newindex");
+			lua_pushvalue(L, declaration_index);
+			lua_pushcclosure(L, &static_trampoline<&declared_class_call>, 1);
+			lua_setfield(L, -2, "__call");
+			lua_setmetatable(L, -2);
+			lua_remove(L, declaration_index);
+		}
+	} // namespace detail
+
+} // namespace sol
+
+#endif // SOL_USERTYPE_DECLARATION_HPP
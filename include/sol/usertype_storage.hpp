@@ -45,6 +45,7 @@ namespace sol { namespace u_detail {
 	usertype_storage<T>& get_usertype_storage(lua_State* L_);
 
 	using index_call_function = int(lua_State*, void*);
+	using variable_call_function = int(lua_State*, void*, void*);
 	using change_indexing_mem_func = void (usertype_storage_base::*)(
 		lua_State*, submetatable_type, void*, stateless_stack_reference&, lua_CFunction, lua_CFunction, lua_CFunction, lua_CFunction);
 
@@ -52,6 +53,9 @@ namespace sol { namespace u_detail {
 		index_call_function* index;
 		index_call_function* new_index;
 		void* binding_data;
+		// variables only: read/write an already-checked self, with the value at 3, leaving the rest of the stack alone
+		variable_call_function* variable_index;
+		variable_call_function* variable_new_index;
 	};
 
 	struct new_index_call_storage : index_call_storage {
@@ -107,6 +111,20 @@ namespace sol { namespace u_detail {
 			}
 		}
 
+		template <bool is_index>
+		static inline int variable_call_with_(lua_State* L_, void* target, void* self) {
+			auto& f = *static_cast<F*>(target);
+			if constexpr (std::is_member_object_pointer_v<F> && !std::is_void_v<T>) {
+				// the caller already checked self once for the whole batch
+				T& o = *static_cast<T*>(self);
+				return call_detail::call_wrapped<T, is_index, true, 0, detail::default_safe_function_calls, false>(L_, f, o);
+			}
+			else {
+				(void)self;
+				return call_detail::call_wrapped<T, is_index, true, 0, detail::default_safe_function_calls, false>(L_, f);
+			}
+		}
+
 		template <bool is_index = true, bool is_variable = false>
 		static inline int index_call_with_(lua_State* L_, void* target) {
 			if constexpr (!is_variable) {
@@ -659,6 +677,93 @@ namespace sol { namespace u_detail {
 			return detail::static_trampoline<&index_call_with_bases_<is_new_index, true, Bases...>>(L);
 		}
 
+		static index_call_storage* find_variable(lua_State* L, int index, usertype_storage_base& self) {
+			if (lua_type(L, index) != LUA_TSTRING) {
+				return nullptr;
+			}
+			auto it = self.string_keys.find(stack::get<string_view>(L, index));
+			if (it == self.string_keys.cend() || it->second.variable_index == nullptr) {
+				return nullptr;
+			}
+			return &it->second;
+		}
+
+		// obj:set{ k = v, ... }: own variables are written straight through their bindings,
+		// anything else (methods, base class members, unknown keys) goes through a regular obj[k] = v
+		static int bulk_set_(lua_State* L, usertype_storage_base& self, void* object) {
+			luaL_checktype(L, 2, LUA_TTABLE);
+			lua_settop(L, 2);
+			// 3: the value, where variable bindings expect it; 4: the traversal key
+			lua_pushnil(L);
+			lua_pushnil(L);
+			while (lua_next(L, 2) != 0) {
+				lua_replace(L, 3);
+				index_call_storage* target = find_variable(L, 4, self);
+				if (target != nullptr) {
+					(target->variable_new_index)(L, target->binding_data, object);
+				}
+				else {
+					lua_pushvalue(L, 4);
+					lua_pushvalue(L, 3);
+					lua_settable(L, 1);
+				}
+				lua_settop(L, 4);
+			}
+			lua_settop(L, 1);
+			return 1;
+		}
+
+		// obj:get(k, ...): one result per key, in order
+		static int bulk_get_(lua_State* L, usertype_storage_base& self, void* object) {
+			int last = lua_gettop(L);
+			luaL_checkstack(L, last, "sol: too many keys for get");
+			for (int i = 2; i <= last; ++i) {
+				index_call_storage* target = find_variable(L, i, self);
+				int top = lua_gettop(L);
+				if (target != nullptr) {
+					(target->variable_index)(L, target->binding_data, object);
+				}
+				else {
+					lua_pushvalue(L, i);
+					lua_gettable(L, 1);
+				}
+				// exactly one value per key
+				lua_settop(L, top + 1);
+			}
+			return last - 1;
+		}
+
+		template <bool is_set>
+		static int bulk_call_(lua_State* L) {
+			if (type_of(L, 1) != type::userdata) {
+				return luaL_error(L, "sol: 'self' argument is not a userdata (use ':' to call '%s')", is_set ? "set" : "get");
+			}
+#if SOL_IS_ON(SOL_SAFE_USERTYPE)
+			// checked once here instead of once per field
+			auto maybe_object = stack::check_get<T*>(L, 1);
+			if (!maybe_object || *maybe_object == nullptr) {
+				return luaL_error(L, "sol: 'self' argument is not a %s", detail::demangle<T>().c_str());
+			}
+			T* self = *maybe_object;
+#else
+			T* self = stack::get<T*>(L, 1);
+#endif // Safety
+			// only reachable through T's metatables, which unregistering clears: the storage is there
+			usertype_storage<T>& storage = get_usertype_storage<T>(L);
+			void* object = static_cast<void*>(self);
+			if constexpr (is_set) {
+				return bulk_set_(L, storage, object);
+			}
+			else {
+				return bulk_get_(L, storage, object);
+			}
+		}
+
+		template <bool is_set>
+		static inline int bulk_call(lua_State* L) {
+			return detail::static_trampoline<&bulk_call_<is_set>>(L);
+		}
+
 		template <typename Key, typename Value>
 		inline void set(lua_State* L, Key&& key, Value&& value);
 	};
@@ -690,6 +795,14 @@ namespace sol { namespace u_detail {
 			(void)key;
 			this->update_bases<T>(L, std::forward<Value>(value));
 		}
+		else if constexpr (std::is_same_v<ValueU, bulk_set_t>) {
+			(void)value;
+			this->set<T>(L, std::forward<Key>(key), static_cast<lua_CFunction>(&usertype_storage<T>::template bulk_call<true>));
+		}
+		else if constexpr (std::is_same_v<ValueU, bulk_get_t>) {
+			(void)value;
+			this->set<T>(L, std::forward<Key>(key), static_cast<lua_CFunction>(&usertype_storage<T>::template bulk_call<false>));
+		}
 		else if constexpr ((meta::is_string_like_or_constructible<KeyU>::value || std::is_same_v<KeyU, meta_function>)) {
 			std::string s = u_detail::make_string(std::forward<Key>(key));
 			auto storage_it = this->storage.end();
@@ -722,6 +835,14 @@ namespace sol { namespace u_detail {
 				                                   : &Binding::template index_call_with_<true, is_var_bind::value>;
 			ics.new_index = is_new_index || is_static_new_index ? &Binding::template call_with_<false, is_var_bind::value>
 				                                               : &Binding::template index_call_with_<false, is_var_bind::value>;
+			if constexpr (is_var_bind::value) {
+				ics.variable_index = &Binding::template variable_call_with_<true>;
+				ics.variable_new_index = &Binding::template variable_call_with_<false>;
+			}
+			else {
+				ics.variable_index = nullptr;
+				ics.variable_new_index = nullptr;
+			}
 
 			string_for_each_metatable_func for_each_fx;
 			for_each_fx.is_destruction = is_destruction;
@@ -1156,6 +1277,12 @@ namespace sol { namespace u_detail {
 			}
 		}
 
+		if constexpr (is_disposable_v<T> && std::is_destructible_v<T>) {
+			lua_CFunction dispose_fx = &detail::dispose<T>;
+			storage.set(L_, meta_function::close, dispose_fx);
+			storage.set(L_, "dispose", dispose_fx);
+		}
+
 		// return the named metatable we want names linked into
 		storage.named_metatable.push(L_);
 		return 1;
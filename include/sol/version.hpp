@@ -301,6 +301,16 @@
 	#define SOL_USE_THREAD_LOCAL_I_ SOL_DEFAULT_ON
 #endif // thread_local keyword is bjorked on some platforms
 
+#if defined(SOL_BORROWED_ARGUMENTS)
+	#if SOL_BORROWED_ARGUMENTS != 0
+		#define SOL_BORROWED_ARGUMENTS_I_ SOL_ON
+	#else
+		#define SOL_BORROWED_ARGUMENTS_I_ SOL_OFF
+	#endif
+#else
+	#define SOL_BORROWED_ARGUMENTS_I_ SOL_DEFAULT_ON
+#endif // table/function/object arguments read straight from the stack
+
 #if defined(SOL_ALL_SAFETIES_ON)
 	#if SOL_ALL_SAFETIES_ON != 0
 		#define SOL_ALL_SAFETIES_ON_I_ SOL_ON
@@ -569,6 +579,70 @@
 	#endif
 #endif // make is_automagical on/off by default
 
+#if defined(SOL_STD_SPAN)
+	#if (SOL_STD_SPAN != 0)
+		#define SOL_STD_SPAN_I_ SOL_ON
+	#else
+		#define SOL_STD_SPAN_I_ SOL_OFF
+	#endif
+#else
+	#if defined(__has_include) && ((defined(_MSVC_LANG) && _MSVC_LANG > 201703L) || (!defined(_MSVC_LANG) && __cplusplus > 201703L))
+		#if __has_include(<span>)
+			#define SOL_STD_SPAN_I_ SOL_DEFAULT_ON
+		#else
+			#define SOL_STD_SPAN_I_ SOL_DEFAULT_OFF
+		#endif
+	#else
+		#define SOL_STD_SPAN_I_ SOL_DEFAULT_OFF
+	#endif
+#endif // std::span<const std::byte> as Lua strings
+
+#if defined(SOL_STD_FILESYSTEM)
+	#if (SOL_STD_FILESYSTEM != 0)
+		#define SOL_STD_FILESYSTEM_I_ SOL_ON
+	#else
+		#define SOL_STD_FILESYSTEM_I_ SOL_OFF
+	#endif
+#else
+	#if defined(__has_include)
+		#if __has_include(<filesystem>)
+			#define SOL_STD_FILESYSTEM_I_ SOL_DEFAULT_ON
+		#else
+			#define SOL_STD_FILESYSTEM_I_ SOL_DEFAULT_OFF
+		#endif
+	#else
+		#define SOL_STD_FILESYSTEM_I_ SOL_DEFAULT_OFF
+	#endif
+#endif // directory indexing for sol::package_index
+
+#if defined(SOL_MAPPED_FILE_LOAD)
+	#if (SOL_MAPPED_FILE_LOAD != 0)
+		#define SOL_MAPPED_FILE_LOAD_I_ SOL_ON
+	#else
+		#define SOL_MAPPED_FILE_LOAD_I_ SOL_OFF
+	#endif
+#else
+	#if defined(__has_include) && !defined(_WIN32)
+		#if __has_include(<sys/mman.h>) && __has_include(<sys/stat.h>) && __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+			#define SOL_MAPPED_FILE_LOAD_I_ SOL_DEFAULT_ON
+		#else
+			#define SOL_MAPPED_FILE_LOAD_I_ SOL_DEFAULT_OFF
+		#endif
+	#else
+		#define SOL_MAPPED_FILE_LOAD_I_ SOL_DEFAULT_OFF
+	#endif
+#endif // mmap source files instead of reading them
+
+#if defined(SOL_METRICS)
+	#if (SOL_METRICS != 0)
+		#define SOL_METRICS_I_ SOL_ON
+	#else
+		#define SOL_METRICS_I_ SOL_OFF
+	#endif
+#else
+	#define SOL_METRICS_I_ SOL_DEFAULT_ON
+#endif // runtime counters reported by state_view::metrics
+
 #if defined(SOL_NOEXCEPT_FUNCTION_TYPE)
 	#if (SOL_NOEXCEPT_FUNCTION_TYPE != 0)
 		#define SOL_USE_NOEXCEPT_FUNCTION_TYPE_I_ SOL_ON
@@ -0,0 +1,175 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include <catch2/catch_all.hpp>
+
+#include <sol/sol.hpp>
+
+#include <chrono>
+#include <string>
+
+TEST_CASE("environments/sandbox", "sandboxes restrict globals, and enforce memory, instruction and time budgets") {
+	SECTION("basic") {
+		sol::state lua;
+		sol::stack_guard luasg(lua);
+		lua.open_libraries(sol::lib::base, sol::lib::string, sol::lib::os);
+
+		sol::sandbox box(lua);
+		{
+			sol::protected_function_result result = box.safe_script("leaked = 24 return string.rep('a', 2) .. tostring(os)", sol::script_pass_on_error);
+			REQUIRE(result.valid());
+			std::string value = result;
+			REQUIRE(value == "aanil");
+		}
+		REQUIRE(box.violation() == sol::sandbox_violation::none);
+		sol::object leaked = lua["leaked"];
+		REQUIRE_FALSE(leaked.valid());
+		int env_leaked = box.env()["leaked"];
+		REQUIRE(env_leaked == 24);
+	}
+	SECTION("reset") {
+		sol::state lua;
+		sol::stack_guard luasg(lua);
+		lua.open_libraries(sol::lib::base, sol::lib::string);
+
+		sol::sandbox box(lua);
+		box.safe_script("x = 1 string.poisoned = true setmetatable(_G, { __index = function() return 2 end })");
+		sol::object host_poisoned = lua["string"]["poisoned"];
+		REQUIRE_FALSE(host_poisoned.valid());
+		box.reset();
+		{
+			sol::protected_function_result result = box.safe_script("return x, string.poisoned, undefined_name", sol::script_pass_on_error);
+			REQUIRE(result.valid());
+			sol::object x = result[0];
+			sol::object poisoned = result[1];
+			sol::object undefined_name = result[2];
+			REQUIRE_FALSE(x.valid());
+			REQUIRE_FALSE(poisoned.valid());
+			REQUIRE_FALSE(undefined_name.valid());
+		}
+	}
+	SECTION("explicit allowed globals") {
+		sol::state lua;
+		sol::stack_guard luasg(lua);
+		lua.open_libraries(sol::lib::base, sol::lib::math);
+		lua["host_value"] = 11;
+
+		sol::sandbox box(lua, {}, { "host_value", "math" });
+		sol::protected_function_result result = box.safe_script("return host_value + math.floor(0.5), print", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		int value = result[0];
+		sol::object print = result[1];
+		REQUIRE(value == 11);
+		REQUIRE_FALSE(print.valid());
+	}
+	SECTION("instruction budget") {
+		sol::state lua;
+		sol::stack_guard luasg(lua);
+		lua.open_libraries(sol::lib::base);
+
+		sol::sandbox_limits limits;
+		limits.instructions = 100000;
+		limits.hook_interval = 100;
+		sol::sandbox box(lua, limits);
+		{
+			sol::protected_function_result result = box.safe_script("while true do end", sol::script_pass_on_error);
+			REQUIRE_FALSE(result.valid());
+			sol::error err = result;
+			REQUIRE(std::string(err.what()).find("budget of 100000 instructions") != std::string::npos);
+		}
+		REQUIRE(box.violation() == sol::sandbox_violation::instructions);
+		REQUIRE(box.instructions_used() > limits.instructions);
+		{
+			sol::protected_function_result result = box.safe_script("local x = 0 for i = 1, 100 do x = x + i end return x", sol::script_pass_on_error);
+			REQUIRE(result.valid());
+			int value = result;
+			REQUIRE(value == 5050);
+		}
+		REQUIRE(box.violation() == sol::sandbox_violation::none);
+		// the hook does not outlive the run
+		REQUIRE(lua_gethook(lua) == nullptr);
+	}
+	SECTION("time budget") {
+		sol::state lua;
+		sol::stack_guard luasg(lua);
+		lua.open_libraries(sol::lib::base);
+
+		sol::sandbox_limits limits;
+		limits.time = std::chrono::milliseconds(20);
+		sol::sandbox box(lua, limits);
+		{
+			sol::protected_function_result result = box.safe_script("while true do pcall(error) end", sol::script_pass_on_error);
+			REQUIRE_FALSE(result.valid());
+		}
+		REQUIRE(box.violation() == sol::sandbox_violation::time);
+	}
+	SECTION("memory budget") {
+		sol::state lua;
+		sol::stack_guard luasg(lua);
+		lua.open_libraries(sol::lib::base);
+
+		sol::sandbox_limits limits;
+		limits.memory = 256 * 1024;
+		sol::sandbox box(lua, limits);
+		{
+			sol::protected_function_result result = box.safe_script("local t = {} for i = 1, 1000000 do t[i] = i end", sol::script_pass_on_error);
+			REQUIRE_FALSE(result.valid());
+			REQUIRE(result.status() == sol::call_status::memory);
+		}
+		REQUIRE(box.violation() == sol::sandbox_violation::memory);
+		REQUIRE(box.peak_memory_used() <= limits.memory);
+		{
+			sol::protected_function_result result = box.safe_script("local t = {} for i = 1, 100 do t[i] = i end return #t", sol::script_pass_on_error);
+			REQUIRE(result.valid());
+			int value = result;
+			REQUIRE(value == 100);
+		}
+		REQUIRE(box.violation() == sol::sandbox_violation::none);
+		REQUIRE(box.memory_used() > 0);
+	}
+	SECTION("load once, call many times") {
+		sol::state lua;
+		sol::stack_guard luasg(lua);
+		lua.open_libraries(sol::lib::base);
+
+		sol::sandbox box(lua);
+		sol::protected_function f;
+		{
+			sol::load_result lr = box.load("local a = ... counter = (counter or 0) + a return counter");
+			REQUIRE(lr.valid());
+			f = lr;
+		}
+		for (int i = 1; i <= 3; ++i) {
+			sol::protected_function_result result = box.call(f, 2);
+			REQUIRE(result.valid());
+			int value = result;
+			REQUIRE(value == i * 2);
+		}
+		box.reset();
+		sol::protected_function_result result = box.call(f, 5);
+		REQUIRE(result.valid());
+		int value = result;
+		REQUIRE(value == 5);
+	}
+}
@@ -0,0 +1,147 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <list>
+#include <sstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#if SOL_IS_ON(SOL_STD_SPAN)
+#include <ranges>
+#endif
+
+namespace {
+	struct counting_range {
+		struct iterator {
+			using iterator_category = std::input_iterator_tag;
+			using value_type = int;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const int*;
+			using reference = int;
+
+			int current;
+			int* produced;
+
+			int operator*() const {
+				++*produced;
+				return current;
+			}
+			iterator& operator++() {
+				++current;
+				return *this;
+			}
+			bool operator==(const iterator& other) const {
+				return current == other.current;
+			}
+			bool operator!=(const iterator& other) const {
+				return current != other.current;
+			}
+		};
+
+		int count;
+		int produced = 0;
+
+		iterator begin() {
+			return iterator { 0, &produced };
+		}
+		iterator end() {
+			return iterator { count, &produced };
+		}
+	};
+} // namespace
+
+TEST_CASE("containers/as_iterator", "ranges are walked lazily by a generic for without becoming a table") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+
+	SECTION("borrowed") {
+		std::vector<int> values { 5, 6, 7 };
+		lua.set_function("values", [&values]() { return sol::as_iterator(values); });
+		values.push_back(8);
+		lua.safe_script(R"(
+sum, last = 0, 0
+for i, v in values() do
+	sum = sum + v
+	last = i
+end
+)");
+		REQUIRE(lua["sum"].get<int>() == 26);
+		REQUIRE(lua["last"].get<int>() == 4);
+	}
+	SECTION("owned") {
+		lua.set_function("words", []() { return sol::as_iterator(std::list<std::string> { "a", "b", "c" }); });
+		std::string joined = lua.safe_script(R"(
+local s = ""
+for _, w in words() do
+	s = s .. w
+end
+return s
+)");
+		REQUIRE(joined == "abc");
+	}
+	SECTION("lazy") {
+		counting_range range { 1000000 };
+		lua.set_function("numbers", [&range]() { return sol::as_iterator(range); });
+		int last = lua.safe_script(R"(
+for i, v in numbers() do
+	if v == 9 then
+		return v
+	end
+end
+)");
+		REQUIRE(last == 9);
+		REQUIRE(range.produced == 10);
+	}
+	SECTION("input iterators") {
+		std::istringstream stream("1 2 3 4");
+		lua.set_function("stream", [&stream]() { return sol::as_iterator(std::istream_iterator<int>(stream), std::istream_iterator<int>()); });
+		int total = lua.safe_script(R"(
+local total = 0
+for _, v in stream() do
+	total = total + v
+end
+return total
+)");
+		REQUIRE(total == 10);
+	}
+#if SOL_IS_ON(SOL_STD_SPAN)
+	SECTION("views") {
+		lua.set_function("evens", [](int n) { return sol::as_iterator(std::views::iota(0, n) | std::views::filter([](int v) { return v % 2 == 0; })); });
+		int count = lua.safe_script(R"(
+local count = 0
+for _, v in evens(100) do
+	count = count + 1
+end
+return count
+)");
+		REQUIRE(count == 50);
+	}
+#endif
+	lua.collect_garbage();
+}
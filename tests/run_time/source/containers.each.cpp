@@ -0,0 +1,126 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+inline namespace sol2_test_containers_each {
+	struct mover {
+		double x = 0;
+		int calls = 0;
+
+		void update(double dt, double speed) {
+			x += dt * speed;
+			++calls;
+		}
+
+		void explode() {
+			if (x > 1.5) {
+				throw std::runtime_error("mover exploded");
+			}
+		}
+	};
+} // namespace sol2_test_containers_each
+
+TEST_CASE("containers/each", "call a bound method on every element with one call from Lua") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<mover>("mover", "update", &mover::update, "explode", &mover::explode, "x", &mover::x);
+
+	std::vector<mover> movers(4);
+	for (std::size_t i = 0; i < movers.size(); ++i) {
+		movers[i].x = static_cast<double>(i);
+	}
+	lua["movers"] = &movers;
+
+	SECTION("vector of values") {
+		sol::stack_guard luasg(lua);
+		auto result = lua.safe_script("movers:each('update', 0.5, 2)", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		for (std::size_t i = 0; i < movers.size(); ++i) {
+			REQUIRE(movers[i].x == static_cast<double>(i) + 1.0);
+			REQUIRE(movers[i].calls == 1);
+		}
+	}
+	SECTION("methods defined in Lua") {
+		sol::stack_guard luasg(lua);
+		auto result = lua.safe_script(R"(
+function mover:nudge(by) self.x = self.x + by end
+movers:each("nudge", 10)
+)",
+		     sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(movers[0].x == 10.0);
+		REQUIRE(movers[3].x == 13.0);
+	}
+	SECTION("errors name the element") {
+		sol::stack_guard luasg(lua);
+		auto result = lua.safe_script("movers:each('explode')", sol::script_pass_on_error);
+		REQUIRE_FALSE(result.valid());
+		sol::error err = result;
+		std::string message = err.what();
+		REQUIRE(message.find("element 3 ('explode')") != std::string::npos);
+		REQUIRE(message.find("mover exploded") != std::string::npos);
+
+		auto missing = lua.safe_script("movers:each('fly')", sol::script_pass_on_error);
+		REQUIRE_FALSE(missing.valid());
+		sol::error missing_err = missing;
+		REQUIRE(std::string(missing_err.what()).find("'fly' is not a member") != std::string::npos);
+	}
+	SECTION("pointers and maps") {
+		sol::stack_guard luasg(lua);
+		mover a, b;
+		std::vector<mover*> pointers { &a, &b };
+		std::map<std::string, mover> named;
+		named["one"] = mover();
+		named["two"] = mover();
+		lua["pointers"] = &pointers;
+		lua["named"] = &named;
+		auto result = lua.safe_script("pointers:each('update', 1, 3) named:each('update', 2, 2)", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(a.x == 3.0);
+		REQUIRE(b.x == 3.0);
+		REQUIRE(named["one"].x == 4.0);
+		REQUIRE(named["two"].calls == 1);
+
+		pointers.push_back(nullptr);
+		auto nil_element = lua.safe_script("pointers:each('update', 1, 3)", sol::script_pass_on_error);
+		REQUIRE_FALSE(nil_element.valid());
+		sol::error err = nil_element;
+		REQUIRE(std::string(err.what()).find("element 3 ('update') is nil") != std::string::npos);
+	}
+	SECTION("from C++") {
+		sol::stack_guard luasg(lua);
+		std::size_t visited = sol::for_each_call(lua, movers, "update", 1.0, 1.0);
+		REQUIRE(visited == 4);
+		REQUIRE(movers[2].x == 3.0);
+		REQUIRE_THROWS_AS(sol::for_each_call(lua, movers, "explode"), sol::error);
+	}
+}
@@ -0,0 +1,172 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <string>
+#include <tuple>
+#include <vector>
+#if SOL_IS_ON(SOL_STD_SPAN)
+#include <ranges>
+#endif
+
+TEST_CASE("coroutines/generator", "consume values yielded by a Lua coroutine as a C++ input range") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::coroutine);
+
+	auto result = lua.safe_script(R"(
+function count_to(n)
+	for i = 1, n do
+		coroutine.yield(i)
+	end
+	return "done"
+end
+
+function pairs_to(n)
+	for i = 1, n do
+		coroutine.yield(i, tostring(i))
+	end
+end
+
+function mixed()
+	coroutine.yield(1)
+	coroutine.yield("not a number")
+end
+
+function broken()
+	coroutine.yield(1)
+	error("generator broke")
+end
+)",
+	     sol::script_pass_on_error);
+	REQUIRE(result.valid());
+
+	SECTION("range for") {
+		sol::thread runner = sol::thread::create(lua.lua_state());
+		sol::state_view runnerstate = runner.state();
+		// the generator starts the function without arguments, so bind them in a closure
+		sol::function producer = lua.safe_script("return function () return count_to(5) end");
+		sol::coroutine cr(runnerstate.lua_state(), producer);
+
+		std::vector<int> values;
+		sol::generator<int> gen(cr);
+		for (int v : gen) {
+			values.push_back(v);
+		}
+		REQUIRE(values == std::vector<int> { 1, 2, 3, 4, 5 });
+		REQUIRE(gen.status() == sol::call_status::ok);
+		REQUIRE_FALSE(gen.error());
+		REQUIRE(gen.begin() == gen.end());
+	}
+	SECTION("algorithms") {
+		sol::thread runner = sol::thread::create(lua.lua_state());
+		sol::state_view runnerstate = runner.state();
+		sol::function producer = lua.safe_script("return function () return count_to(10) end");
+		sol::coroutine cr(runnerstate.lua_state(), producer);
+
+		sol::generator<int> gen(cr);
+		int sum = 0;
+		for (auto it = gen.begin(); it != gen.end(); it++) {
+			sum += *it;
+		}
+		REQUIRE(sum == 55);
+#if SOL_IS_ON(SOL_STD_SPAN)
+		sol::thread again = sol::thread::create(lua.lua_state());
+		sol::coroutine cr2(again.state().lua_state(), producer);
+		sol::generator<int> evens(cr2);
+		std::vector<int> values;
+		for (int v : evens | std::views::filter([](int v) { return v % 2 == 0; })) {
+			values.push_back(v);
+		}
+		REQUIRE(values == std::vector<int> { 2, 4, 6, 8, 10 });
+#endif
+	}
+	SECTION("multiple yielded values") {
+		sol::thread runner = sol::thread::create(lua.lua_state());
+		sol::state_view runnerstate = runner.state();
+		sol::function producer = lua.safe_script("return function () return pairs_to(3) end");
+		sol::coroutine cr(runnerstate.lua_state(), producer);
+
+		std::vector<std::tuple<int, std::string>> values;
+		for (auto& v : sol::generator<std::tuple<int, std::string>>(cr)) {
+			values.push_back(v);
+		}
+		REQUIRE(values.size() == 3);
+		REQUIRE(std::get<0>(values[2]) == 3);
+		REQUIRE(std::get<1>(values[2]) == "3");
+	}
+	SECTION("stops early") {
+		sol::thread runner = sol::thread::create(lua.lua_state());
+		sol::state_view runnerstate = runner.state();
+		sol::function producer = lua.safe_script("return function () return count_to(1000000) end");
+		sol::coroutine cr(runnerstate.lua_state(), producer);
+
+		int last = 0;
+		for (int v : sol::generator<int>(cr)) {
+			last = v;
+			if (v == 3) {
+				break;
+			}
+		}
+		REQUIRE(last == 3);
+		REQUIRE(lua_gettop(runnerstate.lua_state()) == 0);
+	}
+	SECTION("errors") {
+		{
+			sol::thread runner = sol::thread::create(lua.lua_state());
+			sol::state_view runnerstate = runner.state();
+			sol::coroutine cr = runnerstate["broken"];
+			sol::generator<int> gen(cr);
+			std::vector<int> values;
+			bool caught = false;
+			try {
+				for (int v : gen) {
+					values.push_back(v);
+				}
+			}
+			catch (const sol::error& e) {
+				caught = true;
+				REQUIRE(std::string(e.what()).find("generator broke") != std::string::npos);
+			}
+			REQUIRE(caught);
+			REQUIRE(values == std::vector<int> { 1 });
+			REQUIRE(gen.error());
+			REQUIRE(gen.status() == sol::call_status::runtime);
+			REQUIRE(gen.error_message().find("generator broke") != std::string::npos);
+		}
+		{
+			sol::thread runner = sol::thread::create(lua.lua_state());
+			sol::state_view runnerstate = runner.state();
+			sol::coroutine cr = runnerstate["mixed"];
+			sol::generator<int> gen(cr);
+			auto it = gen.begin();
+			REQUIRE(*it == 1);
+			REQUIRE_THROWS_AS(++it, sol::error);
+			REQUIRE(it == gen.end());
+			REQUIRE(gen.error());
+		}
+	}
+}
@@ -0,0 +1,130 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <vector>
+
+struct borrowed_holder {
+	sol::object value;
+	sol::function callback;
+
+	borrowed_holder(sol::function callback_) : callback(std::move(callback_)) {
+	}
+};
+
+TEST_CASE("functions/borrowed arguments", "table, function and object arguments borrow their stack slot and only take a registry reference when they outlive the call") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+
+	SECTION("read only") {
+		bool borrowed_table = false;
+		bool borrowed_function = false;
+		bool borrowed_object = false;
+		lua.set_function("f", [&](sol::table t, const sol::function& fx, sol::object o) {
+			borrowed_table = t.is_borrowed();
+			borrowed_function = fx.is_borrowed();
+			borrowed_object = o.is_borrowed();
+			return t.get<int>("x") + fx.call<int>() + o.as<int>();
+		});
+		int value = lua.safe_script("return f({ x = 1 }, function() return 20 end, 300)");
+		REQUIRE(value == 321);
+		REQUIRE(borrowed_table);
+		REQUIRE(borrowed_function);
+		REQUIRE(borrowed_object);
+	}
+	SECTION("nil") {
+		bool is_nil = false;
+		lua.set_function("f", [&](sol::object o) {
+			is_nil = o == sol::lua_nil;
+			return o.is<sol::lua_nil_t>() && !o.is_borrowed();
+		});
+		bool value = lua.safe_script("return f(nil)");
+		REQUIRE(value);
+		REQUIRE(is_nil);
+	}
+	SECTION("copies") {
+		sol::table kept;
+		bool copy_borrowed = true;
+		lua.set_function("f", [&](sol::table t) {
+			sol::table copy = t;
+			copy_borrowed = copy.is_borrowed();
+			kept = t;
+		});
+		lua.safe_script("f({ x = 24 })");
+		REQUIRE_FALSE(copy_borrowed);
+		REQUIRE_FALSE(kept.is_borrowed());
+		REQUIRE(kept.get<int>("x") == 24);
+	}
+	SECTION("moves") {
+		sol::function kept;
+		std::vector<sol::table> tables;
+		lua.set_function("f", [&](sol::function fx, sol::table t) {
+			kept = std::move(fx);
+			tables.push_back(std::move(t));
+			REQUIRE(kept.is_borrowed());
+			REQUIRE(tables.back().is_borrowed());
+		});
+		lua.safe_script("f(function() return 42 end, { x = 2 })");
+		lua.collect_garbage();
+		REQUIRE_FALSE(kept.is_borrowed());
+		REQUIRE_FALSE(tables.back().is_borrowed());
+		int value = kept();
+		REQUIRE(value == 42);
+		REQUIRE(tables.back().get<int>("x") == 2);
+	}
+	SECTION("usertype storage") {
+		lua.new_usertype<borrowed_holder>("holder", sol::constructors<borrowed_holder(sol::function)>(), "value", &borrowed_holder::value);
+		lua.safe_script(R"(
+h = holder.new(function() return 5 end)
+h.value = { y = 9 }
+)");
+		borrowed_holder& h = lua["h"];
+		lua.collect_garbage();
+		REQUIRE_FALSE(h.callback.is_borrowed());
+		REQUIRE_FALSE(h.value.is_borrowed());
+		int callback_value = h.callback();
+		REQUIRE(callback_value == 5);
+		REQUIRE(h.value.as<sol::table>().get<int>("y") == 9);
+	}
+	SECTION("nested calls") {
+		sol::table* outer = nullptr;
+		lua.set_function("outer", [&](sol::table t, sol::function fx) {
+			outer = &t;
+			int inner_value = fx();
+			outer = nullptr;
+			return t.get<int>("x") + inner_value;
+		});
+		lua.set_function("inner", [&](sol::table t) { return t.get<int>(1) + t.get<int>(2); });
+		int value = lua.safe_script("return outer({ x = 10 }, function() return inner({ 1, 2 }) end)");
+		REQUIRE(value == 13);
+#if SOL_IS_ON(SOL_SAFE_REFERENCES)
+		lua.set_function("misuse", [&]() { return outer->get<int>("x"); });
+		auto result = lua.safe_script("return outer({ x = 10 }, function() return misuse() end)", sol::script_pass_on_error);
+		REQUIRE_FALSE(result.valid());
+#endif
+	}
+}
@@ -0,0 +1,135 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct deferred_heavy {
+	static inline std::atomic<int> alive { 0 };
+	static inline std::vector<std::thread::id> destroyed_on;
+
+	std::vector<int> payload;
+	bool owner = true;
+
+	deferred_heavy() : payload(1024, 1) {
+		++alive;
+	}
+	deferred_heavy(const deferred_heavy& other) : payload(other.payload) {
+		++alive;
+	}
+	deferred_heavy(deferred_heavy&& other) noexcept : payload(std::move(other.payload)) {
+		other.owner = false;
+	}
+	~deferred_heavy() {
+		if (owner) {
+			--alive;
+			destroyed_on.push_back(std::this_thread::get_id());
+		}
+	}
+};
+
+namespace sol {
+	template <>
+	struct is_deferred_destruction<deferred_heavy> : std::true_type { };
+} // namespace sol
+
+TEST_CASE("gc/deferred destruction", "destructors of opted-in usertypes run when the deferred destruction queue is drained, not inside the collector") {
+	sol::deferred_destruction_queue& queue = sol::default_deferred_destruction_queue();
+	queue.drain();
+	deferred_heavy::destroyed_on.clear();
+	sol::deferred_destruction_metrics before = queue.metrics();
+
+	SECTION("safe point") {
+		{
+			sol::state lua;
+			lua.open_libraries(sol::lib::base);
+			lua.new_usertype<deferred_heavy>("heavy");
+			lua.safe_script(R"(
+for i = 1, 8 do
+	local h = heavy.new()
+end
+held = heavy.new()
+)");
+			lua.collect_garbage();
+			lua.collect_garbage();
+			REQUIRE(deferred_heavy::alive == 9);
+			REQUIRE(queue.size() == 8);
+		}
+		// closing the state finalizes "held" as well
+		REQUIRE(deferred_heavy::alive == 9);
+		REQUIRE(queue.size() == 9);
+
+		REQUIRE(queue.drain(4) == 4);
+		REQUIRE(deferred_heavy::alive == 5);
+		REQUIRE(queue.drain() == 5);
+		REQUIRE(deferred_heavy::alive == 0);
+		REQUIRE(queue.empty());
+
+		sol::deferred_destruction_metrics after = queue.metrics();
+		REQUIRE(after.queued - before.queued == 9);
+		REQUIRE(after.destroyed - before.destroyed == 9);
+		REQUIRE(after.depth == 0);
+		REQUIRE(after.peak_depth >= 9);
+		REQUIRE(after.total_latency >= after.max_latency);
+	}
+	SECTION("unique holders") {
+		std::weak_ptr<deferred_heavy> watch;
+		{
+			sol::state lua;
+			auto p = std::make_shared<deferred_heavy>();
+			watch = p;
+			lua["p"] = std::move(p);
+		}
+		REQUIRE_FALSE(watch.expired());
+		REQUIRE(queue.size() == 1);
+		queue.drain();
+		REQUIRE(watch.expired());
+		REQUIRE(deferred_heavy::alive == 0);
+	}
+	SECTION("worker thread") {
+		{
+			sol::deferred_destruction_worker worker(queue, std::chrono::milliseconds(1));
+			{
+				sol::state lua;
+				lua["a"] = deferred_heavy();
+				lua["b"] = deferred_heavy();
+			}
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			while (deferred_heavy::alive != 0 && std::chrono::steady_clock::now() < deadline) {
+				worker.wake();
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		REQUIRE(deferred_heavy::alive == 0);
+		REQUIRE(deferred_heavy::destroyed_on.size() == 2);
+		REQUIRE(deferred_heavy::destroyed_on[0] != std::this_thread::get_id());
+	}
+}
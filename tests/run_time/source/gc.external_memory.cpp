@@ -0,0 +1,161 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <cstddef>
+#include <memory>
+
+struct external_blob {
+	static inline int alive = 0;
+
+	std::size_t bytes;
+
+	external_blob(std::size_t bytes_) : bytes(bytes_) {
+		++alive;
+	}
+	external_blob(const external_blob& other) : bytes(other.bytes) {
+		++alive;
+	}
+	~external_blob() {
+		--alive;
+	}
+};
+
+std::size_t sol_lua_external_size(const external_blob& blob) {
+	return blob.bytes;
+}
+
+static_assert(sol::has_external_size_v<external_blob>);
+static_assert(!sol::has_external_size_v<int>);
+
+TEST_CASE("gc/external memory", "usertypes that report external memory feed it to the collector when pushed and hand it back when collected") {
+	external_blob::alive = 0;
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<external_blob>("blob",
+	     sol::constructors<external_blob(std::size_t)>(),
+	     "grow",
+	     [](external_blob& blob, std::size_t bytes, sol::this_state L) {
+		     blob.bytes += bytes;
+		     sol::update_external_memory(L, blob);
+	     },
+	     "grow_quietly",
+	     [](external_blob& blob, std::size_t bytes) { blob.bytes += bytes; });
+	REQUIRE(lua.external_memory_used() == 0);
+
+	SECTION("values") {
+		lua["a"] = external_blob(3000);
+		lua["b"] = external_blob(5000);
+		REQUIRE(lua.external_memory_used() == 8000);
+		lua["a"] = sol::lua_nil;
+		lua.collect_garbage();
+		REQUIRE(lua.external_memory_used() == 5000);
+		lua["b"] = sol::lua_nil;
+		lua.collect_garbage();
+		REQUIRE(lua.external_memory_used() == 0);
+	}
+	SECTION("constructors") {
+		sol::optional<sol::error> maybe_error = lua.safe_script("a = blob.new(4096) b = blob.new(1)", sol::script_pass_on_error);
+		REQUIRE_FALSE(maybe_error.has_value());
+		REQUIRE(lua.external_memory_used() == 4097);
+		lua.safe_script("a = nil b = nil");
+		lua.collect_garbage();
+		REQUIRE(lua.external_memory_used() == 0);
+	}
+	SECTION("unique holders") {
+		std::shared_ptr<external_blob> shared = std::make_shared<external_blob>(2048);
+		lua["s"] = shared;
+		lua["u"] = std::make_unique<external_blob>(1024);
+		REQUIRE(lua.external_memory_used() == 3072);
+		lua["s"] = sol::lua_nil;
+		lua["u"] = sol::lua_nil;
+		lua.collect_garbage();
+		REQUIRE(lua.external_memory_used() == 0);
+		REQUIRE(external_blob::alive == 1);
+	}
+	SECTION("growth after construction") {
+		lua["kept"] = external_blob(5 * 1024 * 1024);
+		sol::optional<sol::error> maybe_error = lua.safe_script("a = blob.new(0) a:grow(10 * 1024 * 1024)", sol::script_pass_on_error);
+		REQUIRE_FALSE(maybe_error.has_value());
+		REQUIRE(lua.external_memory_used() == 15 * 1024 * 1024);
+		// growth nobody reported is not charged, and not refunded out of other objects either
+		lua.safe_script("b = blob.new(0) b:grow_quietly(10 * 1024 * 1024)");
+		REQUIRE(lua.external_memory_used() == 15 * 1024 * 1024);
+		lua.safe_script("a = nil b = nil");
+		lua.collect_garbage();
+		REQUIRE(lua.external_memory_used() == 5 * 1024 * 1024);
+		lua["kept"] = sol::lua_nil;
+		lua.collect_garbage();
+		REQUIRE(lua.external_memory_used() == 0);
+	}
+	SECTION("a shared holder pushed twice") {
+		std::shared_ptr<external_blob> shared = std::make_shared<external_blob>(1000);
+		lua["s1"] = shared;
+		lua["s2"] = shared;
+		REQUIRE(lua.external_memory_used() == 2000);
+		shared->bytes = 3000;
+		lua.update_external_memory(*shared);
+		REQUIRE(lua.external_memory_used() == 6000);
+		lua["s1"] = sol::lua_nil;
+		lua.collect_garbage();
+		REQUIRE(lua.external_memory_used() == 3000);
+		lua["s2"] = sol::lua_nil;
+		lua.collect_garbage();
+		REQUIRE(lua.external_memory_used() == 0);
+	}
+	SECTION("references are not counted") {
+		external_blob blob(4096);
+		lua["p"] = &blob;
+		lua["r"] = std::ref(blob);
+		REQUIRE(lua.external_memory_used() == 0);
+		blob.bytes = 8192;
+		lua.update_external_memory(blob);
+		REQUIRE(lua.external_memory_used() == 0);
+	}
+	SECTION("manual adjustment") {
+		lua.adjust_external_memory(2048);
+		REQUIRE(lua.external_memory_used() == 2048);
+		lua.adjust_external_memory(-1000);
+		REQUIRE(lua.external_memory_used() == 1048);
+		lua.adjust_external_memory(-4096);
+		REQUIRE(lua.external_memory_used() == 0);
+	}
+	SECTION("pacing") {
+		// every blob claims a megabyte the Lua heap never sees:
+		// without the reported debt the collector would not run at all here
+		lua.safe_script(R"(
+for i = 1, 256 do
+	local b = blob.new(1024 * 1024)
+end
+)");
+		REQUIRE(external_blob::alive < 256);
+		REQUIRE(lua.external_memory_used() == static_cast<std::size_t>(external_blob::alive) * 1024 * 1024);
+	}
+	lua.collect_garbage();
+	REQUIRE(external_blob::alive == 0);
+}
@@ -0,0 +1,156 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("parallel_for/thread_pool", "every chunk runs exactly once, and the first exception comes back to the caller") {
+	sol::thread_pool pool(3);
+	REQUIRE(pool.concurrency() == 4);
+
+	std::vector<std::atomic<int>> hits(1000);
+	pool.run(hits.size(), [&](std::size_t chunk) { hits[chunk].fetch_add(1); });
+	for (const std::atomic<int>& hit : hits) {
+		REQUIRE(hit.load() == 1);
+	}
+
+	std::vector<int> values(10007);
+	std::iota(values.begin(), values.end(), 0);
+	sol::parallel_for(pool, values.data(), values.size(), 16, [](int* data, std::size_t count, int factor) {
+		for (std::size_t i = 0; i < count; ++i) {
+			data[i] *= factor;
+		}
+	}, 3);
+	for (std::size_t i = 0; i < values.size(); ++i) {
+		REQUIRE(values[i] == static_cast<int>(i) * 3);
+	}
+
+	REQUIRE_THROWS_AS(pool.run(64, [](std::size_t chunk) {
+		if (chunk == 17) {
+			throw std::runtime_error("chunk 17");
+		}
+	}), std::runtime_error);
+	// the pool is still usable afterwards
+	std::atomic<std::size_t> count(0);
+	pool.run(8, [&](std::size_t) { count.fetch_add(1); });
+	REQUIRE(count.load() == 8);
+}
+
+TEST_CASE("parallel_for/kernels", "scripts run registered C++ kernels over vectors and tables") {
+	sol::thread_pool pool(3);
+	sol::parallel_kernels kernels(pool);
+	kernels.add("scale", [](double* data, std::size_t count, double factor) {
+		for (std::size_t i = 0; i < count; ++i) {
+			data[i] *= factor;
+		}
+	});
+	std::atomic<long long> total(0);
+	kernels.add("sum", [&total](const int* data, std::size_t count) {
+		long long partial = 0;
+		for (std::size_t i = 0; i < count; ++i) {
+			partial += data[i];
+		}
+		total.fetch_add(partial);
+	}, 64);
+	kernels.add("fail", [](const int*, std::size_t) { throw std::runtime_error("bad chunk"); });
+	REQUIRE(kernels.size() == 3);
+	REQUIRE(kernels.contains("scale"));
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua["sol"] = lua.create_table_with("parallel_for", kernels.lua_function());
+
+	SECTION("std::vector userdata") {
+		std::vector<double> samples(5000, 2.0);
+		lua["samples"] = &samples;
+		auto result = lua.safe_script("sol.parallel_for(samples, 'scale', 1.5)", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		for (double sample : samples) {
+			REQUIRE(sample == 3.0);
+		}
+	}
+	SECTION("plain tables are copied out and back") {
+		auto result = lua.safe_script(R"(
+t = {}
+for i = 1, 1000 do t[i] = i end
+sol.parallel_for(t, 'sum')
+sol.parallel_for(t, 'scale', 2)
+)",
+		     sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		sol::table t = lua["t"];
+		REQUIRE(t.get<double>(1) == 2.0);
+		REQUIRE(t.get<double>(1000) == 2000.0);
+		REQUIRE(total.load() == 500500);
+	}
+	SECTION("errors") {
+		auto missing = lua.safe_script("sol.parallel_for({1, 2, 3}, 'nope')", sol::script_pass_on_error);
+		REQUIRE_FALSE(missing.valid());
+		sol::error missing_error = missing;
+		REQUIRE(std::string(missing_error.what()).find("no kernel named 'nope'") != std::string::npos);
+
+		auto bad_argument = lua.safe_script("sol.parallel_for({1, 2, 3}, 'scale', 'lots')", sol::script_pass_on_error);
+		REQUIRE_FALSE(bad_argument.valid());
+		sol::error bad_argument_error = bad_argument;
+		REQUIRE(std::string(bad_argument_error.what()).find("expects argument 3") != std::string::npos);
+
+		auto bad_element = lua.safe_script("sol.parallel_for({1, 'two', 3}, 'sum')", sol::script_pass_on_error);
+		REQUIRE_FALSE(bad_element.valid());
+		sol::error bad_element_error = bad_element;
+		REQUIRE(std::string(bad_element_error.what()).find("element 2") != std::string::npos);
+
+		auto thrown = lua.safe_script("sol.parallel_for({1, 2, 3}, 'fail')", sol::script_pass_on_error);
+		REQUIRE_FALSE(thrown.valid());
+		sol::error thrown_error = thrown;
+		REQUIRE(std::string(thrown_error.what()).find("kernel 'fail' failed: bad chunk") != std::string::npos);
+	}
+}
+
+#if SOL_IS_ON(SOL_STD_SPAN)
+TEST_CASE("parallel_for/span kernels", "kernels may take their chunk as a std::span") {
+	sol::parallel_kernels kernels(sol::default_thread_pool());
+	kernels.add("increment", [](std::span<int> chunk, int by) {
+		for (int& value : chunk) {
+			value += by;
+		}
+	});
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua["sol"] = lua.create_table_with("parallel_for", kernels.lua_function());
+	std::vector<int> values(300, 1);
+	lua["values"] = &values;
+	auto result = lua.safe_script("sol.parallel_for(values, 'increment', 4)", sol::script_pass_on_error);
+	REQUIRE(result.valid());
+	for (int value : values) {
+		REQUIRE(value == 5);
+	}
+}
+#endif
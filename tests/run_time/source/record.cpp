@@ -0,0 +1,183 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace {
+	struct particle {
+		float x;
+		float y;
+		std::int32_t id;
+		bool alive;
+		double mass;
+	};
+} // namespace
+
+TEST_CASE("record/schema", "schemas lay fields out like a C struct, or take a struct's layout") {
+	sol::record_schema packed("packed");
+	packed.add<std::uint8_t>("tag").add<double>("value").add<std::int16_t>("count");
+	REQUIRE(packed.fields().size() == 3);
+	REQUIRE(packed.find("tag")->offset == 0);
+	REQUIRE(packed.find("value")->offset == 8);
+	REQUIRE(packed.find("count")->offset == 16);
+	REQUIRE(packed.size() == 24);
+	REQUIRE(packed.alignment() == 8);
+	REQUIRE(packed.find("nope") == nullptr);
+
+	sol::record_schema described = sol::record_schema::of<particle>(
+	     "particle", "x", &particle::x, "y", &particle::y, "id", &particle::id, "alive", &particle::alive, "mass", &particle::mass);
+	REQUIRE(described.size() == sizeof(particle));
+	REQUIRE(described.find("id")->offset == offsetof(particle, id));
+	REQUIRE(described.find("mass")->offset == offsetof(particle, mass));
+	REQUIRE(described.find("alive")->type == sol::record_field_type::boolean);
+	REQUIRE(described.is<particle>());
+	REQUIRE_FALSE(packed.is<particle>());
+}
+
+TEST_CASE("record/cpp schema", "records made from a C++ struct are used as that struct from C++") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	sol::record_type particles(lua,
+	     sol::record_schema::of<particle>(
+	          "particle", "x", &particle::x, "y", &particle::y, "id", &particle::id, "alive", &particle::alive, "mass", &particle::mass));
+	lua["particle"] = particles.class_table();
+	lua.set_function("advance", [](sol::record_view<particle> p, float dt) {
+		p->x += dt;
+		p->y -= dt;
+		return p;
+	});
+
+	auto result = lua.safe_script(R"(
+		local p = particle.new { x = 1.5, id = 7, alive = true }
+		assert(p.y == 0 and p.mass == 0)
+		p.mass = 2.25
+		local q = advance(p, 0.5)
+		assert(q == p)
+		function particle.energy(self) return self.mass * 2 end
+		return p, p.x, p.y, p.id, p.alive, p:energy(), particle.size, #particle.fields
+	)",
+	     sol::script_pass_on_error);
+	REQUIRE(result.valid());
+	sol::record_view<particle> p = result[0];
+	REQUIRE(p.valid());
+	REQUIRE(p->x == 2.0f);
+	REQUIRE(p->y == -0.5f);
+	REQUIRE(p->id == 7);
+	REQUIRE(p->alive);
+	REQUIRE(p->mass == 2.25);
+	REQUIRE(result.get<float>(1) == 2.0f);
+	REQUIRE(result.get<float>(2) == -0.5f);
+	REQUIRE(result.get<int>(3) == 7);
+	REQUIRE(result.get<bool>(4));
+	REQUIRE(result.get<double>(5) == 4.5);
+	REQUIRE(result.get<std::size_t>(6) == sizeof(particle));
+	REQUIRE(result.get<int>(7) == 5);
+
+	sol::record_view<particle> made = particles.create<particle>();
+	made->id = 42;
+	made->x = 3.0f;
+	lua["made"] = made;
+	auto read = lua.safe_script("return made.id, made.x, made.alive", sol::script_pass_on_error);
+	REQUIRE(read.valid());
+	REQUIRE(read.get<int>(0) == 42);
+	REQUIRE(read.get<float>(1) == 3.0f);
+	REQUIRE_FALSE(read.get<bool>(2));
+	REQUIRE(made.get<int>("id") == 42);
+
+	SECTION("errors") {
+		auto unknown = lua.safe_script("made.z = 1", sol::script_pass_on_error);
+		REQUIRE_FALSE(unknown.valid());
+		sol::error unknown_error = unknown;
+		REQUIRE(std::string(unknown_error.what()).find("record 'particle' has no field 'z'") != std::string::npos);
+		auto mistyped = lua.safe_script("made.id = 1.5", sol::script_pass_on_error);
+		REQUIRE_FALSE(mistyped.valid());
+		sol::error mistyped_error = mistyped;
+		REQUIRE(std::string(mistyped_error.what()).find("'particle.id' expects i32, got number") != std::string::npos);
+		auto bad_new = lua.safe_script("particle.new { alive = 1 }", sol::script_pass_on_error);
+		REQUIRE_FALSE(bad_new.valid());
+		auto not_a_record = lua.safe_script("advance({}, 1)", sol::script_pass_on_error);
+		REQUIRE_FALSE(not_a_record.valid());
+	}
+}
+
+TEST_CASE("record/lua schema", "scripts can define record types at load time") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua["define_record"] = sol::record_type::lua_define();
+	lua.set_function("heal", [](sol::record_view<> r, int amount) { r.set("hp", r.get<int>("hp") + amount); });
+
+	auto result = lua.safe_script(R"(
+		local monster = define_record("monster", { { "hp", "u16" }, { "level", "u8" }, { "speed", "f32" }, { "boss", "bool" } })
+		local m = monster.new { hp = 100, level = 3, speed = 1.25 }
+		heal(m, 25)
+		m.level = 258
+		return m, m.hp, m.level, monster.size
+	)",
+	     sol::script_pass_on_error);
+	REQUIRE(result.valid());
+	sol::record_view<> m = result[0];
+	REQUIRE(m.schema().name() == "monster");
+	REQUIRE(m.get<int>("hp") == 125);
+	REQUIRE(result.get<int>(1) == 125);
+	REQUIRE(result.get<int>(2) == 2);
+	REQUIRE(result.get<int>(3) == 12);
+	REQUIRE(m.get<float>("speed") == 1.25f);
+	REQUIRE_FALSE(m.get<bool>("boss"));
+	auto as_particle = result.get<sol::optional<sol::record_view<particle>>>(0);
+	REQUIRE_FALSE(as_particle.has_value());
+
+	auto bad = lua.safe_script("define_record('broken', { { 'x', 'quaternion' } })", sol::script_pass_on_error);
+	REQUIRE_FALSE(bad.valid());
+	sol::error bad_error = bad;
+	REQUIRE(std::string(bad_error.what()).find("field #1 must be { name, type }") != std::string::npos);
+}
+
+TEST_CASE("record/schema lifetime", "records keep their schema alive after the class table lets go of it") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua["define_record"] = sol::record_type::lua_define();
+
+	auto result = lua.safe_script(R"(
+		local P = define_record("Point", { { "x", "i32" } })
+		p = P.new { x = 7 }
+		P.new = nil
+		P = nil
+		collectgarbage()
+		collectgarbage()
+		local ok, err = pcall(function() p.y = 1 end)
+		return tostring(p), p.x, ok, err
+	)",
+	     sol::script_pass_on_error);
+	REQUIRE(result.valid());
+	REQUIRE(result.get<std::string>(0).find("Point: ") == 0);
+	REQUIRE(result.get<int>(1) == 7);
+	REQUIRE_FALSE(result.get<bool>(2));
+	REQUIRE(result.get<std::string>(3).find("record 'Point' has no field 'y'") != std::string::npos);
+	sol::record_view<> p = lua["p"];
+	REQUIRE(p.schema().name() == "Point");
+}
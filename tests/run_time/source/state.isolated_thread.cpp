@@ -0,0 +1,141 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <string>
+
+namespace {
+	struct isolated_counter {
+		int value = 0;
+	};
+} // namespace
+
+TEST_CASE("state/isolated_thread", "requests run on a reused thread with their own globals over a shared state") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::string);
+	lua.new_usertype<isolated_counter>("isolated_counter", "value", &isolated_counter::value);
+	lua.script("shared_value = 24 function twice(x) return x * 2 end");
+
+	sol::isolated_thread request(lua);
+	REQUIRE(request.lua_state() == lua.lua_state());
+	REQUIRE(request.thread_state() != lua.lua_state());
+
+	SECTION("reads fall through, writes stay in the request") {
+		{
+			auto result = request.safe_script(R"(
+leaked = "request 1"
+shared_value = 0
+local c = isolated_counter.new()
+c.value = twice(21)
+return c.value, string.upper("ok")
+)",
+			     sol::script_pass_on_error);
+			REQUIRE(result.valid());
+			int value = result[0];
+			std::string upper = result[1];
+			REQUIRE(value == 42);
+			REQUIRE(upper == "OK");
+			std::string seen = request.env()["leaked"];
+			REQUIRE(seen == "request 1");
+		}
+		REQUIRE_FALSE(lua["leaked"].valid());
+		REQUIRE(lua["shared_value"].get<int>() == 24);
+
+		request.reset();
+		REQUIRE(request.resets() == 1);
+		auto result = request.safe_script("return leaked, shared_value", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE_FALSE(result.get<sol::object>(0).valid());
+		REQUIRE(result.get<int>(1) == 24);
+	}
+	SECTION("writes through _G stay in the request") {
+		{
+			auto result = request.safe_script(R"(
+_G.through_g = 1
+rawset(_G, "through_rawset", 2)
+return _G.shared_value, _G.twice(3)
+)",
+			     sol::script_pass_on_error);
+			REQUIRE(result.valid());
+			REQUIRE(result.get<int>(0) == 24);
+			REQUIRE(result.get<int>(1) == 6);
+			REQUIRE(request.env()["through_g"].get<int>() == 1);
+			REQUIRE(request.env()["through_rawset"].get<int>() == 2);
+		}
+		REQUIRE_FALSE(lua["through_g"].valid());
+		REQUIRE_FALSE(lua["through_rawset"].valid());
+
+		request.reset();
+		auto result = request.safe_script("return through_g, through_rawset, _G.through_g", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE_FALSE(result.get<sol::object>(0).valid());
+		REQUIRE_FALSE(result.get<sol::object>(1).valid());
+		REQUIRE_FALSE(result.get<sol::object>(2).valid());
+	}
+	SECTION("the shared metatable cannot be reached") {
+		{
+			auto result = request.safe_script(R"(
+local hidden = getmetatable(_G)
+local swapped = pcall(setmetatable, _G, { __index = { print = print } })
+local tampered = pcall(function() getmetatable(_G).__index.leaked = 42 end)
+return hidden, swapped, tampered
+)",
+			     sol::script_pass_on_error);
+			REQUIRE(result.valid());
+			REQUIRE(result.get<bool>(0) == false);
+			REQUIRE(result.get<bool>(1) == false);
+			REQUIRE(result.get<bool>(2) == false);
+		}
+		REQUIRE_FALSE(lua["leaked"].valid());
+
+		request.reset();
+		auto result = request.safe_script("return type(twice), leaked", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<std::string>(0) == "function");
+		REQUIRE_FALSE(result.get<sol::object>(1).valid());
+	}
+	SECTION("errors do not spoil the thread") {
+		{
+			auto result = request.safe_script("error('request failed')", sol::script_pass_on_error);
+			REQUIRE_FALSE(result.valid());
+			sol::error err = result;
+			REQUIRE(std::string(err.what()).find("request failed") != std::string::npos);
+		}
+		request.reset();
+		auto result = request.safe_script("return twice(4)", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>() == 8);
+	}
+	SECTION("custom shared table") {
+		sol::table sandbox = lua.create_table_with("twice", lua["twice"]);
+		sol::isolated_thread sandboxed(lua, sandbox);
+		auto result = sandboxed.safe_script("return twice(5), shared_value, print", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>(0) == 10);
+		REQUIRE_FALSE(result.get<sol::object>(1).valid());
+		REQUIRE_FALSE(result.get<sol::object>(2).valid());
+	}
+}
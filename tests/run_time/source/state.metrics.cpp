@@ -0,0 +1,213 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <memory>
+#include <string>
+
+namespace {
+	struct metrics_widget {
+		int value = 0;
+	};
+
+	struct metrics_gadget {
+		int value = 0;
+	};
+
+	struct metrics_disposable {
+		int value = 0;
+	};
+
+	const sol::usertype_metrics* find_usertype(const sol::state_metrics& metrics, const std::string& name) {
+		for (const sol::usertype_metrics& usertype : metrics.usertypes) {
+			if (usertype.name == name) {
+				return &usertype;
+			}
+		}
+		return nullptr;
+	}
+
+	std::int64_t live_objects(const sol::state_view& lua, const std::string& name) {
+		sol::state_metrics metrics = lua.metrics();
+		const sol::usertype_metrics* usertype = find_usertype(metrics, name);
+		return usertype == nullptr ? 0 : usertype->live;
+	}
+} // namespace
+
+namespace sol {
+	template <>
+	struct is_disposable<metrics_disposable> : std::true_type { };
+} // namespace sol
+
+TEST_CASE("state/metrics", "the snapshot reflects the state it was taken from") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::coroutine);
+
+	SECTION("heap and collector") {
+		sol::state_metrics metrics = lua.metrics();
+		REQUIRE(metrics.heap_bytes > 0);
+		REQUIRE(metrics.gc_running);
+		lua.adjust_external_memory(4096);
+		REQUIRE(lua.metrics().external_bytes == 4096);
+		lua.adjust_external_memory(-4096);
+
+		std::uint64_t cycles = lua.metrics().gc_cycles;
+		std::uint64_t steps = lua.metrics().gc_steps;
+		lua.collect_garbage();
+		lua.collect_garbage();
+		metrics = lua.metrics();
+		REQUIRE(metrics.gc_cycles >= cycles + 2);
+		REQUIRE(metrics.gc_steps == steps + 2);
+		REQUIRE(metrics.gc_step_seconds > 0.0);
+
+		lua.stop_gc();
+		REQUIRE_FALSE(lua.metrics().gc_running);
+		lua.restart_gc();
+	}
+	SECTION("registry references") {
+		std::size_t before = lua.metrics().registry_references;
+		{
+			sol::table a = lua.create_table();
+			sol::table b = lua.create_table();
+			REQUIRE(lua.metrics().registry_references == before + 2);
+		}
+		REQUIRE(lua.metrics().registry_references == before);
+		sol::table c = lua.create_table();
+		REQUIRE(lua.metrics().registry_references == before + 1);
+	}
+	SECTION("live usertypes") {
+		const std::string widget = sol::detail::demangle<metrics_widget>();
+		lua.new_usertype<metrics_widget>("widget");
+		lua.collect_garbage();
+		std::int64_t before = live_objects(lua, widget);
+		lua.safe_script("widgets = {} for i = 1, 10 do widgets[i] = widget.new() end");
+		REQUIRE(live_objects(lua, widget) == before + 10);
+		lua["extra"] = metrics_widget {};
+		REQUIRE(live_objects(lua, widget) == before + 11);
+		lua.safe_script("widgets = nil extra = nil");
+		lua.collect_garbage();
+		REQUIRE(live_objects(lua, widget) == before);
+
+		const sol::usertype_metrics* usertype = find_usertype(lua.metrics(), widget);
+		REQUIRE(usertype != nullptr);
+		REQUIRE(usertype->created >= 11);
+	}
+	SECTION("unique usertypes") {
+		const std::string gadget = sol::detail::demangle<metrics_gadget>();
+		lua.collect_garbage();
+		std::int64_t before = live_objects(lua, gadget);
+		lua["g"] = std::make_unique<metrics_gadget>();
+		lua["h"] = std::make_shared<metrics_gadget>();
+		REQUIRE(live_objects(lua, gadget) == before + 2);
+		lua["g"] = sol::lua_nil;
+		lua["h"] = sol::lua_nil;
+		lua.collect_garbage();
+		REQUIRE(live_objects(lua, gadget) == before);
+	}
+	SECTION("disposed usertypes are counted once") {
+		const std::string disposable = sol::detail::demangle<metrics_disposable>();
+		lua.new_usertype<metrics_disposable>("disposable");
+		lua.collect_garbage();
+		std::int64_t before = live_objects(lua, disposable);
+		lua.safe_script("d = disposable.new()");
+		REQUIRE(live_objects(lua, disposable) == before + 1);
+		lua.safe_script("d:dispose() d:dispose()");
+		REQUIRE(live_objects(lua, disposable) == before);
+		lua.safe_script("d = nil");
+		lua.collect_garbage();
+		REQUIRE(live_objects(lua, disposable) == before);
+	}
+	SECTION("calls, closures and coroutines") {
+		sol::state_metrics before = lua.metrics();
+		lua.set_function("f", [](int x) { return x + 1; });
+		lua.set_function("g", [](int x) { return x * 2; });
+		sol::state_metrics after = lua.metrics();
+		REQUIRE(after.closures_created >= before.closures_created + 2);
+
+		sol::protected_function fails = lua.safe_script("return function () error('nope') end");
+		sol::protected_function works = lua["f"];
+		REQUIRE(works(1).valid());
+		REQUIRE_FALSE(fails().valid());
+		REQUIRE_FALSE(fails().valid());
+		after = lua.metrics();
+		REQUIRE(after.protected_call_errors == before.protected_call_errors + 2);
+
+		sol::thread runner = sol::thread::create(lua);
+		sol::state_view runner_state = runner.state();
+		sol::coroutine co = runner_state.safe_script("return function () coroutine.yield() error('done') end");
+		REQUIRE(co().valid());
+		REQUIRE_FALSE(co().valid());
+		after = lua.metrics();
+		REQUIRE(after.threads_created == before.threads_created + 1);
+		REQUIRE(after.coroutine_resumes == before.coroutine_resumes + 2);
+		REQUIRE(after.coroutine_errors == before.coroutine_errors + 1);
+	}
+	SECTION("plain states are tracked from their first snapshot") {
+		lua_State* L = luaL_newstate();
+		{
+			sol::state_view view(L);
+			REQUIRE(view.metrics().gc_cycles == 0);
+			view.collect_garbage();
+			sol::state_metrics metrics = view.metrics();
+			REQUIRE(metrics.gc_cycles >= 1);
+			REQUIRE(metrics.gc_steps == 1);
+		}
+		lua_close(L);
+	}
+}
+
+TEST_CASE("state/metrics openmetrics", "snapshots format as OpenMetrics text") {
+	sol::state_metrics metrics;
+	metrics.heap_bytes = 2048;
+	metrics.gc_running = true;
+	metrics.gc_cycles = 3;
+	metrics.gc_step_seconds = 0.25;
+	metrics.protected_call_errors = 7;
+	metrics.usertypes.push_back(sol::usertype_metrics { "ns::\"odd\"\\type", 4, 9 });
+
+	std::string text = sol::to_openmetrics(metrics, "game");
+	REQUIRE(text.find("# TYPE game_heap_bytes gauge\n# UNIT game_heap_bytes bytes\n# HELP game_heap_bytes ") != std::string::npos);
+	REQUIRE(text.find("\ngame_heap_bytes 2048\n") != std::string::npos);
+	REQUIRE(text.find("\ngame_gc_running 1\n") != std::string::npos);
+	REQUIRE(text.find("# TYPE game_gc_cycles counter\n") != std::string::npos);
+	REQUIRE(text.find("\ngame_gc_cycles_total 3\n") != std::string::npos);
+	REQUIRE(text.find("\ngame_gc_step_seconds_total 0.25\n") != std::string::npos);
+	REQUIRE(text.find("\ngame_protected_call_errors_total 7\n") != std::string::npos);
+	REQUIRE(text.find("\ngame_usertype_live_objects{type=\"ns::\\\"odd\\\"\\\\type\"} 4\n") != std::string::npos);
+	REQUIRE(text.find("\ngame_usertype_allocations_total{type=\"ns::\\\"odd\\\"\\\\type\"} 9\n") != std::string::npos);
+	REQUIRE(text.size() > 6);
+	REQUIRE(text.compare(text.size() - 6, 6, "# EOF\n") == 0);
+
+	std::string labelled = sol::to_openmetrics(metrics, "sol", "state=\"ai\"");
+	REQUIRE(labelled.find("\nsol_heap_bytes{state=\"ai\"} 2048\n") != std::string::npos);
+	REQUIRE(labelled.find("\nsol_gc_cycles_total{state=\"ai\"} 3\n") != std::string::npos);
+	REQUIRE(labelled.find("\nsol_usertype_live_objects{state=\"ai\",type=") != std::string::npos);
+
+	sol::state lua;
+	std::string live = sol::to_openmetrics(lua.metrics());
+	REQUIRE(live.find("\nsol_heap_bytes ") != std::string::npos);
+}
@@ -0,0 +1,151 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#if SOL_IS_ON(SOL_STD_FILESYSTEM)
+#include <filesystem>
+#endif
+
+namespace {
+	void write_package_file(const std::string& filename, const std::string& code) {
+		std::ofstream file(filename, std::ios::out | std::ios::trunc);
+		file << code << '\n';
+	}
+} // namespace
+
+TEST_CASE("state/package_index", "require resolves through the index, and probing results are cached") {
+	write_package_file("./tmp_pkgidx_alpha.lua", "#!/usr/bin/env lua\nlocal name, path = ...\nreturn { name = name, path = path, value = 11 }");
+	write_package_file("./tmp_pkgidx_probed.lua", "return 22");
+	write_package_file("./tmp_pkgidx.manifest", "# name path\nmanifest.alpha tmp_pkgidx_alpha.lua\n\n  manifest.probed   tmp_pkgidx_probed.lua  # trailing\n");
+
+	sol::package_index index;
+	REQUIRE(index.add_module("alpha", "./tmp_pkgidx_alpha.lua"));
+	REQUIRE_FALSE(index.add_module("alpha", "./elsewhere.lua"));
+	REQUIRE(index.add_manifest("./tmp_pkgidx.manifest") == 2);
+	REQUIRE(index.add_manifest("./tmp_pkgidx_no_such.manifest") == 0);
+	REQUIRE(index.size() == 3);
+	REQUIRE(*index.resolve("manifest.probed") == "./tmp_pkgidx_probed.lua");
+	index.set_search_path("./tmp_pkgidx_?.lua;./tmp_pkgidx_?/init.lua");
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::package);
+	REQUIRE(index.install(lua));
+
+	SECTION("indexed modules") {
+		auto result = lua.safe_script("local m = require('alpha') return m.value, m.name, m.path", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		int value = result[0];
+		std::string name = result[1];
+		std::string path = result[2];
+		REQUIRE(value == 11);
+		REQUIRE(name == "alpha");
+		REQUIRE(path == "./tmp_pkgidx_alpha.lua");
+		REQUIRE(index.probes() == 0);
+	}
+	SECTION("probed modules are found once") {
+		sol::state other;
+		other.open_libraries(sol::lib::base, sol::lib::package);
+		REQUIRE(index.install(other));
+		auto result = lua.safe_script("return require('probed')", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>() == 22);
+		std::size_t probes = index.probes();
+		REQUIRE(probes == 1);
+		auto other_result = other.safe_script("return require('probed')", sol::script_pass_on_error);
+		REQUIRE(other_result.valid());
+		REQUIRE(other_result.get<int>() == 22);
+		REQUIRE(index.probes() == probes);
+	}
+	SECTION("misses are cached") {
+		REQUIRE_FALSE(index.resolve("tmp.missing").has_value());
+		std::size_t probes = index.probes();
+		REQUIRE(probes == 2);
+		auto result = lua.safe_script("return pcall(require, 'tmp.missing')", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		bool ok = result[0];
+		std::string message = result[1];
+		REQUIRE_FALSE(ok);
+		REQUIRE(message.find("no indexed module 'tmp.missing'") != std::string::npos);
+		REQUIRE(index.probes() == probes);
+		REQUIRE(index.misses() >= 2);
+		index.clear_cache();
+		REQUIRE_FALSE(index.resolve("tmp.missing").has_value());
+		REQUIRE(index.probes() == probes * 2);
+	}
+	SECTION("require from C++") {
+		sol::object m = index.require(lua, "manifest.alpha");
+		REQUIRE(m.is<sol::table>());
+		REQUIRE(m.as<sol::table>().get<int>("value") == 11);
+		int global_value = lua["manifest.alpha"]["value"];
+		REQUIRE(global_value == 11);
+		auto result = lua.safe_script("return require('manifest.alpha') == _G['manifest.alpha']", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<bool>());
+	}
+
+	std::remove("./tmp_pkgidx_alpha.lua");
+	std::remove("./tmp_pkgidx_probed.lua");
+	std::remove("./tmp_pkgidx.manifest");
+}
+
+#if SOL_IS_ON(SOL_STD_FILESYSTEM)
+TEST_CASE("state/package_index directories", "a directory walk maps files to module names") {
+	namespace fs = std::filesystem;
+	fs::path root = "./tmp_pkgidx_tree";
+	fs::create_directories(root / "game" / "ai");
+	fs::create_directories(root / "util");
+	write_package_file((root / "game" / "init.lua").string(), "return 'game'");
+	write_package_file((root / "game" / "ai" / "planner.lua").string(), "return 'game.ai.planner'");
+	write_package_file((root / "util.lua").string(), "return 'util'");
+	write_package_file((root / "util" / "init.lua").string(), "return 'util/init'");
+	write_package_file((root / "notes.txt").string(), "not a module");
+
+	sol::package_index index;
+	REQUIRE(index.add_directory(root.string()) == 3);
+	REQUIRE(index.contains("game"));
+	REQUIRE(index.contains("game.ai.planner"));
+	REQUIRE_FALSE(index.contains("notes"));
+	REQUIRE(index.add_directory("./tmp_pkgidx_no_such_tree") == 0);
+
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::package);
+	REQUIRE(index.install(lua));
+	auto result = lua.safe_script("return require('game'), require('game.ai.planner'), require('util')", sol::script_pass_on_error);
+	REQUIRE(result.valid());
+	std::string game = result[0];
+	std::string planner = result[1];
+	std::string util = result[2];
+	REQUIRE(game == "game");
+	REQUIRE(planner == "game.ai.planner");
+	REQUIRE(util == "util");
+	REQUIRE(index.probes() == 0);
+
+	fs::remove_all(root);
+}
+#endif
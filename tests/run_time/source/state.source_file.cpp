@@ -0,0 +1,112 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+	void write_source_file(const std::string& filename, const std::string& contents) {
+		std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		file << contents;
+	}
+} // namespace
+
+TEST_CASE("state/source_file", "files are loaded in one chunk, with luaL_loadfilex's BOM, shebang and error handling") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::string);
+
+	SECTION("BOM and shebang") {
+		write_source_file("./tmp_source_file.lua", "\xEF\xBB\xBF#!/usr/bin/env lua\nlocal x = 5\nreturn x * 2\n");
+		sol::protected_function_result result = lua.safe_script_file("./tmp_source_file.lua", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>() == 10);
+		int value = lua.script_file("./tmp_source_file.lua");
+		REQUIRE(value == 10);
+		sol::load_result loaded = lua.load_file("./tmp_source_file.lua");
+		REQUIRE(loaded.valid());
+		sol::protected_function f = loaded;
+		REQUIRE(f.call<int>() == 10);
+		sol::protected_function_result done = lua.do_file("./tmp_source_file.lua");
+		REQUIRE(done.valid());
+		REQUIRE(done.get<int>() == 10);
+	}
+	SECTION("errors name the file and keep line numbers") {
+		write_source_file("./tmp_source_file.lua", "#!/usr/bin/env lua\nlocal x = 5\nerror('boom')\n");
+		sol::protected_function_result result = lua.safe_script_file("./tmp_source_file.lua", sol::script_pass_on_error);
+		REQUIRE_FALSE(result.valid());
+		sol::error err = result;
+		std::string message = err.what();
+		REQUIRE(message.find("tmp_source_file.lua:3:") != std::string::npos);
+
+		write_source_file("./tmp_source_file.lua", "local x = = 5\n");
+		sol::load_result loaded = lua.load_file("./tmp_source_file.lua");
+		REQUIRE_FALSE(loaded.valid());
+		REQUIRE(loaded.status() == sol::load_status::syntax);
+		sol::error syntax_error = loaded;
+		std::string syntax_message = syntax_error.what();
+		REQUIRE(syntax_message.find("tmp_source_file.lua:1:") != std::string::npos);
+	}
+	SECTION("missing and empty files") {
+		std::remove("./tmp_source_file_missing.lua");
+		sol::load_result missing = lua.load_file("./tmp_source_file_missing.lua");
+		REQUIRE_FALSE(missing.valid());
+		REQUIRE(missing.status() == sol::load_status::file);
+		sol::error err = missing;
+		std::string message = err.what();
+		REQUIRE(message.find("cannot open ./tmp_source_file_missing.lua") != std::string::npos);
+
+		write_source_file("./tmp_source_file.lua", "");
+		sol::protected_function_result result = lua.safe_script_file("./tmp_source_file.lua", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.return_count() == 0);
+	}
+	SECTION("binary chunks") {
+		std::string dumped = lua.safe_script("return string.dump(function() return 42 end)");
+		write_source_file("./tmp_source_file.lua", "#!/usr/bin/env lua\n" + dumped);
+		sol::protected_function_result result = lua.safe_script_file("./tmp_source_file.lua", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>() == 42);
+		sol::load_result text_only = lua.load_file("./tmp_source_file.lua", sol::load_mode::text);
+		REQUIRE_FALSE(text_only.valid());
+	}
+	SECTION("large generated data") {
+		std::string data = "local t = {\n";
+		for (int i = 0; i < 100000; ++i) {
+			data += "\t{ id = " + std::to_string(i) + ", name = \"entry\" },\n";
+		}
+		data += "}\nreturn #t, t[100000].id\n";
+		write_source_file("./tmp_source_file.lua", data);
+		sol::protected_function_result result = lua.safe_script_file("./tmp_source_file.lua", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		int count = result[0];
+		int last = result[1];
+		REQUIRE(count == 100000);
+		REQUIRE(last == 99999);
+	}
+	std::remove("./tmp_source_file.lua");
+}
@@ -0,0 +1,123 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+TEST_CASE("strings/lua_buffer_writer", "bound functions can write their string results directly into a Lua buffer") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::string);
+
+	lua.set_function("rep", [](std::string_view piece, int count) {
+		return sol::lua_buffer_writer([piece, count](sol::lua_buffer& out) {
+			for (int i = 0; i < count; ++i) {
+				out.write(piece);
+			}
+		});
+	});
+	lua.set_function("bytes", [](std::size_t count) {
+		return sol::lua_buffer_writer(count, [count](sol::lua_buffer& out) {
+			char* p = out.prepare(count);
+			for (std::size_t i = 0; i < count; ++i) {
+				p[i] = static_cast<char>(i % 7);
+			}
+			out.commit(count);
+			REQUIRE(out.size() == count);
+		});
+	});
+
+	SECTION("small") {
+		std::string result = lua.safe_script("return rep('ab', 3)");
+		REQUIRE(result == "ababab");
+		std::string empty = lua.safe_script("return rep('ab', 0)");
+		REQUIRE(empty.empty());
+	}
+	SECTION("large, with embedded zeroes") {
+		// well past LUAL_BUFFERSIZE, so the buffer moves into a box on the stack
+		std::size_t count = 1 << 20;
+		sol::protected_function f = lua["bytes"];
+		std::string big = f(count);
+		REQUIRE(big.size() == count);
+		REQUIRE(big[0] == '\0');
+		REQUIRE(big[8] == '\1');
+		REQUIRE(lua.safe_script("local s = rep('xyz', 100000) return #s, s:sub(-3)").get<std::size_t>(0) == 300000);
+	}
+	SECTION("from C++") {
+		lua["direct"] = sol::lua_buffer_writer([](sol::lua_buffer& out) {
+			out.push_back('o');
+			out.push_back('k');
+		});
+		std::string direct = lua["direct"];
+		REQUIRE(direct == "ok");
+	}
+#if SOL_IS_ON(SOL_EXCEPTIONS)
+	SECTION("errors") {
+		lua.set_function("broken", []() {
+			return sol::lua_buffer_writer([](sol::lua_buffer& out) {
+				out.write("partial", 7);
+				throw std::runtime_error("writer failed");
+			});
+		});
+		int top = lua_gettop(lua);
+		{
+			auto result = lua.safe_script("return broken()", sol::script_pass_on_error);
+			REQUIRE_FALSE(result.valid());
+		}
+		REQUIRE(lua_gettop(lua) == top);
+		std::string again = lua.safe_script("return rep('a', 2)");
+		REQUIRE(again == "aa");
+	}
+#endif
+}
+
+#if SOL_IS_ON(SOL_STD_SPAN)
+TEST_CASE("strings/byte spans", "Lua strings can be read as, and pushed from, std::span<const std::byte>") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+
+	lua.set_function("checksum", [](std::span<const std::byte> data) {
+		std::size_t sum = 0;
+		for (std::byte b : data) {
+			sum += std::to_integer<std::size_t>(b);
+		}
+		return sum;
+	});
+	REQUIRE(lua.safe_script("return checksum('\\1\\2\\0\\3')").get<std::size_t>() == 6);
+
+	auto not_a_string = lua.safe_script("return checksum({})", sol::script_pass_on_error);
+	REQUIRE_FALSE(not_a_string.valid());
+
+	std::vector<std::byte> payload { std::byte { 'h' }, std::byte { 0 }, std::byte { 'i' } };
+	lua["payload"] = std::span<const std::byte>(payload);
+	REQUIRE(lua.safe_script("return type(payload), #payload").get<std::string>(0) == "string");
+	REQUIRE(lua.safe_script("return #payload").get<std::size_t>() == 3);
+}
+#endif
@@ -0,0 +1,122 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <string>
+
+namespace {
+	const char* const kind_names[] = { "player", "monster", "projectile" };
+} // namespace
+
+TEST_CASE("strings/interned", "interned returns push the same pinned strings from a per-state cache") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.set_function("kind", [](int i) { return sol::interned(kind_names[i]); });
+	lua.set_function("label", [](int i) { return sol::interned(std::string("label ") + std::to_string(i)); });
+	lua.set_function("view", [](int i) { return sol::interned(sol::string_view(kind_names[i])); });
+	lua.set_function("nothing", []() { return sol::interned(static_cast<const char*>(nullptr)); });
+
+	SECTION("values") {
+		auto result = lua.safe_script(R"(
+			local a, b, c = kind(0), kind(1), kind(0)
+			return a, b, c, label(3), label(3), view(2), nothing() == nil
+		)",
+		     sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<std::string>(0) == "player");
+		REQUIRE(result.get<std::string>(1) == "monster");
+		REQUIRE(result.get<std::string>(2) == "player");
+		REQUIRE(result.get<std::string>(3) == "label 3");
+		REQUIRE(result.get<std::string>(4) == "label 3");
+		REQUIRE(result.get<std::string>(5) == "projectile");
+		REQUIRE(result.get<bool>(6));
+		lua["direct"] = sol::interned("direct");
+		REQUIRE(lua["direct"].get<std::string>() == "direct");
+	}
+	SECTION("stats") {
+		sol::interned_string_stats stats = sol::interned_strings_stats(lua);
+		REQUIRE(stats.entries == 0);
+		REQUIRE(stats.hits == 0);
+		lua.safe_script("for i = 1, 10 do kind(i % 3) label(1) view(0) end");
+		stats = sol::interned_strings_stats(lua);
+		// three addresses for kind, two distinct contents for label and view
+		REQUIRE(stats.entries == 5);
+		REQUIRE(stats.misses == 5);
+		REQUIRE(stats.hits == 25);
+		REQUIRE(stats.rejected == 0);
+		REQUIRE(stats.bytes == std::string("playermonsterprojectilelabel 1player").size());
+	}
+	SECTION("pinned strings are registry references") {
+		std::size_t before = lua.metrics().registry_references;
+		lua.safe_script("kind(0) kind(1) label(7)");
+		REQUIRE(lua.metrics().registry_references == before + 3);
+		sol::clear_interned_strings(lua);
+		REQUIRE(lua.metrics().registry_references == before);
+		sol::interned_string_stats stats = sol::interned_strings_stats(lua);
+		REQUIRE(stats.entries == 0);
+		REQUIRE(stats.bytes == 0);
+		REQUIRE(stats.misses == 3);
+		lua.safe_script("assert(kind(0) == 'player')");
+		REQUIRE(sol::interned_strings_stats(lua).entries == 1);
+	}
+	SECTION("bounded") {
+		sol::set_interned_string_limits(lua, 2, 1024);
+		auto result = lua.safe_script("local out = {} for i = 1, 5 do out[i] = label(i) end return out[5], label(1), label(5)", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<std::string>(0) == "label 5");
+		REQUIRE(result.get<std::string>(2) == "label 5");
+		sol::interned_string_stats stats = sol::interned_strings_stats(lua);
+		REQUIRE(stats.entries == 2);
+		REQUIRE(stats.max_entries == 2);
+		REQUIRE(stats.hits == 1);
+		REQUIRE(stats.rejected == 4);
+
+		sol::clear_interned_strings(lua);
+		sol::set_interned_string_limits(lua, 100, 10);
+		lua.safe_script("label(1) label(2)");
+		stats = sol::interned_strings_stats(lua);
+		REQUIRE(stats.entries == 1);
+		REQUIRE(stats.bytes == 7);
+	}
+	SECTION("each state has its own cache") {
+		lua.safe_script("kind(0)");
+		{
+			sol::state other;
+			other.open_libraries(sol::lib::base);
+			other.set_function("kind", [](int i) { return sol::interned(kind_names[i]); });
+			other.safe_script("assert(kind(0) == 'player') assert(kind(0) == 'player')");
+			REQUIRE(sol::interned_strings_stats(other).hits == 1);
+			lua.safe_script("assert(kind(0) == 'player')");
+		}
+		sol::state third;
+		third.open_libraries(sol::lib::base);
+		third.set_function("kind", [](int i) { return sol::interned(kind_names[i]); });
+		third.safe_script("assert(kind(1) == 'monster')");
+		REQUIRE(sol::interned_strings_stats(third).entries == 1);
+		REQUIRE(sol::interned_strings_stats(lua).hits == 1);
+	}
+}
@@ -0,0 +1,163 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+#if SOL_IS_ON(SOL_STD_SPAN)
+#include <ranges>
+#endif
+
+TEST_CASE("tables/sequence_view", "read the array part of a table through a random-access view") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+
+	auto result = lua.safe_script(R"(
+sorted = { 1, 3, 5, 7, 9, 11, 13 }
+names = { "a", "b", "c" }
+holes = { 1, 2, nil, 4 }
+)",
+	     sol::script_pass_on_error);
+	REQUIRE(result.valid());
+
+	SECTION("from a reference") {
+		sol::stack_guard luasg(lua);
+		sol::table sorted = lua["sorted"];
+		sol::sequence_view<int> view(sorted);
+		REQUIRE(view.size() == 7);
+		REQUIRE_FALSE(view.empty());
+		REQUIRE(view[0] == 1);
+		REQUIRE(view.front() == 1);
+		REQUIRE(view.back() == 13);
+		REQUIRE(std::accumulate(view.begin(), view.end(), 0) == 49);
+		REQUIRE(std::binary_search(view.begin(), view.end(), 9));
+		REQUIRE_FALSE(std::binary_search(view.begin(), view.end(), 8));
+		auto it = std::lower_bound(view.begin(), view.end(), 6);
+		REQUIRE(*it == 7);
+		REQUIRE(it - view.begin() == 3);
+		REQUIRE(it.lua_index() == 4);
+		std::vector<int> tail(view.begin() + 5, view.end());
+		REQUIRE(tail == std::vector<int> { 11, 13 });
+		std::vector<int> reversed(view.rbegin(), view.rend());
+		REQUIRE(reversed.front() == 13);
+		REQUIRE(reversed.back() == 1);
+	}
+	SECTION("function argument") {
+		sol::stack_guard luasg(lua);
+		lua.set_function("median", [](sol::sequence_view<double> values) {
+			if (values.empty()) {
+				return 0.0;
+			}
+			return values[values.size() / 2];
+		});
+		lua.set_function("count_of", [](sol::sequence_view<std::string> values, const std::string& which) {
+			return std::count(values.begin(), values.end(), which);
+		});
+		REQUIRE(lua.safe_script("return median(sorted)").get<double>() == 7.0);
+		REQUIRE(lua.safe_script("return median({})").get<double>() == 0.0);
+		REQUIRE(lua.safe_script("return count_of(names, 'b')").get<int>() == 1);
+		auto not_a_table = lua.safe_script("return median(2)", sol::script_pass_on_error);
+		REQUIRE_FALSE(not_a_table.valid());
+	}
+	SECTION("border and lifetime") {
+		sol::stack_guard luasg(lua);
+		sol::table names = lua["names"];
+		int top = lua_gettop(lua);
+		{
+			sol::sequence_view<std::string> view(names);
+			REQUIRE(lua_gettop(lua) == top + 1);
+			sol::sequence_view<std::string> moved(std::move(view));
+			REQUIRE(moved.size() == 3);
+			names.add("d");
+			REQUIRE(moved.size() == 3);
+			moved.refresh();
+			REQUIRE(moved.size() == 4);
+			REQUIRE(moved[3] == "d");
+		}
+		REQUIRE(lua_gettop(lua) == top);
+		sol::table holes = lua["holes"];
+		sol::sequence_view<sol::object> view(holes);
+		REQUIRE((view.size() == 4 || view.size() == 2));
+	}
+	SECTION("reassignment") {
+		sol::stack_guard luasg(lua);
+		sol::table sorted = lua["sorted"];
+		sol::table names = lua["names"];
+		int top = lua_gettop(lua);
+		{
+			sol::sequence_view<int> view(names);
+			view = sol::sequence_view<int>(sorted);
+			REQUIRE(lua_gettop(lua) == top + 1);
+			REQUIRE(view.stack_index() == top + 1);
+			REQUIRE(view.size() == 7);
+			REQUIRE(view[0] == 1);
+			REQUIRE(view.back() == 13);
+		}
+		REQUIRE(lua_gettop(lua) == top);
+		{
+			sol::sequence_view<std::string> view(sorted);
+			sol::sequence_view<std::string> other(names);
+			view = other;
+			REQUIRE(lua_gettop(lua) == top + 2);
+			REQUIRE(view.size() == 3);
+			REQUIRE(view[2] == "c");
+			sol::sequence_view<std::string> alias(lua, top + 2);
+			alias = other;
+			REQUIRE(alias.stack_index() == other.stack_index());
+			REQUIRE(alias[0] == "a");
+		}
+		REQUIRE(lua_gettop(lua) == top);
+		{
+			sol::sequence_view<int> owner(sorted);
+			sol::sequence_view<int> view;
+			view = std::move(owner);
+			sol::sequence_view<int> copy;
+			copy = view;
+			REQUIRE(lua_gettop(lua) == top + 1);
+			REQUIRE(copy.size() == 7);
+			REQUIRE(copy[6] == 13);
+		}
+		REQUIRE(lua_gettop(lua) == top);
+	}
+#if SOL_IS_ON(SOL_STD_SPAN)
+	SECTION("ranges") {
+		sol::stack_guard luasg(lua);
+		static_assert(std::ranges::random_access_range<sol::sequence_view<int>>);
+		static_assert(std::ranges::sized_range<sol::sequence_view<int>>);
+		sol::table sorted = lua["sorted"];
+		sol::sequence_view<int> view(sorted);
+		std::vector<int> big;
+		for (int v : view | std::views::filter([](int v) { return v > 8; }) | std::views::reverse) {
+			big.push_back(v);
+		}
+		REQUIRE(big == std::vector<int> { 13, 11, 9 });
+		REQUIRE(std::ranges::max(view) == 13);
+	}
+#endif
+}
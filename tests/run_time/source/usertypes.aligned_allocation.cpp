@@ -0,0 +1,200 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+	struct alignas(64) cache_line {
+		static int live;
+
+		float values[4];
+		std::int64_t tag;
+
+		cache_line() : values { 1.0f, 2.0f, 3.0f, 4.0f }, tag(7) {
+			++live;
+		}
+		cache_line(const cache_line& other) : tag(other.tag) {
+			for (int i = 0; i < 4; ++i) {
+				values[i] = other.values[i];
+			}
+			++live;
+		}
+		~cache_line() {
+			--live;
+		}
+
+		bool aligned() const {
+			return reinterpret_cast<std::uintptr_t>(this) % alignof(cache_line) == 0;
+		}
+	};
+
+	int cache_line::live = 0;
+
+	// an allocator sol2 cannot recognize on its own, standing in for one of the user's
+	void* own_aligned_allocate(void* ud, void* ptr, std::size_t osize, std::size_t nsize) noexcept {
+		return sol::aligned_allocator::allocate(ud, ptr, osize, nsize);
+	}
+
+	bool is_power_of_two(std::size_t value) {
+		return value != 0 && (value & (value - 1)) == 0;
+	}
+} // namespace
+
+TEST_CASE("usertypes/aligned allocator", "aligned_allocator promises only what Lua's userdata header lets it keep") {
+	sol::aligned_allocator allocator(64);
+	REQUIRE(is_power_of_two(allocator.alignment()));
+	REQUIRE(allocator.alignment() >= alignof(std::max_align_t));
+	REQUIRE(allocator.alignment() <= 64);
+	if (allocator.userdata_alignment() != 0) {
+		REQUIRE(is_power_of_two(allocator.userdata_alignment()));
+		REQUIRE(allocator.userdata_alignment() <= 64);
+	}
+
+	sol::aligned_allocator odd(48);
+	REQUIRE(odd.alignment() == alignof(std::max_align_t));
+
+	sol::state lua(sol::default_at_panic, &sol::aligned_allocator::allocate, &allocator);
+	lua.open_libraries(sol::lib::base, sol::lib::string, sol::lib::table);
+	REQUIRE(sol::userdata_alignment(lua) == allocator.userdata_alignment());
+
+	std::vector<void*> blocks;
+	for (int i = 0; i < 32; ++i) {
+		void* block = lua_newuserdata(lua, static_cast<std::size_t>(i * 24 + 1));
+		blocks.push_back(block);
+		lua_pop(lua, 1);
+	}
+	if (allocator.userdata_alignment() != 0) {
+		for (void* block : blocks) {
+			REQUIRE(reinterpret_cast<std::uintptr_t>(block) % allocator.userdata_alignment() == 0);
+		}
+	}
+	// everything else still works on the plain path
+	auto result = lua.safe_script("local t = {} for i = 1, 1000 do t[i] = ('x'):rep(i % 37) end return #t, #table.concat(t)");
+	REQUIRE(result.valid());
+	REQUIRE(result.get<int>(0) == 1000);
+}
+
+TEST_CASE("usertypes/aligned allocation", "over-aligned usertypes get exactly the space they need when the allocator promises alignment") {
+	cache_line::live = 0;
+	sol::aligned_allocator allocator(64);
+	const bool exact = allocator.userdata_alignment() >= alignof(cache_line);
+	{
+		sol::state lua(sol::default_at_panic, &sol::aligned_allocator::allocate, &allocator);
+		lua.open_libraries(sol::lib::base);
+		lua.new_usertype<cache_line>("cache_line", "tag", &cache_line::tag, "aligned", &cache_line::aligned);
+
+		lua["pushed"] = cache_line();
+		auto result = lua.safe_script("local made = cache_line.new() made.tag = 11 return made, made:aligned(), pushed:aligned()");
+		REQUIRE(result.valid());
+		cache_line& made = result.get<cache_line&>(0);
+		REQUIRE(made.tag == 11);
+		REQUIRE(made.aligned());
+		REQUIRE(result.get<bool>(1));
+		REQUIRE(result.get<bool>(2));
+
+		cache_line& pushed = lua["pushed"];
+		REQUIRE(pushed.aligned());
+		REQUIRE(pushed.values[3] == 4.0f);
+
+		sol::stack::push(lua, cache_line());
+		std::size_t size = static_cast<std::size_t>(lua_rawlen(lua, -1));
+		lua_pop(lua, 1);
+		if (exact) {
+			REQUIRE(size == alignof(cache_line) + sizeof(cache_line));
+		}
+
+		sol::state plain;
+		sol::stack::push(plain, cache_line());
+		std::size_t plain_size = static_cast<std::size_t>(lua_rawlen(plain, -1));
+		lua_pop(plain, 1);
+		REQUIRE(size <= plain_size);
+		if (exact) {
+			REQUIRE(size < plain_size);
+		}
+
+		sol::stack::push(lua, sol::make_user(cache_line()));
+		cache_line& user = sol::stack::get<sol::user<cache_line>>(lua, -1);
+		REQUIRE(user.aligned());
+		if (exact) {
+			REQUIRE(static_cast<std::size_t>(lua_rawlen(lua, -1)) == sizeof(cache_line));
+		}
+		lua_pop(lua, 1);
+		lua.collect_garbage();
+	}
+	REQUIRE(cache_line::live == 0);
+}
+
+TEST_CASE("usertypes/userdata alignment advertised", "states on other allocators can promise alignment themselves") {
+	sol::state lua;
+	REQUIRE(sol::userdata_alignment(lua) == 0);
+	sol::set_userdata_alignment(lua, 32);
+	REQUIRE(sol::userdata_alignment(lua) == 32);
+	sol::set_userdata_alignment(lua, 0);
+	REQUIRE(sol::userdata_alignment(lua) == 0);
+
+	// a promise too small for the type leaves the worst-case layout in place
+	REQUIRE(sol::set_userdata_alignment(lua, 16));
+	lua.new_usertype<cache_line>("cache_line", "aligned", &cache_line::aligned);
+	auto result = lua.safe_script("return cache_line.new():aligned()");
+	REQUIRE(result.valid());
+	REQUIRE(result.get<bool>());
+	sol::set_userdata_alignment(lua, 0);
+	REQUIRE(sol::userdata_alignment(lua) == 0);
+}
+
+TEST_CASE("usertypes/userdata alignment promised", "a promise made for an allocator skips the padding on every state it serves") {
+	sol::aligned_allocator allocator(64);
+	if (allocator.userdata_alignment() < alignof(cache_line)) {
+		// nothing to promise on this build
+		return;
+	}
+	sol::state first(sol::default_at_panic, &own_aligned_allocate, &allocator);
+	REQUIRE(sol::userdata_alignment(first) == 0);
+	sol::stack::push(first, cache_line());
+	const std::size_t padded = static_cast<std::size_t>(lua_rawlen(first, -1));
+	lua_pop(first, 1);
+	REQUIRE(padded > alignof(cache_line) + sizeof(cache_line));
+
+	REQUIRE(sol::set_userdata_alignment(first, allocator.userdata_alignment()));
+	sol::state second(sol::default_at_panic, &own_aligned_allocate, &allocator);
+	sol::state plain;
+	REQUIRE(sol::userdata_alignment(second) == allocator.userdata_alignment());
+	REQUIRE(sol::userdata_alignment(plain) == 0);
+	for (lua_State* L : { first.lua_state(), second.lua_state() }) {
+		sol::stack::push(L, cache_line());
+		REQUIRE(static_cast<std::size_t>(lua_rawlen(L, -1)) == alignof(cache_line) + sizeof(cache_line));
+		REQUIRE(sol::stack::get<cache_line&>(L, -1).aligned());
+		sol::stack::push(L, sol::make_user(cache_line()));
+		REQUIRE(static_cast<std::size_t>(lua_rawlen(L, -1)) == sizeof(cache_line));
+		REQUIRE(sol::stack::get<sol::user<cache_line>>(L, -1).aligned());
+		lua_pop(L, 2);
+	}
+	sol::set_userdata_alignment(second, 0);
+	REQUIRE(sol::userdata_alignment(first) == 0);
+}
@@ -0,0 +1,123 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <string>
+
+namespace {
+	struct bulk_base {
+		int id = 0;
+	};
+
+	struct bulk_particle : bulk_base {
+		double x = 0;
+		double y = 0;
+		double z = 0;
+		std::string name;
+		int hidden = 0;
+
+		int get_hidden() const {
+			return hidden;
+		}
+		void set_hidden(int value) {
+			hidden = value * 2;
+		}
+		double length2() const {
+			return x * x + y * y + z * z;
+		}
+	};
+} // namespace
+
+TEST_CASE("usertype/bulk access", "obj:set{} and obj:get(...) read and write many fields in one call") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<bulk_base>("bulk_base", "id", &bulk_base::id);
+	lua.new_usertype<bulk_particle>("bulk_particle",
+	     sol::base_classes,
+	     sol::bases<bulk_base>(),
+	     "x",
+	     &bulk_particle::x,
+	     "y",
+	     &bulk_particle::y,
+	     "z",
+	     &bulk_particle::z,
+	     "name",
+	     &bulk_particle::name,
+	     "hidden",
+	     sol::property(&bulk_particle::get_hidden, &bulk_particle::set_hidden),
+	     "length2",
+	     &bulk_particle::length2,
+	     "set",
+	     sol::bulk_set,
+	     "get",
+	     sol::bulk_get);
+
+	bulk_particle p;
+	lua["p"] = &p;
+
+	SECTION("set") {
+		auto result = lua.safe_script(R"(
+local same = p:set{ x = 1, y = 2, z = 3, name = "dust", hidden = 5, id = 9 }
+assert(same == p)
+)",
+		     sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(p.x == 1);
+		REQUIRE(p.y == 2);
+		REQUIRE(p.z == 3);
+		REQUIRE(p.name == "dust");
+		REQUIRE(p.hidden == 10);
+		REQUIRE(p.id == 9);
+	}
+	SECTION("get") {
+		p.x = 4;
+		p.y = 5;
+		p.name = "spark";
+		p.hidden = 7;
+		p.id = 3;
+		auto result = lua.safe_script(R"(
+local x, y, name, hidden, id, missing, l = p:get("x", "y", "name", "hidden", "id", "missing", "length2")
+assert(x == 4)
+assert(y == 5)
+assert(name == "spark")
+assert(hidden == 7)
+assert(id == 3)
+assert(missing == nil)
+assert(type(l) == "function")
+assert(select('#', p:get()) == 0)
+)",
+		     sol::script_pass_on_error);
+		REQUIRE(result.valid());
+	}
+	SECTION("errors") {
+		auto bad_value = lua.safe_script("p:set{ x = 'not a number' }", sol::script_pass_on_error);
+		REQUIRE_FALSE(bad_value.valid());
+		auto not_a_table = lua.safe_script("p:set(1)", sol::script_pass_on_error);
+		REQUIRE_FALSE(not_a_table.valid());
+		auto dot_call = lua.safe_script("p.set{ x = 1 }", sol::script_pass_on_error);
+		REQUIRE_FALSE(dot_call.valid());
+	}
+}
@@ -0,0 +1,202 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <memory>
+#include <stdexcept>
+
+namespace {
+	struct declared_point {
+		int x;
+		int y;
+
+		declared_point() : x(0), y(0) {
+		}
+		declared_point(int x_, int y_) : x(x_), y(y_) {
+		}
+
+		int sum() const {
+			return x + y;
+		}
+	};
+
+	struct declared_never_used {
+		int value = 0;
+	};
+
+	struct declared_flaky {
+		int value = 5;
+	};
+
+	bool has_metatable(sol::state& lua, const std::string& name) {
+		lua_State* L = lua.lua_state();
+		lua_getfield(L, LUA_REGISTRYINDEX, name.c_str());
+		bool found = lua_type(L, -1) != LUA_TNIL;
+		lua_pop(L, 1);
+		return found;
+	}
+
+	template <typename T>
+	bool registered(sol::state& lua) {
+		return has_metatable(lua, sol::usertype_traits<T>::metatable());
+	}
+
+	auto point_registrar(int& runs) {
+		return [&runs](sol::usertype<declared_point>& ut) {
+			++runs;
+			ut[sol::call_constructor] = sol::constructors<declared_point(), declared_point(int, int)>();
+			ut["new"] = sol::constructors<declared_point(), declared_point(int, int)>();
+			ut["x"] = &declared_point::x;
+			ut["y"] = &declared_point::y;
+			ut["sum"] = &declared_point::sum;
+		};
+	}
+} // namespace
+
+TEST_CASE("usertypes/declared", "a declared usertype is only registered once a script reaches for it") {
+	int runs = 0;
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.declare_usertype<declared_point>("point", point_registrar(runs));
+	lua.declare_usertype<declared_never_used>("never_used", [](sol::usertype<declared_never_used>& ut) { ut["value"] = &declared_never_used::value; });
+
+	REQUIRE(runs == 0);
+	REQUIRE_FALSE(registered<declared_point>(lua));
+	REQUIRE(lua["point"].get_type() == sol::type::table);
+
+	SECTION("through the placeholder's fields") {
+		auto result = lua.safe_script("local p = point.new(2, 3) return p:sum(), p.x", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>(0) == 5);
+		REQUIRE(result.get<int>(1) == 2);
+	}
+	SECTION("through a call on the placeholder") {
+		auto result = lua.safe_script("return point(4, 5):sum()", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>() == 9);
+	}
+	SECTION("through a copy of the placeholder taken beforehand") {
+		auto result = lua.safe_script(R"(
+local P = point
+function P.scaled(self, k) return self.x * k end
+local p = P.new(3, 1)
+return p:scaled(4), P.new(1, 1):sum()
+)",
+		     sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>(0) == 12);
+		REQUIRE(result.get<int>(1) == 2);
+	}
+	SECTION("by pushing a value from C++") {
+		lua["p"] = declared_point(6, 7);
+		auto result = lua.safe_script("return p:sum()", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>() == 13);
+	}
+	SECTION("by pushing a pointer from C++") {
+		declared_point p(1, 2);
+		lua["p"] = &p;
+		auto result = lua.safe_script("p.x = 10 return p:sum()", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>() == 12);
+		REQUIRE(p.x == 10);
+	}
+	SECTION("by pushing a unique pointer from C++") {
+		lua["p"] = std::make_unique<declared_point>(8, 1);
+		auto result = lua.safe_script("return p:sum()", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<int>() == 9);
+	}
+
+	REQUIRE(runs == 1);
+	REQUIRE(registered<declared_point>(lua));
+	REQUIRE_FALSE(registered<declared_never_used>(lua));
+	sol::table point = lua["point"];
+	REQUIRE(point["sum"].valid());
+
+	// later uses go straight to the real usertype
+	lua["q"] = declared_point(1, 1);
+	auto again = lua.safe_script("return point.new(1, 2):sum() + q:sum()", sol::script_pass_on_error);
+	REQUIRE(again.valid());
+	REQUIRE(again.get<int>() == 5);
+	REQUIRE(runs == 1);
+}
+
+TEST_CASE("usertypes/declared per state", "declarations and their registration belong to one state") {
+	int runs = 0;
+	sol::state first;
+	sol::state second;
+	first.declare_usertype<declared_point>("point", point_registrar(runs));
+	second.declare_usertype<declared_point>("point", point_registrar(runs));
+
+	first["p"] = declared_point(1, 2);
+	REQUIRE(runs == 1);
+	REQUIRE(registered<declared_point>(first));
+	REQUIRE_FALSE(registered<declared_point>(second));
+
+	second["p"] = declared_point(3, 4);
+	REQUIRE(runs == 2);
+	int sum = second.script("return p:sum()");
+	REQUIRE(sum == 7);
+}
+
+TEST_CASE("usertypes/declared failing registrar", "an error from the registrar reaches whoever used the type, once") {
+	int runs = 0;
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.declare_usertype<declared_flaky>("flaky", [&runs](sol::usertype<declared_flaky>& ut) {
+		++runs;
+		ut["value"] = &declared_flaky::value;
+		throw std::runtime_error("registrar failed");
+	});
+
+	// a placeholder kept from before the failure
+	lua.script("captured = flaky");
+	auto failed = lua.safe_script("return flaky.value", sol::script_pass_on_error);
+	REQUIRE_FALSE(failed.valid());
+	sol::error failed_error = failed;
+	std::string failed_message = failed_error.what();
+#if SOL_IS_ON(SOL_USE_LUAJIT)
+	// LuaJIT reports an exception that crossed its frames as "C++ exception"
+	REQUIRE((failed_message.find("registrar failed") != std::string::npos || failed_message == "C++ exception"));
+#else
+	REQUIRE(failed_message.find("registrar failed") != std::string::npos);
+#endif
+	REQUIRE(runs == 1);
+
+	// it reaches what new_usertype set up, instead of indexing a missing class table
+	auto through_captured = lua.safe_script("return captured.new().value", sol::script_pass_on_error);
+	REQUIRE(through_captured.valid());
+	REQUIRE(through_captured.get<int>() == 5);
+	REQUIRE(runs == 1);
+
+	// what the registrar set up before failing stays, as with new_usertype
+	lua["f"] = declared_flaky();
+	int value = lua.script("return f.value");
+	REQUIRE(value == 5);
+	REQUIRE(runs == 1);
+}
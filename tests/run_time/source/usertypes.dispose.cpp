@@ -0,0 +1,140 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <memory>
+
+struct disposable_resource {
+	static inline int alive = 0;
+
+	int value = 24;
+
+	disposable_resource() {
+		++alive;
+	}
+	disposable_resource(const disposable_resource& other) : value(other.value) {
+		++alive;
+	}
+	~disposable_resource() {
+		--alive;
+	}
+
+	int read() const {
+		return value;
+	}
+};
+
+namespace sol {
+	template <>
+	struct is_disposable<disposable_resource> : std::true_type { };
+} // namespace sol
+
+// close was added after the rest: the values of the existing entries must not move
+static_assert(static_cast<unsigned>(sol::meta_function::floor_division) == 20);
+static_assert(static_cast<unsigned>(sol::meta_function::close) == static_cast<unsigned>(sol::meta_function::static_new_index) + 1);
+
+TEST_CASE("usertype/dispose", "disposable usertypes can be destroyed early with dispose() or a to-be-closed variable, and error cleanly afterwards") {
+	disposable_resource::alive = 0;
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<disposable_resource>("resource", "value", &disposable_resource::value, "read", &disposable_resource::read);
+	lua.set_function("peek", [](const disposable_resource& r) { return r.value; });
+
+	SECTION("dispose") {
+		lua.safe_script("r = resource.new()");
+		REQUIRE(disposable_resource::alive == 1);
+		lua.safe_script("r:dispose()");
+		REQUIRE(disposable_resource::alive == 0);
+		// disposing twice is harmless
+		lua.safe_script("r:dispose()");
+		REQUIRE(disposable_resource::alive == 0);
+
+		auto method_result = lua.safe_script("return r:read()", sol::script_pass_on_error);
+		REQUIRE_FALSE(method_result.valid());
+		sol::error method_err = method_result;
+		REQUIRE(std::string(method_err.what()).find("disposed") != std::string::npos);
+
+		auto variable_result = lua.safe_script("return r.value", sol::script_pass_on_error);
+		REQUIRE_FALSE(variable_result.valid());
+		sol::error variable_err = variable_result;
+		REQUIRE(std::string(variable_err.what()).find("disposed") != std::string::npos);
+
+		auto argument_result = lua.safe_script("return peek(r)", sol::script_pass_on_error);
+		REQUIRE_FALSE(argument_result.valid());
+		sol::error argument_err = argument_result;
+		REQUIRE(std::string(argument_err.what()).find("disposed") != std::string::npos);
+
+		disposable_resource* p = lua["r"];
+		REQUIRE(p == nullptr);
+
+		// the collector does not destroy it again
+		lua["r"] = sol::lua_nil;
+		lua.collect_garbage();
+		REQUIRE(disposable_resource::alive == 0);
+	}
+#if SOL_LUA_VERSION_I_ >= 504
+	SECTION("to-be-closed") {
+		lua.safe_script(R"(
+held = nil
+do
+	local r <close> = resource.new()
+	held = r
+end
+)");
+		REQUIRE(disposable_resource::alive == 0);
+		auto result = lua.safe_script("return held:read()", sol::script_pass_on_error);
+		REQUIRE_FALSE(result.valid());
+	}
+#endif
+	SECTION("unique") {
+		std::shared_ptr<disposable_resource> shared = std::make_shared<disposable_resource>();
+		lua["s"] = shared;
+		lua["u"] = std::make_unique<disposable_resource>();
+		REQUIRE(disposable_resource::alive == 2);
+		lua.safe_script("s:dispose() u:dispose()");
+		// only Lua's share is released
+		REQUIRE(disposable_resource::alive == 1);
+		REQUIRE(shared.use_count() == 1);
+		std::shared_ptr<disposable_resource> released = lua["s"];
+		REQUIRE(released == nullptr);
+		lua["s"] = sol::lua_nil;
+		lua["u"] = sol::lua_nil;
+		lua.collect_garbage();
+		REQUIRE(disposable_resource::alive == 1);
+	}
+	SECTION("references") {
+		disposable_resource r;
+		lua["p"] = &r;
+		auto result = lua.safe_script("p:dispose()", sol::script_pass_on_error);
+		REQUIRE_FALSE(result.valid());
+		REQUIRE(disposable_resource::alive == 1);
+		REQUIRE(lua.safe_script("return p:read()").get<int>() == 24);
+	}
+	lua.collect_garbage();
+	REQUIRE(disposable_resource::alive == 0);
+}
@@ -0,0 +1,178 @@
+// sol2
+
+// The MIT License (MIT)
+
+// Copyright (c) 2013-2022 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "sol_test.hpp"
+
+#include <catch2/catch_all.hpp>
+
+#include <memory>
+
+namespace {
+	struct static_vec {
+		double x = 0.0;
+		double y = 0.0;
+		const int id = 7;
+
+		static_vec() = default;
+		static_vec(double x_, double y_) : x(x_), y(y_) {
+		}
+
+		double dot(const static_vec& other) const {
+			return x * other.x + y * other.y;
+		}
+
+		void scale(double k) {
+			x *= k;
+			y *= k;
+		}
+
+		bool operator==(const static_vec& other) const {
+			return x == other.x && y == other.y;
+		}
+	};
+
+	double static_vec_length_squared(const static_vec& v) {
+		return v.x * v.x + v.y * v.y;
+	}
+
+	struct static_empty { };
+} // namespace
+
+template <>
+struct sol::static_usertype<static_vec> {
+	static constexpr auto members = sol::static_members(sol::static_member { "x", &static_vec::x },
+	     sol::static_member { "y", &static_vec::y },
+	     sol::static_member { "id", &static_vec::id },
+	     sol::static_member { "dot", &static_vec::dot },
+	     sol::static_member { "scale", &static_vec::scale },
+	     sol::static_member { "length_squared", &static_vec_length_squared },
+	     sol::static_member { "new", sol::constructors<static_vec(), static_vec(double, double)>() });
+};
+
+template <>
+struct sol::static_usertype<static_empty> {
+	static constexpr auto members = sol::static_members();
+};
+
+using vec_members = sol::static_member_table<static_vec>;
+
+static_assert(sol::is_static_usertype_v<static_vec>);
+static_assert(!sol::is_static_usertype_v<int>);
+static_assert(vec_members::size() == 7);
+static_assert(vec_members::find("dot") != vec_members::npos);
+static_assert(vec_members::name(vec_members::find("scale")) == "scale");
+static_assert(vec_members::find("z") == vec_members::npos);
+static_assert(vec_members::find("") == vec_members::npos);
+static_assert(sol::static_member_table<static_empty>::find("x") == sol::static_member_table<static_empty>::npos);
+
+TEST_CASE("usertypes/static member table", "every name resolves to its own member, and nothing else resolves") {
+	for (std::size_t i = 0; i < vec_members::size(); ++i) {
+		REQUIRE(vec_members::find(vec_members::name(i)) == i);
+	}
+	REQUIRE(vec_members::find("xx") == vec_members::npos);
+	REQUIRE(vec_members::find("X") == vec_members::npos);
+
+	static_vec v(3.0, 4.0);
+	double seen = 0.0;
+	bool found = vec_members::visit("y", [&](auto member) {
+		if constexpr (std::is_member_object_pointer_v<decltype(member)>) {
+			seen = static_cast<double>(v.*member);
+		}
+	});
+	REQUIRE(found);
+	REQUIRE(seen == 4.0);
+	REQUIRE_FALSE(vec_members::visit("nope", [](auto) {}));
+}
+
+TEST_CASE("usertypes/static", "a static usertype behaves like one registered at run time") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	sol::table vec = lua.new_static_usertype<static_vec>("vec");
+	REQUIRE(vec.valid());
+
+	SECTION("construction, fields and methods from Lua") {
+		auto result = lua.safe_script(R"(
+local a = vec.new(1, 2)
+local b = vec:new(3, 4)
+a.x = 5
+a:scale(2)
+return a.x, a.y, a:dot(b), a:length_squared(), a.id, vec.new().x
+)",
+		     sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<double>(0) == 10.0);
+		REQUIRE(result.get<double>(1) == 4.0);
+		REQUIRE(result.get<double>(2) == 46.0);
+		REQUIRE(result.get<double>(3) == 116.0);
+		REQUIRE(result.get<int>(4) == 7);
+		REQUIRE(result.get<double>(5) == 0.0);
+	}
+	SECTION("values, pointers and unique pointers pushed from C++") {
+		static_vec v(1.0, 1.0);
+		lua["value"] = static_vec(2.0, 3.0);
+		lua["pointer"] = &v;
+		lua["unique"] = std::make_unique<static_vec>(4.0, 5.0);
+		auto result = lua.safe_script("pointer.x = 9 return value:dot(unique), pointer:length_squared(), value == vec.new(2, 3)", sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<double>(0) == 23.0);
+		REQUIRE(result.get<double>(1) == 82.0);
+		REQUIRE(result.get<bool>(2));
+		REQUIRE(v.x == 9.0);
+		static_vec& value = lua["value"];
+		REQUIRE(value.y == 3.0);
+		REQUIRE(lua["unique"].is<static_vec>());
+	}
+	SECTION("functions added to the class table from Lua") {
+		auto result = lua.safe_script(R"(
+function vec:sum() return self.x + self.y end
+return vec.new(2, 5):sum(), vec.dot(vec.new(1, 0), vec.new(3, 0))
+)",
+		     sol::script_pass_on_error);
+		REQUIRE(result.valid());
+		REQUIRE(result.get<double>(0) == 7.0);
+		REQUIRE(result.get<double>(1) == 3.0);
+	}
+	SECTION("errors") {
+		auto unknown = lua.safe_script("local v = vec.new() v.z = 1", sol::script_pass_on_error);
+		REQUIRE_FALSE(unknown.valid());
+		auto constant = lua.safe_script("local v = vec.new() v.id = 1", sol::script_pass_on_error);
+		REQUIRE_FALSE(constant.valid());
+		auto method = lua.safe_script("local v = vec.new() v.dot = 1", sol::script_pass_on_error);
+		REQUIRE_FALSE(method.valid());
+		auto missing = lua.safe_script("return vec.new().z", sol::script_pass_on_error);
+		REQUIRE(missing.valid());
+		REQUIRE(missing.get<sol::object>().get_type() == sol::type::lua_nil);
+	}
+}
+
+TEST_CASE("usertypes/static empty", "a static usertype with no members still gets constructed and collected") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_static_usertype<static_empty>("empty");
+	auto result = lua.safe_script("local e = empty.new() return e ~= nil", sol::script_pass_on_error);
+	REQUIRE(result.valid());
+	REQUIRE(result.get<bool>());
+	lua["e"] = static_empty();
+	REQUIRE(lua["e"].is<static_empty>());
+}